@@ -6,6 +6,7 @@
 open_project -reset mpc_dc_motor_2
 set_top hls_main
 add_files src/autogen/init_dc_motor_2.cpp -cflags "-std=c++14"
+add_files src/autogen/explicit_dc_motor_2.cpp -cflags "-std=c++14"
 add_files src/hls_generic_dense.cpp -cflags "-std=c++14"
 add_files -tb src/tb_generic_dense.cpp -cflags "-std=c++14 -Wno-unknown-pragmas" -csimflags "-Wno-unknown-pragmas"
 add_files -tb src/autogen/cosim_dc_motor_2.cpp -cflags "-std=c++14 -Wno-unknown-pragmas" -csimflags "-Wno-unknown-pragmas"
@@ -0,0 +1,338 @@
+#include "mpc/systems/hls_generic_dense.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "mpc/fixed_point.hpp"
+#include "mpc/mpc_controller.hpp"
+#include "mpc/generic_dense_init.hpp"
+#include "mpc/generic_dense_cosim.hpp"
+
+/*!
+@file   accuracy_generic_dense.cpp
+@brief  Accuracy report of the controller with fixed-point data types.
+
+Runs the closed loop of the generated system with the controller computed in T, while the plant is simulated in float.
+The control actions and states are compared against the float reference trajectory, either the cosim data linked in
+or a goldenReference.dat text file or binary trajectory file given as first argument.
+*/
+
+namespace
+{
+
+template<typename T, Solvers S, PdipAlgorithm algorithm>
+void runCase(const char *type, const char *solver, const TrajectoryView &ref)
+{
+	const auto A = Matrix<N,N>(__init_A);
+	const auto B = Matrix<N,M>(__init_B);
+	const auto model = genericDenseModel().template cast<T>();
+
+	MpcController<MpcModel<N,M,P,L,V,T,EXPLICIT_REGIONS>, S, CONSTRAINTS, false, QP_ITER, TOL, EARLY_EXIT, EXIT_TOL, algorithm> controller(model, WARM_START);
+	auto x = Matrix<N,1>(ref.x0);
+	const long samples = ref.samples;
+
+	double mse_u = 0, mse_x = 0, max_u = 0;
+	int converged = 0, infeasible = 0;
+	double iterations = 0;
+
+	for(long i = 0; i < samples; ++i)
+	{
+		Matrix<M,1,T> ut = controller.step(x.template cast<T>());
+		const PdipResult<T> &result = controller.result();
+
+		auto u = ut.template cast<float>();
+		x = A * x + B * u;
+
+		converged += result.status == PDIP_CONVERGED;
+		infeasible += result.status == PDIP_INFEASIBLE;
+		iterations += double(result.iterations) / samples;
+
+		double err_u = u.mse(ref.u(i));
+		double err_x = x.mse(ref.x(i));
+		double abs_u = std::sqrt(err_u * M);
+
+		mse_u += err_u / samples;
+		mse_x += err_x / samples;
+		max_u = abs_u > max_u ? abs_u : max_u;
+	}
+
+	std::cout << std::left << std::setw(20) << type << std::setw(10) << solver
+		<< std::setw(10) << (algorithm == PDIP_MEHROTRA ? "mehrotra" : "fixed") << std::right
+		<< std::scientific << std::setprecision(3)
+		<< std::setw(13) << mse_u << std::setw(13) << mse_x << std::setw(13) << max_u
+		<< std::setw(11) << converged << std::setw(11) << infeasible
+		<< std::fixed << std::setprecision(1) << std::setw(8) << iterations << std::endl;
+}
+
+template<typename T>
+void runType(const char *type, const TrajectoryView &ref)
+{
+	runCase<T, CHOLESKY, PDIP_FIXED_CENTERING>(type, "CHOLESKY", ref);
+	runCase<T, MINRES, PDIP_FIXED_CENTERING>(type, "MINRES", ref);
+	runCase<T, CGRAD, PDIP_FIXED_CENTERING>(type, "CGRAD", ref);
+	runCase<T, CHOLESKY, PDIP_MEHROTRA>(type, "CHOLESKY", ref);
+	runCase<T, MINRES, PDIP_MEHROTRA>(type, "MINRES", ref);
+	runCase<T, CGRAD, PDIP_MEHROTRA>(type, "CGRAD", ref);
+	runCase<T, EXPLICIT, PDIP_FIXED_CENTERING>(type, "EXPLICIT", ref);
+}
+
+/*!
+@brief  Replays the trajectory in float with a Krylov inner solver. Reports the input error and the QP and inner solver
+        iterations per step, mean and worst. With inexact, the inner tolerance and iteration limit follow the duality gap.
+*/
+template<Solvers S, PdipAlgorithm algorithm, bool inexact>
+void runKrylov(const char *solver, const TrajectoryView &ref)
+{
+	const auto A = Matrix<N,N>(__init_A);
+	const auto B = Matrix<N,M>(__init_B);
+	const auto model = genericDenseModel();
+
+	MpcController<GenericDenseModel, S, CONSTRAINTS, false, QP_ITER, TOL, EARLY_EXIT, EXIT_TOL, algorithm, inexact> controller(model, WARM_START);
+	auto x = Matrix<N,1>(ref.x0);
+	const long samples = ref.samples;
+
+	double mse_u = 0, iterations = 0, inner = 0;
+	int max_inner = 0;
+
+	for(long i = 0; i < samples; ++i)
+	{
+		Matrix<M,1> u = controller.step(x);
+		const PdipResult<float> &result = controller.result();
+
+		x = A * x + B * u;
+		mse_u += u.mse(ref.u(i)) / samples;
+		iterations += double(result.iterations) / samples;
+		inner += double(result.inner_iterations) / samples;
+		max_inner = result.inner_iterations > max_inner ? result.inner_iterations : max_inner;
+	}
+
+	std::cout << std::left << std::setw(16) << solver
+		<< std::setw(10) << (algorithm == PDIP_MEHROTRA ? "mehrotra" : "fixed")
+		<< std::setw(9) << (inexact ? "inexact" : "exact") << std::right
+		<< std::scientific << std::setprecision(3) << std::setw(13) << mse_u
+		<< std::fixed << std::setprecision(1) << std::setw(10) << iterations << std::setw(10) << inner
+		<< std::setw(10) << max_inner << std::endl;
+}
+
+//! Preconditioned Krylov solvers, the only ones with inexact Newton steps
+template<PdipAlgorithm algorithm, bool inexact>
+void runKrylovPreconditioned(const TrajectoryView &ref)
+{
+	runKrylov<MINRES_JACOBI, algorithm, inexact>("MINRES_JACOBI", ref);
+	runKrylov<MINRES_ICHOL, algorithm, inexact>("MINRES_ICHOL", ref);
+	runKrylov<CGRAD_JACOBI, algorithm, inexact>("CGRAD_JACOBI", ref);
+	runKrylov<CGRAD_ICHOL, algorithm, inexact>("CGRAD_ICHOL", ref);
+}
+
+template<PdipAlgorithm algorithm>
+void runKrylovAlgorithm(const TrajectoryView &ref)
+{
+	runKrylov<MINRES, algorithm, false>("MINRES", ref);
+	runKrylov<CGRAD, algorithm, false>("CGRAD", ref);
+	runKrylovPreconditioned<algorithm, false>(ref);
+	runKrylovPreconditioned<algorithm, true>(ref);
+}
+
+/*!
+@brief  Replays the trajectory with the configured controller, with and without solution cache. Both controllers
+        are stepped on the states of the cached closed loop, so the difference of their inputs is the cache error.
+*/
+template<int cache_size, int cache_tol>
+void runCache(const TrajectoryView &ref)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const auto A = Matrix<N,N>(__init_A);
+	const auto B = Matrix<N,M>(__init_B);
+	const auto model = genericDenseModel();
+
+	MpcController<GenericDenseModel, CHOLESKY, CONSTRAINTS, false, QP_ITER, TOL, EARLY_EXIT, EXIT_TOL, QP_ALGORITHM> plain(model, WARM_START);
+	MpcController<GenericDenseModel, CHOLESKY, CONSTRAINTS, false, QP_ITER, TOL, EARLY_EXIT, EXIT_TOL, QP_ALGORITHM, INEXACT_NEWTON, cache_size, cache_tol> cached(model, WARM_START);
+
+	auto x = Matrix<N,1>(ref.x0);
+	const long samples = ref.samples;
+
+	double plain_ns = 0, cached_ns = 0, mse_u = 0, max_du = 0;
+
+	for(long i = 0; i < samples; ++i)
+	{
+		auto t0 = Clock::now();
+		Matrix<M,1> u = cached.step(x);
+		auto t1 = Clock::now();
+		Matrix<M,1> u_plain = plain.step(x);
+		auto t2 = Clock::now();
+
+		cached_ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+		plain_ns += std::chrono::duration<double, std::nano>(t2 - t1).count();
+
+		for(int j = 0; j < M; ++j)
+		{
+			double du = std::fabs(u(j,0) - u_plain(j,0));
+			max_du = du > max_du ? du : max_du;
+		}
+
+		x = A * x + B * u;
+		mse_u += u.mse(ref.u(i)) / samples;
+	}
+
+	const auto &cache = cached.cache();
+
+	std::cout << std::left << std::setw(8) << cache_size << std::setw(10) << ("1e" + std::to_string(cache_tol)) << std::right
+		<< std::setw(10) << cache.hits() << std::setw(10) << cache.misses()
+		<< std::fixed << std::setprecision(1) << std::setw(9) << 100.0 * cache.hits() / samples
+		<< std::setw(12) << plain_ns / samples << std::setw(12) << cached_ns / samples
+		<< std::scientific << std::setprecision(3) << std::setw(13) << max_du << std::setw(13) << mse_u << std::endl;
+}
+
+//! Closed loop of the double controller: states it was stepped on and inputs it returned
+struct Replay
+{
+	std::vector<Matrix<N,1,double>> x;
+	std::vector<Matrix<M,1,double>> u;
+};
+
+/*!
+@brief  Runs the closed loop with the controller in double and CHOLESKY, the reference of the mixed precision report
+*/
+Replay doubleLoop(const TrajectoryView &ref)
+{
+	const auto A = Matrix<N,N>(__init_A).cast<double>();
+	const auto B = Matrix<N,M>(__init_B).cast<double>();
+	const auto model = genericDenseModel().cast<double>();
+
+	MpcController<MpcModel<N,M,P,L,V,double,EXPLICIT_REGIONS>, CHOLESKY, CONSTRAINTS, false, QP_ITER, TOL, EARLY_EXIT, EXIT_TOL, QP_ALGORITHM> controller(model, WARM_START);
+	Replay loop;
+	Matrix<N,1,double> x = Matrix<N,1>(ref.x0).cast<double>();
+
+	for(long i = 0; i < ref.samples; ++i)
+	{
+		Matrix<M,1,double> u = controller.step(x);
+
+		loop.x.push_back(x);
+		loop.u.push_back(u);
+		x = A * x + B * u;
+	}
+
+	return loop;
+}
+
+/*!
+@brief  Steps a controller in T on the states of the double closed loop. Reports the largest difference with the double
+        inputs, the time per step and the QP and inner iterations per step. The inner iterations of CHOLESKY_MIXED are
+        its refinement steps.
+*/
+template<typename T, Solvers S, bool inexact>
+void runMixed(const char *type, const char *solver, const Replay &loop)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const auto model = genericDenseModel().template cast<T>();
+
+	MpcController<MpcModel<N,M,P,L,V,T,EXPLICIT_REGIONS>, S, CONSTRAINTS, false, QP_ITER, TOL, EARLY_EXIT, EXIT_TOL, QP_ALGORITHM, inexact> controller(model, WARM_START);
+	const int samples = static_cast<int>(loop.x.size());
+
+	double ns = 0, max_du = 0, iterations = 0, inner = 0;
+
+	for(int i = 0; i < samples; ++i)
+	{
+		Matrix<N,1,T> x = loop.x[i].template cast<T>();
+
+		auto t0 = Clock::now();
+		Matrix<M,1,T> u = controller.step(x);
+		auto t1 = Clock::now();
+
+		const PdipResult<T> &result = controller.result();
+
+		ns += std::chrono::duration<double, std::nano>(t1 - t0).count() / samples;
+		iterations += double(result.iterations) / samples;
+		inner += double(result.inner_iterations) / samples;
+
+		for(int j = 0; j < M; ++j)
+		{
+			double du = std::fabs(double(u(j,0)) - loop.u[i](j,0));
+			max_du = du > max_du ? du : max_du;
+		}
+	}
+
+	std::cout << std::left << std::setw(8) << type << std::setw(16) << solver
+		<< std::setw(9) << (inexact ? "inexact" : "exact") << std::right
+		<< std::scientific << std::setprecision(3) << std::setw(13) << max_du
+		<< std::fixed << std::setprecision(1) << std::setw(10) << ns
+		<< std::setw(10) << iterations << std::setw(10) << inner << std::endl;
+}
+
+} // namespace
+
+/*!
+@brief  Usage: accuracy_generic_dense [goldenReference.dat | trajectory.mpct]
+*/
+int main(int argc, char **argv)
+{
+	TrajectorySource source;
+	TrajectoryView ref = cosimTrajectory();
+
+	if(argc > 1)
+	{
+		if(source.open(argv[1], N, M))
+		{
+			ref = source.view();
+		}
+		else
+		{
+			std::cerr << "Cannot read trajectory from " << argv[1] << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		if(ref.N != N || ref.M != M)
+		{
+			std::cerr << argv[1] << " is a trajectory of " << ref.N << " states and " << ref.M << " inputs" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::cout << "Samples: " << ref.samples << std::endl;
+	std::cout << std::left << std::setw(20) << "type" << std::setw(10) << "solver" << std::setw(10) << "algorithm" << std::right
+		<< std::setw(13) << "MSE_u" << std::setw(13) << "MSE_x" << std::setw(13) << "max|du|"
+		<< std::setw(11) << "converged" << std::setw(11) << "infeasible" << std::setw(8) << "QP it" << std::endl;
+
+	runType<float>("float", ref);
+	runType<FixedPoint<16, 16>>("FixedPoint<16,16>", ref);
+	runType<FixedPoint<12, 20>>("FixedPoint<12,20>", ref);
+	runType<FixedPoint<10, 22>>("FixedPoint<10,22>", ref);
+	runType<FixedPoint<12, 12>>("FixedPoint<12,12>", ref);
+
+	std::cout << std::endl << "Krylov inner solvers, float" << std::endl;
+	std::cout << std::left << std::setw(16) << "solver" << std::setw(10) << "algorithm" << std::setw(9) << "newton" << std::right
+		<< std::setw(13) << "MSE_u" << std::setw(10) << "QP it" << std::setw(10) << "inner it" << std::setw(10) << "max inner" << std::endl;
+
+	runKrylovAlgorithm<PDIP_FIXED_CENTERING>(ref);
+	runKrylovAlgorithm<PDIP_MEHROTRA>(ref);
+
+	std::cout << std::endl << "Mixed precision, against double CHOLESKY" << std::endl;
+	std::cout << std::left << std::setw(8) << "type" << std::setw(16) << "solver" << std::setw(9) << "newton" << std::right
+		<< std::setw(13) << "max|du|" << std::setw(10) << "ns/step" << std::setw(10) << "QP it" << std::setw(10) << "inner it" << std::endl;
+
+	const Replay loop = doubleLoop(ref);
+
+	runMixed<double, CHOLESKY, false>("double", "CHOLESKY", loop);
+	runMixed<double, CHOLESKY_MIXED, false>("double", "CHOLESKY_MIXED", loop);
+	runMixed<double, CHOLESKY_MIXED, true>("double", "CHOLESKY_MIXED", loop);
+	runMixed<float, CHOLESKY, false>("float", "CHOLESKY", loop);
+
+	std::cout << std::endl << "Solution cache, float " << (QP_ALGORITHM == PDIP_MEHROTRA ? "mehrotra" : "fixed") << std::endl;
+	std::cout << std::left << std::setw(8) << "size" << std::setw(10) << "bound" << std::right
+		<< std::setw(10) << "hits" << std::setw(10) << "misses" << std::setw(9) << "hit %"
+		<< std::setw(12) << "ns plain" << std::setw(12) << "ns cached"
+		<< std::setw(13) << "max|du|" << std::setw(13) << "MSE_u" << std::endl;
+
+	runCache<16, -3>(ref);
+	runCache<64, -3>(ref);
+	runCache<64, -4>(ref);
+	runCache<256, -2>(ref);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,27 @@
+#include "../mpc/generic_dense_init.hpp"
+
+// Generated by explicit_generic_dense, do not edit
+
+static_assert(MPC_EXPLICIT_REGIONS >= 9, "Set MPC_EXPLICIT_REGIONS to at least 9");
+
+const int __explicit_regions = 9;
+const float __explicit_table[MPC_EXPLICIT_REGIONS*(MPC_V*MPC_N + MPC_V + MPC_M*MPC_N + MPC_M)] = {
+	// Active set {}
+	-1.79289126,-2.06604266,0.0199784208,-1.01700342,1.79289126,2.06604266,-0.0199784208,1.01700342,100,100,100,100,-1.79289126,-2.06604266,0,
+	// Active set {0}
+	0,-1.04002559,0,0,0,1.04002559,0.879999995,1.01407015,101.114311,200,98.8856888,-49.0827332,0,0,100,
+	// Active set {1}
+	-1.79267097,-2.07725787,1.79267097,2.07725787,0,0,-0.00970432442,0.493999541,101.102768,98.8972321,200,-48.5740318,-1.79267097,-2.07725787,-1.10276413,
+	// Active set {2}
+	0,0,0,-1.04002559,0,1.04002559,-0.879999995,-1.01407015,200,98.8856888,101.114311,-49.0827332,0,0,-100,
+	// Active set {3}
+	-1.79267097,-2.07725787,0,0,1.79267097,2.07725787,0.00970432442,-0.493999541,98.8972321,200,101.102768,-48.5740318,-1.79267097,-2.07725787,1.10276413,
+	// Active set {0,1}
+	0,0,0,0,0.879999995,1.01970017,0,0.505244434,200,200,-49.6300964,-49.1213341,0,0,100,
+	// Active set {1,2}
+	0,0,0,0,0,0.505244434,-0.879999995,-1.01970017,200,200,-48.0386658,-48.5474319,0,0,-100,
+	// Active set {0,3}
+	0,0,0,0,0.879999995,1.01970017,0,-0.505244434,200,200,-48.5474319,-48.0386658,0,0,100,
+	// Active set {2,3}
+	0,0,0,0,-0.879999995,-1.01970017,0,-0.505244434,200,200,-49.6300964,-49.1213341,0,0,-100
+};
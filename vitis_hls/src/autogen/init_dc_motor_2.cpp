@@ -1,17 +1,20 @@
 #include "../mpc/generic_dense_init.hpp"
 
-const float __init_A[4] = {1.0,0.004,0.0,0.9333333333333333};
-const float __init_B[2] = {0.0,0.01};
-const float __init_Acal[8] = {1.0,0.004,0.0,0.9333333333333333,1.0,0.007733333333333333,0.0,0.8711111111111112};
-const float __init_Hcal[4] = {0.49088764444444444,0.005413333333333333,0.005413333333333333,0.4858};
-const float __init_h_base[4] = {0.8800000000000001,1.0197001481481482,0.0,0.5052444444444445};
-const float __init_Mx[8] = {1.0,0.0,0.0,1.0,-1.0,-0.0,-0.0,-1.0};
-const float __init_umin[1] = {-100};
-const float __init_umax[1] = {100};
-const float __init_xmin[2] = {0.0,0.0};
-const float __init_xmax[2] = {0.0,0.0};
-const float __init_Nxmin[2] = {0.0,0.0};
-const float __init_Nxmax[2] = {0.0,0.0};
-const float __init_cx[4] = {100.0,100.0,100.0,100.0};
+constexpr float __init_A[4] = {1.0,0.004,0.0,0.9333333333333333};
+constexpr float __init_B[2] = {0.0,0.01};
+constexpr float __init_Q[4] = {22000.0,0.0,0.0,58.0};
+constexpr float __init_R[1] = {0.48};
+constexpr float __init_P[4] = {22000.0,0.0,0.0,58.0};
+constexpr float __init_umin[1] = {-100};
+constexpr float __init_umax[1] = {100};
+constexpr float __init_xmin[2] = {0.0,0.0};
+constexpr float __init_xmax[2] = {0.0,0.0};
+constexpr float __init_Nxmin[2] = {0.0,0.0};
+constexpr float __init_Nxmax[2] = {0.0,0.0};
 const float __init_Lx[2] = {0.0,0.0};
 const float __init_Lu[1] = {0.0};
+
+constexpr MpcCondensed<MPC_N, MPC_M, MPC_L, MPC_V> __init_condensed = mpcCondense<MPC_CONSTRAINTS, MPC_L, MPC_V>(MpcPlant<MPC_N, MPC_M>{
+	__init_A, __init_B, __init_Q, __init_R, __init_P,
+	__init_umin, __init_umax, __init_xmin, __init_xmax, __init_Nxmin, __init_Nxmax
+});
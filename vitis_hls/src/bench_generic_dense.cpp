@@ -0,0 +1,816 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include "mpc/Matrix.hpp"
+#include "mpc/dyn_mpc.hpp"
+#include "mpc/generic_dense_defaults.hpp"
+#include "mpc/mpc_dense.hpp"
+#include "mpc/mpc_dense_batch.hpp"
+#include "mpc/mpc_sparse.hpp"
+
+/*!
+@file   bench_generic_dense.cpp
+@brief  Host benchmark for Matrix kernels, inner linear solvers, pdip and mpc_dense.
+
+Every case is built from a synthetic, stable plant of size (N, M) condensed over a horizon L.
+Two constraint layouts are measured per plant: INPUT (V = 2*L*M) and CONSTRAINT_ALL (V = 2*N + 2*L*N + 2*L*M).
+*/
+
+namespace
+{
+
+//! Minimum wall-clock time spent on every measurement
+double g_min_time_s = 0.05;
+
+//! Sink used to keep results alive across the timed loops
+volatile float g_sink = 0;
+
+template<int R, int C, typename T>
+void consume(const Matrix<R,C,T> &m)
+{
+	g_sink = g_sink + static_cast<float>(m(0,0));
+}
+
+//! Expressions are evaluated in full, so lazy kernels are timed as if assigned
+template<typename E, int R, int C, typename T>
+void consume(const MatrixExpr<E,R,C,T> &e)
+{
+	consume(e.eval());
+}
+
+void consume(float v)
+{
+	g_sink = g_sink + v;
+}
+
+/*!
+@brief  Runs f repeatedly until g_min_time_s has elapsed.
+@return Average time per call in nanoseconds.
+*/
+template<typename F>
+double timeNs(F &&f)
+{
+	using Clock = std::chrono::steady_clock;
+
+	f();
+
+	long reps = 1;
+
+	while(true)
+	{
+		auto start = Clock::now();
+
+		for(long i = 0; i < reps; ++i)
+		{
+			f();
+		}
+
+		double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+		if(elapsed >= g_min_time_s)
+		{
+			return elapsed * 1e9 / reps;
+		}
+
+		reps *= 2;
+	}
+}
+
+void report(const char *kernel, int N, int M, int L, int V, double ns, int iters)
+{
+	std::cout << std::left << std::setw(29) << kernel << std::right
+		<< std::setw(4) << N << std::setw(4) << M << std::setw(4) << L << std::setw(5) << V
+		<< std::setw(14) << std::fixed << std::setprecision(1) << ns
+		<< std::setw(14) << std::setprecision(0) << (1e9 / ns)
+		<< std::setw(7) << iters << std::endl;
+}
+
+/*!
+@brief  Condensed MPC problem built from a random stable plant.
+@tparam N   Size of the state vector
+@tparam M   Size of the input vector
+@tparam L   Prediction horizon
+@tparam V   Length of the constraints vector
+*/
+template<int N, int M, int L, int V>
+struct Problem
+{
+	Matrix<N,N> A, AL, Q;
+	Matrix<N,M> B;
+	Matrix<M,M> R;
+	Matrix<N*L,N> Acal;
+	Matrix<N*L,M*L> Bcal;
+	Matrix<M*L,M*L> Hcal;
+	Matrix<M*L,N> h_base;
+	Matrix<V,M*L> Mx;
+	Matrix<V,1> cx;
+	Matrix<M,1> umin, umax, uinfy;
+	Matrix<N,1> xmin, xmax, xinfy, Nxmin, Nxmax;
+
+	explicit Problem(unsigned seed)
+	{
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+		for(int i = 0; i < N; ++i)
+		{
+			for(int j = 0; j < N; ++j)
+			{
+				A(i,j) = (i == j ? 0.9f : 0.0f) + 0.05f * dist(rng);
+			}
+
+			for(int j = 0; j < M; ++j)
+			{
+				B(i,j) = 0.1f * dist(rng);
+			}
+		}
+
+		AL = A.pow(L);
+
+		// Acal = [A; A^2; ...; A^L], Bcal(i,j) = A^(i-j) B for i >= j
+
+		Matrix<N,N> Ak = A;
+
+		for(int k = 0; k < L; ++k)
+		{
+			for(int i = 0; i < N; ++i)
+			{
+				for(int j = 0; j < N; ++j)
+				{
+					Acal(N*k + i, j) = Ak(i,j);
+				}
+			}
+
+			Ak = Ak * A;
+		}
+
+		Bcal = 0;
+
+		for(int k = 0; k < L; ++k)
+		{
+			Matrix<N,N> Ap(1.0f, true);
+
+			for(int d = 0; d <= k; ++d)
+			{
+				Matrix<N,M> ApB = Ap * B;
+
+				for(int i = 0; i < N; ++i)
+				{
+					for(int j = 0; j < M; ++j)
+					{
+						Bcal(N*k + i, M*(k-d) + j) = ApB(i,j);
+					}
+				}
+
+				Ap = Ap * A;
+			}
+		}
+
+		// Unit state and input weights, Q = 2*I and R = 0.2*I for the sparse formulation
+
+		Q = Matrix<N,N>(2.0f, true);
+		R = Matrix<M,M>(0.2f, true);
+		Hcal = Bcal.multTr(Bcal) + Matrix<M*L,M*L>(0.1f, true);
+		Hcal *= 2.0f;
+		h_base = Bcal.multTr(Acal) * 2.0f;
+
+		umin = -1.0f;
+		umax = 1.0f;
+		uinfy = 0.0f;
+		xmin = -10.0f;
+		xmax = 10.0f;
+		Nxmin = -10.0f;
+		Nxmax = 10.0f;
+		xinfy = 0.0f;
+
+		// Mx = [BL; -BL; Bcal; -Bcal; I; -I], only the input rows for INPUT
+
+		constexpr int inputRows = 2*M*L;
+		static_assert(V == inputRows || V == 2*N + 2*N*L + inputRows, "Unsupported constraints layout");
+
+		Mx = 0;
+		int row = 0;
+
+		if(V != inputRows)
+		{
+			for(int sign = 1; sign >= -1; sign -= 2)
+			{
+				for(int i = 0; i < N; ++i, ++row)
+				{
+					for(int j = 0; j < M*L; ++j)
+					{
+						Mx(row,j) = sign * Bcal(N*(L-1) + i, j);
+					}
+				}
+			}
+
+			for(int sign = 1; sign >= -1; sign -= 2)
+			{
+				for(int i = 0; i < N*L; ++i, ++row)
+				{
+					for(int j = 0; j < M*L; ++j)
+					{
+						Mx(row,j) = sign * Bcal(i,j);
+					}
+				}
+			}
+		}
+
+		for(int sign = 1; sign >= -1; sign -= 2)
+		{
+			for(int i = 0; i < M*L; ++i, ++row)
+			{
+				Mx(row,i) = static_cast<float>(sign);
+			}
+		}
+
+		cx = 1.0f;
+	}
+
+	Matrix<N,1> initialState(std::mt19937 &rng) const
+	{
+		std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+		Matrix<N,1> x;
+
+		for(int i = 0; i < N; ++i)
+		{
+			x(i,0) = dist(rng);
+		}
+
+		return x;
+	}
+};
+
+template<MpcConstraints C, int N, int M, int L, int V>
+void benchCase()
+{
+	constexpr int n = M*L;
+	constexpr int IT = MPC_QP_ITER;
+	const float tol = static_cast<float>(pow(10.0, MPC_TOL));
+
+	Problem<N,M,L,V> p(1234u + N*100 + M*10 + L);
+	std::mt19937 rng(42);
+
+	auto x = p.initialState(rng);
+	Matrix<n,1> h = p.h_base * x;
+	Matrix<V,1> cx = p.cx;
+	Matrix<n,n> Ak = p.Hcal + p.Mx.multTr(p.Mx);
+	Matrix<n,1> zero(0.0f);
+
+	// Matrix kernels
+
+	report("Matrix::operator*", N, M, L, V, timeNs([&] { consume(Ak * p.Hcal); }), 0);
+	report("Matrix::multTr", N, M, L, V, timeNs([&] { consume(p.Mx.multTr(p.Mx)); }), 0);
+	report("Matrix::scaledGram", N, M, L, V, timeNs([&] { consume(p.Mx.scaledGram(cx)); }), 0);
+	report("Matrix::dot", N, M, L, V, timeNs([&] { consume(cx.dot(cx)); }), 0);
+
+	// Inner solvers
+
+	report("lschol", N, M, L, V, timeNs([&] {
+		Matrix<n,1> b = h, z;
+		lschol(Ak, b, z);
+		consume(z);
+	}), 0);
+
+	int it_minres = 0;
+	double ns_minres = timeNs([&] {
+		Matrix<n,1> x0 = zero, z;
+		it_minres = minres<20>(Ak, h, x0, tol, z);
+		consume(z);
+	});
+	report("minres", N, M, L, V, ns_minres, it_minres);
+
+	int it_cgrad = 0;
+	double ns_cgrad = timeNs([&] {
+		Matrix<n,1> x0 = zero, z;
+		it_cgrad = cgrad<20>(Ak, h, x0, tol, z);
+		consume(z);
+	});
+	report("cgrad", N, M, L, V, ns_cgrad, it_cgrad);
+
+	// Full QP and MPC step
+
+	report("pdip<CHOLESKY>", N, M, L, V, timeNs([&] { consume(pdip<CHOLESKY, IT, 20>(p.Hcal, h, p.Mx, cx, tol)); }), IT);
+	report("pdip<MINRES>", N, M, L, V, timeNs([&] { consume(pdip<MINRES, IT, 20>(p.Hcal, h, p.Mx, cx, tol)); }), IT);
+	report("pdip<CGRAD>", N, M, L, V, timeNs([&] { consume(pdip<CGRAD, IT, 20>(p.Hcal, h, p.Mx, cx, tol)); }), IT);
+
+	const PdipCriteria<float> criteria = {1e-4f, 1e-4f, 1e8f};
+	PdipResult<float> result;
+	double ns_exit = timeNs([&] { consume(pdip<CHOLESKY, IT, 20>(p.Hcal, h, p.Mx, cx, tol, criteria, result)); });
+	report("pdip<CHOLESKY>,exit", N, M, L, V, ns_exit, result.iterations);
+
+	double ns_mehrotra = timeNs([&] { consume(pdip<CHOLESKY, IT, 20, MX_DENSE, PDIP_MEHROTRA>(p.Hcal, h, p.Mx, cx, tol, criteria, result)); });
+	report("pdip<CHOLESKY>,mehrotra", N, M, L, V, ns_mehrotra, result.iterations);
+
+	if(MpcConstraintsStructure<C>::value == MX_BOX)
+	{
+		constexpr MxStructure MS = MpcConstraintsStructure<C>::value;
+		report("pdip<CHOLESKY,MX_BOX>", N, M, L, V, timeNs([&] { consume(pdip<CHOLESKY, IT, 20, MS>(p.Hcal, h, p.Mx, cx, tol)); }), IT);
+	}
+
+	report("mpc_dense<CHOLESKY>", N, M, L, V, timeNs([&] {
+		Matrix<M,1> u;
+		mpc_dense<CHOLESKY, C, L, false, IT, MPC_TOL>(
+			p.AL,
+			p.Acal, p.Hcal, p.Mx,
+			p.umin, p.umax, p.uinfy,
+			p.xmin, p.xmax, p.xinfy,
+			p.Nxmin, p.Nxmax,
+			p.h_base,
+			cx, x, u
+		);
+		consume(u);
+	}), IT);
+}
+
+/*!
+@brief  pdip with early exit and every Krylov inner solver with exact Newton steps, and the preconditioned ones with
+        inexact steps. The iterations column reports the inner iterations summed over the QP, and a warning is printed if
+        the solution is further from the converged CHOLESKY one than dz_max, the distance of CHOLESKY with the same
+        early exit plus 1e-3.
+*/
+template<Solvers S, bool inexact, int N, int M, int L, int V>
+void benchKrylovSolver(const char *kernel, const Problem<N,M,L,V> &p, const Matrix<M*L,1> &h, const Matrix<M*L,1> &z_ref,
+	float dz_max)
+{
+	constexpr int IT = MPC_QP_ITER;
+	const float tol = static_cast<float>(pow(10.0, MPC_TOL));
+	const PdipCriteria<float> criteria = {1e-4f, 1e-4f, 1e8f};
+	PdipResult<float> result;
+	Matrix<M*L,1> z;
+
+	double ns = timeNs([&] {
+		z = pdip<S, IT, 20, MX_DENSE, MPC_QP_ALGORITHM, inexact>(p.Hcal, h, p.Mx, p.cx, tol, criteria, result);
+		consume(z);
+	});
+	report(kernel, N, M, L, V, ns, result.inner_iterations);
+
+	float dz = (z - z_ref).maxAbs();
+
+	if(dz > dz_max)
+	{
+		std::cerr << kernel << " differs from pdip<CHOLESKY>, max |dz| = " << dz << std::endl;
+	}
+}
+
+template<MpcConstraints C, int N, int M, int L, int V>
+void benchKrylov()
+{
+	Problem<N,M,L,V> p(1234u + N*100 + M*10 + L);
+	std::mt19937 rng(42);
+
+	Matrix<N,1> x = p.initialState(rng) * 5.0f;
+	Matrix<M*L,1> h = p.h_base * x;
+	const float tol = static_cast<float>(pow(10.0, MPC_TOL));
+	const PdipCriteria<float> converged = {0, 0, 0};
+	const PdipCriteria<float> criteria = {1e-4f, 1e-4f, 1e8f};
+	PdipResult<float> result;
+
+	// The early exit alone leaves up to 1e-2 between solutions, so the error of CHOLESKY with it is the baseline
+
+	Matrix<M*L,1> z_ref = pdip<CHOLESKY, MPC_QP_ITER, 20, MX_DENSE, MPC_QP_ALGORITHM>(p.Hcal, h, p.Mx, p.cx, tol, converged, result);
+	Matrix<M*L,1> z_exit = pdip<CHOLESKY, MPC_QP_ITER, 20, MX_DENSE, MPC_QP_ALGORITHM>(p.Hcal, h, p.Mx, p.cx, tol, criteria, result);
+	const float dz_max = (z_exit - z_ref).maxAbs() + 1e-3f;
+
+	benchKrylovSolver<MINRES, false>("pdip<MINRES>,exit", p, h, z_ref, dz_max);
+	benchKrylovSolver<MINRES_JACOBI, false>("pdip<MINRES_JACOBI>,exit", p, h, z_ref, dz_max);
+	benchKrylovSolver<MINRES_ICHOL, false>("pdip<MINRES_ICHOL>,exit", p, h, z_ref, dz_max);
+	benchKrylovSolver<CGRAD, false>("pdip<CGRAD>,exit", p, h, z_ref, dz_max);
+	benchKrylovSolver<CGRAD_JACOBI, false>("pdip<CGRAD_JACOBI>,exit", p, h, z_ref, dz_max);
+	benchKrylovSolver<CGRAD_ICHOL, false>("pdip<CGRAD_ICHOL>,exit", p, h, z_ref, dz_max);
+	benchKrylovSolver<MINRES_JACOBI, true>("pdip<MINRES_JACOBI>,inexact", p, h, z_ref, dz_max);
+	benchKrylovSolver<MINRES_ICHOL, true>("pdip<MINRES_ICHOL>,inexact", p, h, z_ref, dz_max);
+	benchKrylovSolver<CGRAD_JACOBI, true>("pdip<CGRAD_JACOBI>,inexact", p, h, z_ref, dz_max);
+	benchKrylovSolver<CGRAD_ICHOL, true>("pdip<CGRAD_ICHOL>,inexact", p, h, z_ref, dz_max);
+}
+
+/*!
+@brief  pdip with early exit in float, in double and in double with the mixed precision CHOLESKY_MIXED, exact and inexact
+        Newton steps. The iterations column reports the QP iterations for CHOLESKY and the refinement steps for
+        CHOLESKY_MIXED, and a warning is printed if a mixed solution differs from the double one.
+*/
+template<MpcConstraints C, int N, int M, int L, int V>
+void benchMixed()
+{
+	constexpr int IT = MPC_QP_ITER;
+	constexpr PdipAlgorithm A = MPC_QP_ALGORITHM;
+
+	Problem<N,M,L,V> p(1234u + N*100 + M*10 + L);
+	std::mt19937 rng(42);
+
+	Matrix<N,1> x = p.initialState(rng) * 5.0f;
+	Matrix<M*L,1> h = p.h_base * x;
+	const Matrix<M*L,M*L,double> Hcal = p.Hcal.template cast<double>();
+	const Matrix<V,M*L,double> Mx = p.Mx.template cast<double>();
+	const Matrix<V,1,double> cx = p.cx.template cast<double>();
+	const Matrix<M*L,1,double> hd = h.template cast<double>();
+	const PdipCriteria<float> criteria = {1e-4f, 1e-4f, 1e8f};
+	const PdipCriteria<double> criteria_d = {1e-4, 1e-4, 1e8};
+	const float tol = static_cast<float>(pow(10.0, MPC_TOL));
+	const double tol_d = pow(10.0, MPC_TOL);
+	PdipResult<float> result;
+	PdipResult<double> result_d;
+	Matrix<M*L,1,double> z_ref, z;
+
+	double ns = timeNs([&] { consume(pdip<CHOLESKY, IT, 20, MX_DENSE, A>(p.Hcal, h, p.Mx, p.cx, tol, criteria, result)); });
+	report("pdip<CHOLESKY>,float", N, M, L, V, ns, result.iterations);
+
+	ns = timeNs([&] {
+		z_ref = pdip<CHOLESKY, IT, 20, MX_DENSE, A>(Hcal, hd, Mx, cx, tol_d, criteria_d, result_d);
+		consume(z_ref);
+	});
+	report("pdip<CHOLESKY>,double", N, M, L, V, ns, result_d.iterations);
+
+	ns = timeNs([&] {
+		z = pdip<CHOLESKY_MIXED, IT, 20, MX_DENSE, A>(Hcal, hd, Mx, cx, tol_d, criteria_d, result_d);
+		consume(z);
+	});
+	report("pdip<CHOLESKY_MIXED>", N, M, L, V, ns, result_d.inner_iterations);
+
+	if((z - z_ref).maxAbs() > 1e-6)
+	{
+		std::cerr << "pdip<CHOLESKY_MIXED> differs from pdip<CHOLESKY>, max |dz| = " << (z - z_ref).maxAbs() << std::endl;
+	}
+
+	ns = timeNs([&] {
+		z = pdip<CHOLESKY_MIXED, IT, 20, MX_DENSE, A, true>(Hcal, hd, Mx, cx, tol_d, criteria_d, result_d);
+		consume(z);
+	});
+	report("pdip<CHOLESKY_MIXED>,inexact", N, M, L, V, ns, result_d.inner_iterations);
+
+	if((z - z_ref).maxAbs() > 1e-6)
+	{
+		std::cerr << "pdip<CHOLESKY_MIXED>,inexact differs from pdip<CHOLESKY>, max |dz| = " << (z - z_ref).maxAbs() << std::endl;
+	}
+}
+
+/*!
+@brief  Cold-started mpc_dense against DynMpcController on the same plant and state, both with early exit. The plant is
+        written as a model file and mapped back, as a service would load it. Warns if the inputs differ.
+*/
+template<MpcConstraints C, int N, int M, int L, int V>
+void benchDynamic()
+{
+	Problem<N,M,L,V> p(1234u + N*100 + M*10 + L);
+	std::mt19937 rng(42);
+
+	Matrix<N,1> x = p.initialState(rng) * 5.0f;
+	Matrix<M,1> u;
+	PdipResult<float> result;
+
+	double ns = timeNs([&] {
+		Matrix<V,1> cx = p.cx;
+
+		mpc_dense<CHOLESKY, C, L, false, MPC_QP_ITER, MPC_TOL, true, MPC_EXIT_TOL, MPC_QP_ALGORITHM>(
+			p.AL,
+			p.Acal, p.Hcal, p.Mx,
+			p.umin, p.umax, p.uinfy,
+			p.xmin, p.xmax, p.xinfy,
+			p.Nxmin, p.Nxmax,
+			p.h_base,
+			cx, x, u,
+			result
+		);
+		consume(u);
+	});
+	report("mpc_dense, static", N, M, L, V, ns, result.iterations);
+
+	// Problem condenses with Q = P = 2*I and R = 0.2*I
+
+	const float zero_p[N + M] = {};
+	const MpcModelView view =
+	{
+		N, M, 1, L, C, "bench",
+		&p.A(0,0), &p.B(0,0), &p.Q(0,0), &p.R(0,0), &p.Q(0,0),
+		&p.umin(0,0), &p.umax(0,0), &p.xmin(0,0), &p.xmax(0,0), &p.Nxmin(0,0), &p.Nxmax(0,0),
+		zero_p, zero_p
+	};
+	const char *path = "bench_generic_dense.mpcm";
+
+	MpcModelFile file;
+
+	if(!writeMpcModelFile(path, view) || file.open(path) != MODEL_OK)
+	{
+		std::cerr << "Cannot write and map " << path << std::endl;
+		return;
+	}
+
+	std::remove(path);
+
+	DynMpcOptions options;
+	options.qpiter = MPC_QP_ITER;
+	options.early_exit = true;
+	options.exit_tol = MPC_EXIT_TOL;
+	options.algorithm = MPC_QP_ALGORITHM;
+	options.warm_start = false;
+
+	const DynMpcModel<float> model(file.view());
+	DynMpcController<float> controller(model, options);
+	float u_dyn[M];
+
+	ns = timeNs([&] {
+		controller.step(&x(0,0), u_dyn);
+		consume(u_dyn[0]);
+	});
+	report("DynMpcController", N, M, L, V, ns, controller.result().iterations);
+
+	float max_du = 0;
+
+	for(int i = 0; i < M; ++i)
+	{
+		float du = std::fabs(u_dyn[i] - u(i,0));
+		max_du = du > max_du ? du : max_du;
+	}
+
+	if(max_du > 1e-3f)
+	{
+		std::cerr << "DynMpcController differs from mpc_dense, max |du| = " << max_du << std::endl;
+	}
+}
+
+/*!
+@brief  Closed-loop run of mpc_dense with early exit, cold and warm started. Reports the mean and worst call.
+*/
+template<MpcConstraints C, int N, int M, int L, int V>
+void benchClosedLoop()
+{
+	using Clock = std::chrono::steady_clock;
+	constexpr int IT = MPC_QP_ITER;
+	constexpr int steps = 500;
+
+	Problem<N,M,L,V> p(1234u + N*100 + M*10 + L);
+
+	for(int warm_start = 0; warm_start < 2; ++warm_start)
+	{
+		std::mt19937 rng(7);
+		MpcWarmStart<M*L,V> warm(warm_start != 0);
+		Matrix<V,1> cx = p.cx;
+		Matrix<N,1> x = p.initialState(rng) * 5.0f;
+		double total_ns = 0, max_ns = 0;
+		int total_it = 0, max_it = 0;
+
+		for(int k = 0; k < steps; ++k)
+		{
+			Matrix<M,1> u;
+			PdipResult<float> result;
+
+			auto start = Clock::now();
+			mpc_dense<CHOLESKY, C, L, false, IT, MPC_TOL, true, MPC_EXIT_TOL>(
+				p.AL,
+				p.Acal, p.Hcal, p.Mx,
+				p.umin, p.umax, p.uinfy,
+				p.xmin, p.xmax, p.xinfy,
+				p.Nxmin, p.Nxmax,
+				p.h_base,
+				cx, x, u,
+				result, warm
+			);
+			double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+			total_ns += ns;
+			max_ns = ns > max_ns ? ns : max_ns;
+			total_it += result.iterations;
+			max_it = result.iterations > max_it ? result.iterations : max_it;
+
+			x = p.A * x + p.B * u;
+		}
+
+		report(warm_start ? "closed loop, warm" : "closed loop, cold", N, M, L, V, total_ns / steps, total_it / steps);
+		report(warm_start ? "  worst call, warm" : "  worst call, cold", N, M, L, V, max_ns, max_it);
+	}
+}
+
+/*!
+@brief  K plants with random states, solved one at a time by mpc_dense and in lockstep by mpc_dense_batch, both with
+        early exit. Reports the time per plant and warns if the inputs differ.
+*/
+template<MpcConstraints C, int N, int M, int L, int V>
+void benchBatch()
+{
+	constexpr int IT = MPC_QP_ITER;
+	constexpr int K = 8;
+	using LT = Lanes<K>;
+
+	Problem<N,M,L,V> p(1234u + N*100 + M*10 + L);
+	std::mt19937 rng(11);
+
+	Matrix<N,1> x[K];
+	Matrix<M,1> u[K];
+	Matrix<N,1,LT> xb;
+	Matrix<M,1,LT> ub;
+	PdipResult<float> result[K];
+	int iters = 0;
+
+	for(int k = 0; k < K; ++k)
+	{
+		x[k] = p.initialState(rng) * 5.0f;
+
+		for(int i = 0; i < N; ++i)
+		{
+			xb(i,0)[k] = x[k](i,0);
+		}
+	}
+
+	double ns_single = timeNs([&] {
+		iters = 0;
+
+		for(int k = 0; k < K; ++k)
+		{
+			Matrix<V,1> cx = p.cx;
+
+			mpc_dense<CHOLESKY, C, L, false, IT, MPC_TOL, true, MPC_EXIT_TOL>(
+				p.AL,
+				p.Acal, p.Hcal, p.Mx,
+				p.umin, p.umax, p.uinfy,
+				p.xmin, p.xmax, p.xinfy,
+				p.Nxmin, p.Nxmax,
+				p.h_base,
+				cx, x[k], u[k],
+				result[k]
+			);
+			iters = result[k].iterations > iters ? result[k].iterations : iters;
+		}
+		consume(u[0]);
+	});
+	report("mpc_dense, 8 plants", N, M, L, V, ns_single / K, iters);
+
+	const Matrix<M,1,LT> uinfy = p.uinfy.template cast<LT>();
+	const Matrix<N,1,LT> xinfy = p.xinfy.template cast<LT>();
+
+	double ns_batch = timeNs([&] {
+		Matrix<V,1,LT> cx = p.cx.template cast<LT>();
+
+		mpc_dense_batch<C, L, false, IT, true, MPC_EXIT_TOL>(
+			p.AL,
+			p.Acal, p.Hcal, p.Mx,
+			p.umin, p.umax, uinfy,
+			p.xmin, p.xmax, xinfy,
+			p.Nxmin, p.Nxmax,
+			p.h_base,
+			cx, xb, ub,
+			result
+		);
+		consume(ub(0,0)[0]);
+	});
+
+	float max_du = 0;
+	iters = 0;
+
+	for(int k = 0; k < K; ++k)
+	{
+		for(int i = 0; i < M; ++i)
+		{
+			float du = std::fabs(ub(i,0)[k] - u[k](i,0));
+			max_du = du > max_du ? du : max_du;
+		}
+
+		iters = result[k].iterations > iters ? result[k].iterations : iters;
+	}
+
+	report("mpc_dense_batch<8>", N, M, L, V, ns_batch / K, iters);
+
+	if(max_du > 1e-3f)
+	{
+		std::cerr << "mpc_dense_batch differs from mpc_dense, max |du| = " << max_du << std::endl;
+	}
+}
+
+/*!
+@brief  Cold-started mpc_sparse with early exit. Reports the time per call and warns if the input differs from u_ref.
+*/
+template<Solvers S, MpcConstraints C, int N, int M, int L, int V>
+void benchSparse(const char *kernel, const Problem<N,M,L,V> &p, Matrix<N,1> x, const Matrix<M,1> &u_ref)
+{
+	Matrix<M,1> u;
+	PdipResult<float> result;
+
+	double ns = timeNs([&] {
+		mpc_sparse<S, C, L, false, MPC_QP_ITER, true, MPC_EXIT_TOL, MPC_QP_ALGORITHM>(
+			p.A, p.B,
+			p.Q, p.R, p.Q,
+			p.umin, p.umax, p.uinfy,
+			p.xmin, p.xmax, p.xinfy,
+			p.Nxmin, p.Nxmax,
+			x, u,
+			result
+		);
+		consume(u);
+	});
+	report(kernel, N, M, L, V, ns, result.iterations);
+
+	float max_du = 0;
+
+	for(int i = 0; i < M; ++i)
+	{
+		float du = std::fabs(u(i,0) - u_ref(i,0));
+		max_du = du > max_du ? du : max_du;
+	}
+
+	if(max_du > 1e-3f)
+	{
+		std::cerr << kernel << " differs from mpc_dense, max |du| = " << max_du << std::endl;
+	}
+}
+
+/*!
+@brief  Cold-started mpc_dense and mpc_sparse, both with early exit, on the same plant and state. The dense cost grows
+        with (M*L)^3 and the sparse one with L*(N+M)^3.
+*/
+template<MpcConstraints C, int N, int M, int L, int V>
+void benchHorizon()
+{
+	// Long horizons do not fit the stack
+
+	static const Problem<N,M,L,V> p(1234u + N*100 + M*10 + L);
+	std::mt19937 rng(42);
+
+	Matrix<N,1> x = p.initialState(rng) * 5.0f;
+	Matrix<M,1> u;
+	PdipResult<float> result;
+
+	double ns = timeNs([&] {
+		Matrix<V,1> cx = p.cx;
+
+		mpc_dense<CHOLESKY, C, L, false, MPC_QP_ITER, MPC_TOL, true, MPC_EXIT_TOL, MPC_QP_ALGORITHM>(
+			p.AL,
+			p.Acal, p.Hcal, p.Mx,
+			p.umin, p.umax, p.uinfy,
+			p.xmin, p.xmax, p.xinfy,
+			p.Nxmin, p.Nxmax,
+			p.h_base,
+			cx, x, u,
+			result
+		);
+		consume(u);
+	});
+	report("mpc_dense, horizon", N, M, L, V, ns, result.iterations);
+
+	benchSparse<CHOLESKY, C>("mpc_sparse<CHOLESKY>", p, x, u);
+	benchSparse<RICCATI, C>("mpc_sparse<RICCATI>", p, x, u);
+}
+
+template<int N, int M, int L>
+void benchLongHorizon()
+{
+	benchHorizon<INPUT, N, M, L, 2*L*M>();
+	benchHorizon<CONSTRAINT_ALL, N, M, L, 2*N + 2*L*N + 2*L*M>();
+}
+
+template<int N, int M, int L>
+void benchPlant()
+{
+	benchCase<INPUT, N, M, L, 2*L*M>();
+	benchKrylov<INPUT, N, M, L, 2*L*M>();
+	benchMixed<INPUT, N, M, L, 2*L*M>();
+	benchDynamic<INPUT, N, M, L, 2*L*M>();
+	benchClosedLoop<INPUT, N, M, L, 2*L*M>();
+	benchBatch<INPUT, N, M, L, 2*L*M>();
+	benchCase<CONSTRAINT_ALL, N, M, L, 2*N + 2*L*N + 2*L*M>();
+	benchKrylov<CONSTRAINT_ALL, N, M, L, 2*N + 2*L*N + 2*L*M>();
+	benchMixed<CONSTRAINT_ALL, N, M, L, 2*N + 2*L*N + 2*L*M>();
+	benchDynamic<CONSTRAINT_ALL, N, M, L, 2*N + 2*L*N + 2*L*M>();
+	benchClosedLoop<CONSTRAINT_ALL, N, M, L, 2*N + 2*L*N + 2*L*M>();
+	benchBatch<CONSTRAINT_ALL, N, M, L, 2*N + 2*L*N + 2*L*M>();
+}
+
+} // namespace
+
+/*!
+@brief  Usage: bench_generic_dense [min_time_per_case_seconds]
+*/
+int main(int argc, char **argv)
+{
+	if(argc > 1)
+	{
+		g_min_time_s = std::atof(argv[1]);
+	}
+
+#ifdef MATRIX_SIMD
+	std::cout << "Matrix kernels: " << MATRIX_SIMD << std::endl;
+#else
+	std::cout << "Matrix kernels: scalar" << std::endl;
+#endif
+
+	std::cout << std::left << std::setw(29) << "kernel" << std::right
+		<< std::setw(4) << "N" << std::setw(4) << "M" << std::setw(4) << "L" << std::setw(5) << "V"
+		<< std::setw(14) << "ns/call" << std::setw(14) << "calls/s" << std::setw(7) << "iters" << std::endl;
+
+	benchPlant<2, 1, 2>();
+	benchPlant<2, 1, 5>();
+	benchPlant<2, 1, 10>();
+	benchPlant<4, 2, 5>();
+	benchPlant<4, 2, 10>();
+
+	benchLongHorizon<2, 1, 10>();
+	benchLongHorizon<2, 1, 25>();
+	benchLongHorizon<2, 1, 50>();
+	benchLongHorizon<2, 1, 100>();
+	benchLongHorizon<2, 1, 200>();
+	benchLongHorizon<4, 2, 50>();
+	benchLongHorizon<4, 2, 100>();
+
+	return EXIT_SUCCESS;
+}
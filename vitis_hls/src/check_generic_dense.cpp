@@ -0,0 +1,602 @@
+#include "mpc/systems/hls_generic_dense.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "mpc/mpc_controller.hpp"
+#include "mpc/mpc_dense_batch.hpp"
+#include "mpc/mpc_sparse.hpp"
+#include "mpc/lschol.hpp"
+#include "mpc/generic_dense_init.hpp"
+
+/*!
+@file   check_generic_dense.cpp
+@brief  Regression checks of the generated system that the closed-loop replays of tb and accuracy do not reach.
+        Every check prints one line and the program fails if any of them does.
+
+    cold start  Cold-started solves with Mehrotra and QP_ITER iterations, on random states in growing boxes, against a
+                fixed-centering solve with ten times the iterations. Every solve must converge to the same input.
+    batch       Closed loops of 8 plants from random states, solved by mpc_dense_batch with warm start against one warm
+                started MpcController per plant. Every input must match, and the warm start must save iterations. States
+                stay within 20, where warm starts help; from states near 200 the shifted iterates sit on the input bounds
+                and Mehrotra occasionally fails from them, in both solvers alike.
+    inexact     Cold-started solves with inexact Newton steps, CGRAD_JACOBI and Mehrotra, with every QP iteration limit
+                from 1 to QP_ITER. A state solved within some limit must stay solved within every larger one, which fails
+                if a loose step that converged on the last pass is repeated past the limit, and the solutions must match
+                the fixed-centering reference of the cold start check.
+    riccati     Cold-started mpc_sparse with the Riccati recursion of SparseKkt<RICCATI> against mpc_dense, on the
+                generated plant with its own constraints and horizon, within 1e-3 relative |du|, and with every
+                constraint, states bounded to 3 and a horizon of 10, within 1e-2. From |x| <= 5 the bounds leave ~42 %
+                of the states feasible and change the input of ~21 % of those. Every state mpc_dense solves must be
+                solved to the same input, or reported unconverged, which may happen for at most 1 %. With active state
+                bounds the exit tolerance only pins the input to ~2e-3, and mpc_sparse with CHOLESKY differs from
+                mpc_dense by as much, so the tighter tolerance holds only for the generated plant.
+    ldl         Closed-form LDL' kernels of sizes 1 to 4, and the column loops at 5, on random well-conditioned symmetric
+                positive definite systems. The residual must stay at float round-off.
+    simd        Products, multTr, dot and squaredSum through the vector kernels of matrix_simd.hpp against the reference
+                loops, on random operands of shapes on both sides of the kernel thresholds and with ragged tails.
+                Only the summation order differs, so they must agree to float round-off. Trivial in scalar builds.
+*/
+
+namespace
+{
+
+/*!
+@brief  Cold-started Mehrotra solves on states drawn uniformly in |x| <= bound
+@param  samples Number of states
+@return true if every solve converged within 1e-3 relative |du| of the reference
+*/
+bool checkColdStart(float bound, int samples)
+{
+	const GenericDenseModel model = genericDenseModel();
+
+	MpcController<GenericDenseModel, CHOLESKY, CONSTRAINTS, false, QP_ITER, TOL, true, EXIT_TOL, PDIP_MEHROTRA> controller(model, false);
+	MpcController<GenericDenseModel, CHOLESKY, CONSTRAINTS, false, 10*QP_ITER, TOL, false, EXIT_TOL, PDIP_FIXED_CENTERING> reference(model, false);
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> dist(-bound, bound);
+
+	int unconverged = 0, wrong = 0;
+	double iterations = 0, max_err = 0;
+
+	for(int s = 0; s < samples; ++s)
+	{
+		Matrix<N,1> x;
+
+		for(int j = 0; j < N; ++j)
+		{
+			x(j,0) = dist(rng);
+		}
+
+		const Matrix<M,1> u = controller.step(x);
+		const Matrix<M,1> u_ref = reference.step(x);
+		double err = 0;
+
+		for(int i = 0; i < M; ++i)
+		{
+			double e = std::fabs(double(u(i,0)) - u_ref(i,0)) / (1 + std::fabs(u_ref(i,0)));
+			err = e > err ? e : err;
+		}
+
+		unconverged += controller.result().status != PDIP_CONVERGED;
+		wrong += err > 1e-3;
+		iterations += double(controller.result().iterations) / samples;
+		max_err = err > max_err ? err : max_err;
+	}
+
+	const bool ok = unconverged == 0 && wrong == 0;
+
+	std::cout << (ok ? "[ok]   " : "[FAIL] ") << "cold start |x| <= " << int(bound) << ": " << samples << " states, "
+		<< unconverged << " unconverged, " << wrong << " wrong, " << std::fixed << std::setprecision(1) << iterations
+		<< " QP it, max relative |du| " << std::scientific << std::setprecision(2) << max_err << std::endl;
+
+	return ok;
+}
+
+/*!
+@brief  Warm-started mpc_dense_batch over closed loops against one MpcController per plant
+@param  steps   Control steps of every loop
+@return true if every input matches within 1e-3 relative and the warm start takes fewer iterations than cold solves
+*/
+bool checkBatch(float bound, int steps)
+{
+	constexpr int K = 8;
+	typedef Lanes<K> LT;
+	typedef MpcController<GenericDenseModel, CHOLESKY, CONSTRAINTS, false, QP_ITER, TOL, true, EXIT_TOL, PDIP_MEHROTRA> Controller;
+
+	const GenericDenseModel model = genericDenseModel();
+	const auto A = Matrix<N,N>(__init_A);
+	const auto B = Matrix<N,M>(__init_B);
+
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> dist(-bound, bound);
+
+	std::vector<Controller> controllers(K, Controller(model, true));
+	Matrix<N,1> x[K];
+	Matrix<N,1,LT> xb;
+	Matrix<M,1,LT> ub;
+	Matrix<V,1,LT> cx = model.cx.template cast<LT>(), cx_cold = cx;
+	const Matrix<M,1,LT> uinfy(LT(0));
+	const Matrix<N,1,LT> xinfy(LT(0));
+	PdipResult<float> result[K];
+	MpcWarmStartBatch<M*L,V,K> warm(true);
+
+	for(int k = 0; k < K; ++k)
+	{
+		for(int j = 0; j < N; ++j)
+		{
+			x[k](j,0) = dist(rng);
+		}
+	}
+
+	int wrong = 0;
+	double iterations = 0, iterations_cold = 0, max_err = 0;
+
+	for(int s = 0; s < steps; ++s)
+	{
+		for(int k = 0; k < K; ++k)
+		{
+			for(int j = 0; j < N; ++j)
+			{
+				xb(j,0)[k] = x[k](j,0);
+			}
+		}
+
+		// The same states cold started, for the iterations saved
+
+		Matrix<N,1,LT> xc = xb;
+		Matrix<M,1,LT> uc;
+
+		mpc_dense_batch<CONSTRAINTS, L, false, QP_ITER, true, EXIT_TOL, PDIP_MEHROTRA>(
+			model.AL, model.Acal, model.Hcal, model.Mx, model.umin, model.umax, uinfy, model.xmin, model.xmax, xinfy,
+			model.Nxmin, model.Nxmax, model.h_base, cx_cold, xc, uc, result);
+
+		for(int k = 0; k < K; ++k)
+		{
+			iterations_cold += double(result[k].iterations) / (K * steps);
+		}
+
+		mpc_dense_batch<CONSTRAINTS, L, false, QP_ITER, true, EXIT_TOL, PDIP_MEHROTRA>(
+			model.AL, model.Acal, model.Hcal, model.Mx, model.umin, model.umax, uinfy, model.xmin, model.xmax, xinfy,
+			model.Nxmin, model.Nxmax, model.h_base, cx, xb, ub, result, warm);
+
+		for(int k = 0; k < K; ++k)
+		{
+			const Matrix<M,1> u_ref = controllers[k].step(x[k]);
+			Matrix<M,1> u;
+			double err = 0;
+
+			for(int i = 0; i < M; ++i)
+			{
+				u(i,0) = ub(i,0)[k];
+				double e = std::fabs(double(u(i,0)) - u_ref(i,0)) / (1 + std::fabs(u_ref(i,0)));
+				err = e > err ? e : err;
+			}
+
+			wrong += err > 1e-3;
+			max_err = err > max_err ? err : max_err;
+			iterations += double(result[k].iterations) / (K * steps);
+			x[k] = A * x[k] + B * u_ref;
+		}
+	}
+
+	const bool ok = wrong == 0 && iterations < iterations_cold;
+
+	std::cout << (ok ? "[ok]   " : "[FAIL] ") << "batch warm start |x| <= " << int(bound) << ": " << K << " plants, " << steps
+		<< " steps, " << wrong << " wrong, " << std::fixed << std::setprecision(1) << iterations << " QP it (cold "
+		<< iterations_cold << "), max relative |du| " << std::scientific << std::setprecision(2) << max_err << std::endl;
+
+	return ok;
+}
+
+/*!
+@brief  Cold-started inexact solves of every state with IT QP iterations, CGRAD_JACOBI and Mehrotra
+@param  u   Input of every state
+@return Whether each solve converged
+*/
+template<int IT>
+std::vector<bool> inexactConverged(const GenericDenseModel &model, const std::vector<Matrix<N,1>> &states, std::vector<Matrix<M,1>> &u)
+{
+	MpcController<GenericDenseModel, CGRAD_JACOBI, CONSTRAINTS, false, IT, TOL, true, EXIT_TOL, PDIP_MEHROTRA, true> controller(model, false);
+	std::vector<bool> converged(states.size());
+
+	for(std::size_t s = 0; s < states.size(); ++s)
+	{
+		u[s] = controller.step(states[s]);
+		converged[s] = controller.result().status == PDIP_CONVERGED;
+	}
+
+	return converged;
+}
+
+//! Solves with 1 to IT QP iterations, converged[it - 1] for it iterations
+template<int IT>
+struct InexactSweep
+{
+	static void run(const GenericDenseModel &model, const std::vector<Matrix<N,1>> &states,
+		std::vector<std::vector<bool>> &converged, std::vector<Matrix<M,1>> &u)
+	{
+		InexactSweep<IT - 1>::run(model, states, converged, u);
+		converged.push_back(inexactConverged<IT>(model, states, u));
+	}
+};
+
+template<>
+struct InexactSweep<0>
+{
+	static void run(const GenericDenseModel &, const std::vector<Matrix<N,1>> &, std::vector<std::vector<bool>> &,
+		std::vector<Matrix<M,1>> &)
+	{ }
+};
+
+/*!
+@brief  Inexact Newton steps with every QP iteration limit up to QP_ITER, on states drawn uniformly in |x| <= bound.
+        A loose step that converges on the last pass cannot be repeated and must be returned as converged, so a state
+        solved within some limit must stay solved within every larger one
+@param  samples Number of states
+@return true if no state is lost by a larger limit and the solves with QP_ITER iterations match the reference within
+        1e-3 relative |du|
+*/
+bool checkInexact(float bound, int samples)
+{
+	const GenericDenseModel model = genericDenseModel();
+
+	MpcController<GenericDenseModel, CHOLESKY, CONSTRAINTS, false, 10*QP_ITER, TOL, false, EXIT_TOL, PDIP_FIXED_CENTERING> reference(model, false);
+
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<float> dist(-bound, bound);
+	std::vector<Matrix<N,1>> states(samples);
+	std::vector<Matrix<M,1>> u(samples);
+	std::vector<std::vector<bool>> converged;
+
+	for(auto &x : states)
+	{
+		for(int j = 0; j < N; ++j)
+		{
+			x(j,0) = dist(rng);
+		}
+	}
+
+	InexactSweep<QP_ITER>::run(model, states, converged, u);
+
+	int lost = 0, wrong = 0;
+	double max_err = 0, iterations = 0;
+
+	for(int s = 0; s < samples; ++s)
+	{
+		int first = QP_ITER + 1;
+
+		for(int it = QP_ITER; it >= 1; --it)
+		{
+			first = converged[it - 1][s] ? it : first;
+		}
+
+		for(int it = first; it < QP_ITER; ++it)
+		{
+			lost += !converged[it][s];
+		}
+
+		if(!converged[QP_ITER - 1][s])
+		{
+			continue;
+		}
+
+		const Matrix<M,1> u_ref = reference.step(states[s]);
+		double err = 0;
+
+		for(int i = 0; i < M; ++i)
+		{
+			double e = std::fabs(double(u[s](i,0)) - u_ref(i,0)) / (1 + std::fabs(u_ref(i,0)));
+			err = e > err ? e : err;
+		}
+
+		wrong += err > 1e-3;
+		max_err = err > max_err ? err : max_err;
+		iterations += double(first) / samples;
+	}
+
+	const bool ok = lost == 0 && wrong == 0;
+
+	std::cout << (ok ? "[ok]   " : "[FAIL] ") << "inexact limits 1 to " << QP_ITER << " |x| <= " << int(bound) << ": "
+		<< samples << " states, " << lost << " lost by a larger limit, " << wrong << " wrong, converged from "
+		<< std::fixed << std::setprecision(1) << iterations << " QP it, max relative |du| " << std::scientific
+		<< std::setprecision(2) << max_err << std::endl;
+
+	return ok;
+}
+
+//! Plant, weights and bounds of the generated system
+MpcPlant<N,M> generatedPlant()
+{
+	return
+	{
+		__init_A, __init_B, __init_Q, __init_R, __init_P,
+		__init_umin, __init_umax, __init_xmin, __init_xmax, __init_Nxmin, __init_Nxmax
+	};
+}
+
+/*!
+@brief  Generated plant with every state, final state included, bounded to |x| <= xbound. The generated system leaves
+        its state bounds at zero, which no state but the origin satisfies
+*/
+MpcPlant<N,M> boundedPlant(float xbound)
+{
+	static float xmin[N], xmax[N];
+
+	for(int i = 0; i < N; ++i)
+	{
+		xmin[i] = -xbound;
+		xmax[i] = xbound;
+	}
+
+	MpcPlant<N,M> plant = generatedPlant();
+
+	plant.xmin = plant.Nxmin = xmin;
+	plant.xmax = plant.Nxmax = xmax;
+
+	return plant;
+}
+
+/*!
+@brief  Cold-started mpc_sparse with the Riccati recursion against mpc_dense, both with Mehrotra, early exit and
+        QP_ITER iterations, on a plant condensed for the given constraints and horizon. States are drawn uniformly in
+        |x| <= bound; those mpc_dense does not solve, infeasible under state constraints, are skipped
+@param  name    Name of the case, for the report
+@param  samples Number of states
+@param  tol     Relative |du| allowed between both solutions
+@return true if every state solved by mpc_dense is solved by mpc_sparse within tol, or reported unconverged by it for
+        at most 1 % of the states
+*/
+template<MpcConstraints C, int L, int V>
+bool checkRiccati(const char *name, const MpcPlant<N,M> &plant, float bound, int samples, double tol)
+{
+	const MpcCondensed<N,M,L,V> condensed = mpcCondense<C, L, V>(plant);
+
+	const Matrix<N,N> A(plant.A), Q(plant.Q), Pw(plant.P);
+	const Matrix<N,M> B(plant.B);
+	const Matrix<M,M> R(plant.R);
+	const Matrix<M,1> umin(plant.umin), umax(plant.umax), uinfy(0.0f);
+	const Matrix<N,1> xmin(plant.xmin), xmax(plant.xmax), Nxmin(plant.Nxmin), Nxmax(plant.Nxmax), xinfy(0.0f);
+	const Matrix<N,N> AL(condensed.AL);
+	const Matrix<N*L,N> Acal(condensed.Acal);
+	const Matrix<M*L,M*L> Hcal(condensed.Hcal);
+	const Matrix<M*L,N> h_base(condensed.h_base);
+	const Matrix<V,M*L> Mx(condensed.Mx);
+
+	std::mt19937 rng(6);
+	std::uniform_real_distribution<float> dist(-bound, bound);
+
+	int compared = 0, unconverged = 0, wrong = 0;
+	double max_err = 0;
+
+	for(int s = 0; s < samples; ++s)
+	{
+		Matrix<N,1> x;
+
+		for(int j = 0; j < N; ++j)
+		{
+			x(j,0) = dist(rng);
+		}
+
+		Matrix<N,1> x_dense = x, x_sparse = x;
+		Matrix<V,1> cx(condensed.cx);
+		Matrix<M,1> u_dense, u_sparse;
+		PdipResult<float> result_dense, result_sparse;
+
+		mpc_dense<CHOLESKY, C, L, false, QP_ITER, TOL, true, EXIT_TOL, PDIP_MEHROTRA>(
+			AL, Acal, Hcal, Mx, umin, umax, uinfy, xmin, xmax, xinfy, Nxmin, Nxmax, h_base,
+			cx, x_dense, u_dense, result_dense);
+
+		if(result_dense.status != PDIP_CONVERGED)
+		{
+			continue;
+		}
+
+		mpc_sparse<RICCATI, C, L, false, QP_ITER, true, EXIT_TOL, PDIP_MEHROTRA>(
+			A, B, Q, R, Pw, umin, umax, uinfy, xmin, xmax, xinfy, Nxmin, Nxmax,
+			x_sparse, u_sparse, result_sparse);
+
+		double err = 0;
+
+		for(int i = 0; i < M; ++i)
+		{
+			double e = std::fabs(double(u_sparse(i,0)) - u_dense(i,0)) / (1 + std::fabs(u_dense(i,0)));
+			err = e > err ? e : err;
+		}
+
+		++compared;
+
+		if(result_sparse.status != PDIP_CONVERGED)
+		{
+			++unconverged;
+			continue;
+		}
+
+		wrong += err > tol;
+		max_err = err > max_err ? err : max_err;
+	}
+
+	const bool ok = compared > 0 && 100 * unconverged <= compared && wrong == 0;
+
+	std::cout << (ok ? "[ok]   " : "[FAIL] ") << "riccati against mpc_dense, " << name << ", L = " << L
+		<< " |x| <= " << int(bound) << ": " << compared << " of " << samples << " states, " << unconverged
+		<< " unconverged, " << wrong << " wrong, max relative |du| " << std::scientific << std::setprecision(2)
+		<< max_err << std::endl;
+
+	return ok;
+}
+
+template<int N, int M>
+Matrix<N,M> randomMatrix(std::mt19937 &rng)
+{
+	std::uniform_real_distribution<float> dist(-1, 1);
+	Matrix<N,M> m;
+
+	for(int i = 0; i < N; ++i)
+	{
+		for(int j = 0; j < M; ++j)
+		{
+			m(i,j) = dist(rng);
+		}
+	}
+
+	return m;
+}
+
+//! Largest difference between a and the reference, relative to 1 + |reference|
+template<int N, int M>
+double relativeError(const Matrix<N,M> &a, const Matrix<N,M> &ref)
+{
+	return double((a - ref).maxAbs()) / (1 + double(ref.maxAbs()));
+}
+
+template<int N, int K, int P>
+double productError(std::mt19937 &rng)
+{
+	const Matrix<N,K> a = randomMatrix<N,K>(rng);
+	const Matrix<K,P> b = randomMatrix<K,P>(rng);
+	Matrix<N,P> ref;
+
+	MatrixEvalLoops::assign(ref, a * b);
+
+	return relativeError(Matrix<N,P>(a * b), ref);
+}
+
+template<int K, int N, int P>
+double multTrError(std::mt19937 &rng)
+{
+	const Matrix<K,N> a = randomMatrix<K,N>(rng);
+	const Matrix<K,P> b = randomMatrix<K,P>(rng);
+	Matrix<N,P> ref;
+
+	MatrixEvalLoops::assign(ref, a.multTr(b));
+
+	return relativeError(Matrix<N,P>(a.multTr(b)), ref);
+}
+
+template<int N>
+double dotError(std::mt19937 &rng)
+{
+	const Matrix<N,1> a = randomMatrix<N,1>(rng);
+	const Matrix<N,1> b = randomMatrix<N,1>(rng);
+	const double dot = a.dot(b), dot_ref = MatrixEvalLoops::dot(a, b);
+	const double sq = a.squaredSum(), sq_ref = MatrixEvalLoops::squaredSum(a);
+	const double e_dot = std::fabs(dot - dot_ref) / (1 + std::fabs(dot_ref));
+	const double e_sq = std::fabs(sq - sq_ref) / (1 + sq_ref);
+
+	return e_dot > e_sq ? e_dot : e_sq;
+}
+
+//! Relative residual of lschol on A = B'*B + n*I and a random right-hand side
+template<int N>
+double ldlResidual(std::mt19937 &rng)
+{
+	const Matrix<N,N> B = randomMatrix<N,N>(rng);
+	Matrix<N,N> A = B.multTr(B);
+	const Matrix<N,1> v = randomMatrix<N,1>(rng);
+	Matrix<N,1> rhs = v, x;
+
+	for(int i = 0; i < N; ++i)
+	{
+		A(i,i) += N;
+	}
+
+	lschol(A, rhs, x);
+
+	return relativeError(Matrix<N,1>(A * x), v);
+}
+
+/*!
+@brief  LDL' kernels on random systems
+@param  draws   Random systems per size
+@return true if every residual is within 1e-5 relative
+*/
+bool checkLdl(int draws)
+{
+	std::mt19937 rng(4);
+	double max_err = 0;
+
+	for(int d = 0; d < draws; ++d)
+	{
+		const double errors[] =
+		{
+			ldlResidual<1>(rng), ldlResidual<2>(rng), ldlResidual<3>(rng), ldlResidual<4>(rng), ldlResidual<5>(rng)
+		};
+
+		for(double e : errors)
+		{
+			max_err = e > max_err ? e : max_err;
+		}
+	}
+
+	const bool ok = max_err <= 1e-5;
+
+	std::cout << (ok ? "[ok]   " : "[FAIL] ") << "ldl sizes 1 to 5: " << draws << " draws, max relative residual "
+		<< std::scientific << std::setprecision(2) << max_err << std::endl;
+
+	return ok;
+}
+
+/*!
+@brief  Matrix kernels against the reference loops
+@param  draws   Random operands per shape
+@return true if every result agrees within 1e-4 relative, the round-off of a 512-term float sum
+*/
+bool checkSimd(int draws)
+{
+	std::mt19937 rng(2);
+	double max_err = 0;
+
+	for(int d = 0; d < draws; ++d)
+	{
+		const double errors[] =
+		{
+			productError<5,5,5>(rng), productError<16,16,16>(rng), productError<20,17,19>(rng),
+			productError<40,37,1>(rng), productError<8,8,1>(rng),
+			multTrError<34,5,5>(rng), multTrError<40,20,20>(rng), multTrError<80,19,1>(rng),
+			dotError<15>(rng), dotError<67>(rng), dotError<512>(rng)
+		};
+
+		for(double e : errors)
+		{
+			max_err = e > max_err ? e : max_err;
+		}
+	}
+
+	const bool ok = max_err <= 1e-4;
+#ifdef MATRIX_SIMD
+	const char *kernels = MATRIX_SIMD;
+#else
+	const char *kernels = "scalar";
+#endif
+
+	std::cout << (ok ? "[ok]   " : "[FAIL] ") << "simd " << kernels << " against the reference loops: 11 shapes, " << draws
+		<< " draws, max relative error " << std::scientific << std::setprecision(2) << max_err << std::endl;
+
+	return ok;
+}
+
+} // namespace
+
+/*!
+@brief  Usage: check_generic_dense
+*/
+int main()
+{
+	bool ok = true;
+
+	ok &= checkColdStart(200, 10000);
+	ok &= checkColdStart(1000, 10000);
+	ok &= checkBatch(20, 500);
+	ok &= checkInexact(200, 1000);
+	ok &= checkRiccati<CONSTRAINTS, L, V>("generated plant", generatedPlant(), 200, 10000, 1e-3);
+	ok &= checkRiccati<CONSTRAINT_ALL, 10, mpcConstraintRows(CONSTRAINT_ALL, N, M, 10)>("states bounded to 3", boundedPlant(3), 5, 10000, 1e-2);
+	ok &= checkLdl(1000);
+	ok &= checkSimd(1000);
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,864 @@
+#include "mpc/systems/hls_generic_dense.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "mpc/explicit_mpc.hpp"
+#include "mpc/mpc_constraints.hpp"
+#include "mpc/mpc_dense.hpp"
+#include "mpc/generic_dense_init.hpp"
+#include "mpc/generic_dense_cosim.hpp"
+
+/*!
+@file   explicit_generic_dense.cpp
+@brief  Offline generator of the explicit MPC region table of the generated system.
+
+The QP of mpc_dense, min 0.5 u'*Hcal*u + (h_base*x0nau)'*u s.t. Mx*u <= cx(x0nau), is a multiparametric QP in x0nau.
+For every active set A with linearly independent rows of Mx, the KKT conditions give u and the multipliers as affine
+functions of x0nau. The critical region of A is where the inactive constraints hold and the multipliers are
+non-negative. Empty regions, found with a Chebyshev ball LP, are dropped. The remaining ones are written as
+__explicit_table, with the round-off of the elimination zeroed, then validated along the cosim trajectory and on random
+states in the search box against two cold-started mpc_dense: a long fixed-centering solve, and the configured solver with
+MPC_QP_ALGORITHM.
+*/
+
+namespace
+{
+
+typedef std::vector<double> Vec;
+
+//! Small dense row-major matrix with runtime dimensions, only used offline
+struct Dense
+{
+	Dense(int rows = 0, int cols = 0) : rows(rows), cols(cols), v(rows * cols, 0.0) { }
+
+	double &operator()(int i, int j) { return v[i * cols + j]; }
+	double operator()(int i, int j) const { return v[i * cols + j]; }
+
+	int rows, cols;
+	Vec v;
+};
+
+Dense operator*(const Dense &a, const Dense &b)
+{
+	Dense res(a.rows, b.cols);
+
+	for(int i = 0; i < a.rows; ++i)
+	{
+		for(int k = 0; k < a.cols; ++k)
+		{
+			for(int j = 0; j < b.cols; ++j)
+			{
+				res(i,j) += a(i,k) * b(k,j);
+			}
+		}
+	}
+
+	return res;
+}
+
+Dense operator+(Dense a, const Dense &b)
+{
+	for(size_t i = 0; i < a.v.size(); ++i)
+	{
+		a.v[i] += b.v[i];
+	}
+
+	return a;
+}
+
+Dense operator-(Dense a)
+{
+	for(auto &x : a.v)
+	{
+		x = -x;
+	}
+
+	return a;
+}
+
+Dense transpose(const Dense &a)
+{
+	Dense res(a.cols, a.rows);
+
+	for(int i = 0; i < a.rows; ++i)
+	{
+		for(int j = 0; j < a.cols; ++j)
+		{
+			res(j,i) = a(i,j);
+		}
+	}
+
+	return res;
+}
+
+Dense rows(const Dense &a, const std::vector<int> &idx)
+{
+	Dense res(int(idx.size()), a.cols);
+
+	for(int i = 0; i < res.rows; ++i)
+	{
+		for(int j = 0; j < a.cols; ++j)
+		{
+			res(i,j) = a(idx[i],j);
+		}
+	}
+
+	return res;
+}
+
+/*!
+@brief  Solves A*X = B by Gaussian elimination with partial pivoting
+@return false if A is singular relative to its largest element
+*/
+bool solve(Dense A, Dense B, Dense &X)
+{
+	const int n = A.rows;
+	double scale = 0;
+
+	for(double a : A.v)
+	{
+		scale = std::max(scale, std::fabs(a));
+	}
+
+	for(int c = 0; c < n; ++c)
+	{
+		int p = c;
+
+		for(int i = c + 1; i < n; ++i)
+		{
+			if(std::fabs(A(i,c)) > std::fabs(A(p,c)))
+			{
+				p = i;
+			}
+		}
+
+		if(std::fabs(A(p,c)) <= 1e-10 * scale)
+		{
+			return false;
+		}
+
+		for(int j = 0; j < n; ++j)
+		{
+			std::swap(A(c,j), A(p,j));
+		}
+
+		for(int j = 0; j < B.cols; ++j)
+		{
+			std::swap(B(c,j), B(p,j));
+		}
+
+		for(int i = 0; i < n; ++i)
+		{
+			if(i == c)
+			{
+				continue;
+			}
+
+			double f = A(i,c) / A(c,c);
+
+			for(int j = c; j < n; ++j)
+			{
+				A(i,j) -= f * A(c,j);
+			}
+
+			for(int j = 0; j < B.cols; ++j)
+			{
+				B(i,j) -= f * B(c,j);
+			}
+		}
+	}
+
+	X = Dense(n, B.cols);
+
+	for(int i = 0; i < n; ++i)
+	{
+		for(int j = 0; j < B.cols; ++j)
+		{
+			X(i,j) = B(i,j) / A(i,i);
+		}
+	}
+
+	return true;
+}
+
+template<int R, int C>
+Dense dense(const Matrix<R,C,double> &m)
+{
+	Dense res(R, C);
+
+	for(int i = 0; i < R; ++i)
+	{
+		for(int j = 0; j < C; ++j)
+		{
+			res(i,j) = m(i,j);
+		}
+	}
+
+	return res;
+}
+
+/*!
+@brief  Dense simplex method: max c'x s.t. A*x <= b, x >= 0. Two phases, Bland's rule against cycling
+*/
+class Simplex
+{
+public:
+	Simplex(const Dense &A, const Vec &b, const Vec &c) :
+		m(A.rows), n(A.cols), B(m), N(n + 1), D(m + 2, Vec(n + 2, 0.0))
+	{
+		for(int i = 0; i < m; ++i)
+		{
+			for(int j = 0; j < n; ++j)
+			{
+				D[i][j] = A(i,j);
+			}
+
+			B[i] = n + i;
+			D[i][n] = -1;
+			D[i][n + 1] = b[i];
+		}
+
+		for(int j = 0; j < n; ++j)
+		{
+			N[j] = j;
+			D[m][j] = -c[j];
+		}
+
+		N[n] = -1;
+		D[m + 1][n] = 1;
+	}
+
+	//! Optimum, -infinity if infeasible and +infinity if unbounded
+	double solve()
+	{
+		int r = 0;
+
+		for(int i = 1; i < m; ++i)
+		{
+			if(D[i][n + 1] < D[r][n + 1])
+			{
+				r = i;
+			}
+		}
+
+		if(D[r][n + 1] < -EPS)
+		{
+			pivot(r, n);
+
+			if(!run(1) || D[m + 1][n + 1] < -EPS)
+			{
+				return -std::numeric_limits<double>::infinity();
+			}
+
+			for(int i = 0; i < m; ++i)
+			{
+				if(B[i] == -1)
+				{
+					int s = -1;
+
+					for(int j = 0; j <= n; ++j)
+					{
+						if(s == -1 || D[i][j] < D[i][s] || (D[i][j] == D[i][s] && N[j] < N[s]))
+						{
+							s = j;
+						}
+					}
+
+					pivot(i, s);
+				}
+			}
+		}
+
+		if(!run(2))
+		{
+			return std::numeric_limits<double>::infinity();
+		}
+
+		return D[m][n + 1];
+	}
+
+private:
+	static constexpr double EPS = 1e-9;
+
+	void pivot(int r, int s)
+	{
+		double inv = 1.0 / D[r][s];
+
+		for(int i = 0; i < m + 2; ++i)
+		{
+			if(i != r)
+			{
+				for(int j = 0; j < n + 2; ++j)
+				{
+					if(j != s)
+					{
+						D[i][j] -= D[r][j] * D[i][s] * inv;
+					}
+				}
+			}
+		}
+
+		for(int j = 0; j < n + 2; ++j)
+		{
+			if(j != s)
+			{
+				D[r][j] *= inv;
+			}
+		}
+
+		for(int i = 0; i < m + 2; ++i)
+		{
+			if(i != r)
+			{
+				D[i][s] *= -inv;
+			}
+		}
+
+		D[r][s] = inv;
+		std::swap(B[r], N[s]);
+	}
+
+	bool run(int phase)
+	{
+		int x = phase == 1 ? m + 1 : m;
+
+		while(true)
+		{
+			int s = -1;
+
+			for(int j = 0; j <= n; ++j)
+			{
+				if(phase == 2 && N[j] == -1)
+				{
+					continue;
+				}
+
+				if(s == -1 || D[x][j] < D[x][s] || (D[x][j] == D[x][s] && N[j] < N[s]))
+				{
+					s = j;
+				}
+			}
+
+			if(D[x][s] > -EPS)
+			{
+				return true;
+			}
+
+			int r = -1;
+
+			for(int i = 0; i < m; ++i)
+			{
+				if(D[i][s] < EPS)
+				{
+					continue;
+				}
+
+				double ratio = D[i][n + 1] / D[i][s];
+				double best = r == -1 ? 0 : D[r][n + 1] / D[r][s];
+
+				if(r == -1 || ratio < best || (ratio == best && B[i] < B[r]))
+				{
+					r = i;
+				}
+			}
+
+			if(r == -1)
+			{
+				return false;
+			}
+
+			pivot(r, s);
+		}
+	}
+
+	int m, n;
+	std::vector<int> B, N;
+	std::vector<Vec> D;
+};
+
+/*!
+@brief  Radius of the largest ball inside {x : G*x <= g, |x_i| <= bound}, negative if the set is empty
+*/
+double chebyshevRadius(const Dense &G, const Vec &g, double bound)
+{
+	const int n = G.cols;
+
+	// Variables z = x + bound >= 0 and the radius r >= 0
+
+	Dense A(G.rows + n + 1, n + 1);
+	Vec b(G.rows + n + 1);
+	Vec c(n + 1, 0.0);
+
+	for(int i = 0; i < G.rows; ++i)
+	{
+		double norm = 0, shift = 0;
+
+		for(int j = 0; j < n; ++j)
+		{
+			A(i,j) = G(i,j);
+			norm += G(i,j) * G(i,j);
+			shift += G(i,j) * bound;
+		}
+
+		A(i,n) = std::sqrt(norm);
+		b[i] = g[i] + shift;
+	}
+
+	for(int j = 0; j < n; ++j)
+	{
+		A(G.rows + j, j) = 1;
+		A(G.rows + j, n) = 1;
+		b[G.rows + j] = 2 * bound;
+	}
+
+	A(G.rows + n, n) = 1;
+	b[G.rows + n] = bound;
+	c[n] = 1;
+
+	return Simplex(A, b, c).solve();
+}
+
+//! Critical region in double precision, see ExplicitRegion
+/*!
+@brief  Zeroes the round-off left by the elimination, entries of a row of [A b] below 1e-9 of its largest one. Exact
+        zeros keep the table readable and the sign of a tautological row such as 0*x <= 200 well defined.
+*/
+void stripRoundOff(Dense &A, Dense &b)
+{
+	for(int i = 0; i < A.rows; ++i)
+	{
+		double scale = std::fabs(b(i,0));
+
+		for(int j = 0; j < A.cols; ++j)
+		{
+			scale = std::max(scale, std::fabs(A(i,j)));
+		}
+
+		for(int j = 0; j < A.cols; ++j)
+		{
+			A(i,j) = std::fabs(A(i,j)) <= 1e-9 * scale ? 0.0 : A(i,j);
+		}
+
+		b(i,0) = std::fabs(b(i,0)) <= 1e-9 * scale ? 0.0 : b(i,0);
+	}
+}
+
+struct Region
+{
+	std::vector<int> active;
+	Dense G, g, K, k;
+	double radius;
+};
+
+/*!
+@brief  Enumerates the active sets of the parametric QP and returns the non-empty critical regions
+@param  H   Hessian of the QP
+@param  F   Linear term, h = F*x0nau
+@param  Mx  Constraints matrix
+@param  c0  Constraints vector at x0nau = 0
+@param  E   Constraints vector slope, cx = c0 + E*x0nau
+@param  m   Number of inputs, rows of the control law kept
+@param  bound   Half side of the box of states where regions are searched
+*/
+std::vector<Region> enumerateRegions(const Dense &H, const Dense &F, const Dense &Mx, const Dense &c0, const Dense &E, int m, double bound)
+{
+	const int n = F.cols;
+	const int nu = H.rows;
+	const int nv = Mx.rows;
+
+	std::vector<Region> regions;
+	Dense Hinv;
+	Dense I(nu, nu);
+
+	for(int i = 0; i < nu; ++i)
+	{
+		I(i,i) = 1;
+	}
+
+	solve(H, I, Hinv);
+
+	// Active sets by increasing size, so the unconstrained region is located first
+
+	for(int size = 0; size <= std::min(nu, nv); ++size)
+	{
+		for(long mask = 0; mask < (1L << nv); ++mask)
+		{
+			if(__builtin_popcountl(mask) != size)
+			{
+				continue;
+			}
+
+			std::vector<int> active, inactive;
+
+			for(int i = 0; i < nv; ++i)
+			{
+				(mask >> i & 1 ? active : inactive).push_back(i);
+			}
+
+			// u = Ku*x + ku, lambda = Kl*x + kl
+
+			Dense Ku = -(Hinv * F), ku(nu, 1);
+			Dense Kl(size, n), kl(size, 1);
+
+			if(size > 0)
+			{
+				Dense MA = rows(Mx, active);
+				Dense S = MA * Hinv * transpose(MA);
+				Dense rhs(size, n + 1);
+				Dense slope = rows(E, active) + MA * Hinv * F;
+				Dense offset = rows(c0, active);
+				Dense sol;
+
+				for(int i = 0; i < size; ++i)
+				{
+					for(int j = 0; j < n; ++j)
+					{
+						rhs(i,j) = -slope(i,j);
+					}
+
+					rhs(i,n) = -offset(i,0);
+				}
+
+				if(!solve(S, rhs, sol))
+				{
+					continue;  // Linearly dependent active constraints
+				}
+
+				for(int i = 0; i < size; ++i)
+				{
+					for(int j = 0; j < n; ++j)
+					{
+						Kl(i,j) = sol(i,j);
+					}
+
+					kl(i,0) = sol(i,n);
+				}
+
+				Dense HM = Hinv * transpose(MA);
+				Ku = -(Hinv * F) + -(HM * Kl);
+				ku = -(HM * kl);
+			}
+
+			// Inactive: Mx_i*u <= c0_i + E_i*x. Active: -lambda <= 0
+
+			Region r;
+			r.active = active;
+			r.G = Dense(nv, n);
+			r.g = Dense(nv, 1);
+
+			int row = 0;
+
+			for(int i : inactive)
+			{
+				for(int j = 0; j < n; ++j)
+				{
+					double s = -E(i,j);
+
+					for(int l = 0; l < nu; ++l)
+					{
+						s += Mx(i,l) * Ku(l,j);
+					}
+
+					r.G(row,j) = s;
+				}
+
+				double s = c0(i,0);
+
+				for(int l = 0; l < nu; ++l)
+				{
+					s -= Mx(i,l) * ku(l,0);
+				}
+
+				r.g(row++,0) = s;
+			}
+
+			for(int i = 0; i < size; ++i)
+			{
+				for(int j = 0; j < n; ++j)
+				{
+					r.G(row,j) = -Kl(i,j);
+				}
+
+				r.g(row++,0) = kl(i,0);
+			}
+
+			stripRoundOff(r.G, r.g);
+			r.radius = chebyshevRadius(r.G, r.g.v, bound);
+
+			if(!(r.radius > 1e-9 * bound))
+			{
+				continue;
+			}
+
+			r.K = Dense(m, n);
+			r.k = Dense(m, 1);
+
+			for(int i = 0; i < m; ++i)
+			{
+				for(int j = 0; j < n; ++j)
+				{
+					r.K(i,j) = Ku(i,j);
+				}
+
+				r.k(i,0) = ku(i,0);
+			}
+
+			stripRoundOff(r.K, r.k);
+
+			regions.push_back(r);
+		}
+	}
+
+	return regions;
+}
+
+/*!
+@brief  Solves the QP of the generated system from a cold start
+*/
+template<Solvers solver, int qpiter, bool early_exit, PdipAlgorithm algorithm>
+Matrix<M,1> solveQp(Matrix<N,1> &x)
+{
+	static const auto AL = Matrix<N,N>(__init_condensed.AL);
+	static const auto Acal = Matrix<N*L,N>(__init_condensed.Acal);
+	static const auto Hcal = Matrix<M*L,M*L>(__init_condensed.Hcal);
+	static const auto h_base = Matrix<M*L,N>(__init_condensed.h_base);
+	static const auto Mx = Matrix<V,M*L>(__init_condensed.Mx);
+	static const auto umin = Matrix<M,1>(__init_umin);
+	static const auto umax = Matrix<M,1>(__init_umax);
+	static const auto xmin = Matrix<N,1>(__init_xmin);
+	static const auto xmax = Matrix<N,1>(__init_xmax);
+	static const auto Nxmin = Matrix<N,1>(__init_Nxmin);
+	static const auto Nxmax = Matrix<N,1>(__init_Nxmax);
+	static const auto xinfy = Matrix<N,1>(0.0);
+	static const auto uinfy = Matrix<M,1>(0.0);
+
+	auto cx = Matrix<V,1>(__init_condensed.cx);
+	Matrix<M,1> u;
+
+	mpc_dense<solver, CONSTRAINTS, L, false, qpiter, TOL, early_exit, EXIT_TOL, algorithm>(
+		AL,
+		Acal, Hcal, Mx,
+		umin, umax, uinfy,
+		xmin, xmax, xinfy,
+		Nxmin, Nxmax,
+		h_base,
+		cx, x, u
+	);
+
+	return u;
+}
+
+void writeTable(std::ostream &os, const std::vector<Region> &regions)
+{
+	os << "#include \"../mpc/generic_dense_init.hpp\"\n\n";
+	os << "// Generated by explicit_generic_dense, do not edit\n\n";
+	os << "static_assert(MPC_EXPLICIT_REGIONS >= " << regions.size()
+		<< ", \"Set MPC_EXPLICIT_REGIONS to at least " << regions.size() << "\");\n\n";
+	os << "const int __explicit_regions = " << regions.size() << ";\n";
+	os << "const float __explicit_table[MPC_EXPLICIT_REGIONS*(MPC_V*MPC_N + MPC_V + MPC_M*MPC_N + MPC_M)] = {\n";
+	os << std::setprecision(9);
+
+	for(size_t r = 0; r < regions.size(); ++r)
+	{
+		const Region &reg = regions[r];
+		Vec values;
+
+		values.insert(values.end(), reg.G.v.begin(), reg.G.v.end());
+		values.insert(values.end(), reg.g.v.begin(), reg.g.v.end());
+		values.insert(values.end(), reg.K.v.begin(), reg.K.v.end());
+		values.insert(values.end(), reg.k.v.begin(), reg.k.v.end());
+
+		os << "\t// Active set {";
+
+		for(size_t i = 0; i < reg.active.size(); ++i)
+		{
+			os << (i ? "," : "") << reg.active[i];
+		}
+
+		os << "}\n\t";
+
+		for(size_t i = 0; i < values.size(); ++i)
+		{
+			os << float(values[i]) << (i + 1 < values.size() || r + 1 < regions.size() ? "," : "");
+		}
+
+		os << "\n";
+	}
+
+	os << "};\n";
+}
+
+} // namespace
+
+/*!
+@brief  Usage: explicit_generic_dense [output.cpp] [bound]
+*/
+int main(int argc, char **argv)
+{
+	const char *path = argc > 1 ? argv[1] : "src/autogen/explicit_" MPC_NAME_STR ".cpp";
+
+	// Box of states where regions are searched and the table is validated
+
+	const double bound = argc > 2 ? std::atof(argv[2]) : 1000;
+
+	// Parametric QP data
+
+	const auto AL = Matrix<N,N>(__init_condensed.AL).cast<double>();
+	const auto Acal = Matrix<N*L,N>(__init_condensed.Acal).cast<double>();
+	const auto umin = Matrix<M,1>(__init_umin).cast<double>();
+	const auto umax = Matrix<M,1>(__init_umax).cast<double>();
+	const auto xmin = Matrix<N,1>(__init_xmin).cast<double>();
+	const auto xmax = Matrix<N,1>(__init_xmax).cast<double>();
+	const auto Nxmin = Matrix<N,1>(__init_Nxmin).cast<double>();
+	const auto Nxmax = Matrix<N,1>(__init_Nxmax).cast<double>();
+	const auto zero_u = Matrix<M,1,double>(0.0);
+	const auto zero_x = Matrix<N,1,double>(0.0);
+
+	auto cxAt = [&](const Matrix<N,1,double> &x0nau)
+	{
+		auto cx = Matrix<V,1>(__init_condensed.cx).cast<double>();
+		updateConstraintsVector<CONSTRAINTS, false, N, M, L>(AL, Acal, x0nau, umin, umax, zero_u, xmin, xmax, zero_x, Nxmin, Nxmax, cx);
+		return dense(cx);
+	};
+
+	const Dense H = dense(Matrix<M*L,M*L>(__init_condensed.Hcal).cast<double>());
+	const Dense F = dense(Matrix<M*L,N>(__init_condensed.h_base).cast<double>());
+	const Dense Mx = dense(Matrix<V,M*L>(__init_condensed.Mx).cast<double>());
+	const Dense c0 = cxAt(zero_x);
+	Dense E(V, N);
+
+	for(int j = 0; j < N; ++j)
+	{
+		Matrix<N,1,double> ej(0.0);
+		ej(j,0) = 1;
+		Dense cj = cxAt(ej);
+
+		for(int i = 0; i < V; ++i)
+		{
+			E(i,j) = cj(i,0) - c0(i,0);
+		}
+	}
+
+	if(V > 24)
+	{
+		std::cerr << "Too many constraints to enumerate the active sets: " << V << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::vector<Region> regions = enumerateRegions(H, F, Mx, c0, E, M, bound);
+
+	std::cout << "Regions: " << regions.size() << " (states searched in |x| <= " << bound << ")" << std::endl;
+
+	if(int(regions.size()) > MPC_EXPLICIT_REGIONS)
+	{
+		std::cerr << "[!] WARNING: MPC_EXPLICIT_REGIONS must be raised to " << regions.size() << std::endl;
+	}
+
+	std::ofstream out(path);
+
+	if(!out)
+	{
+		std::cerr << "Cannot open " << path << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	writeTable(out, regions);
+	std::cout << "Table written to " << path << std::endl;
+
+	// Validate against the QP solver
+
+	std::vector<float> flat;
+
+	for(const Region &r : regions)
+	{
+		for(const Dense *d : {&r.G, &r.g, &r.K, &r.k})
+		{
+			flat.insert(flat.end(), d->v.begin(), d->v.end());
+		}
+	}
+
+	constexpr int CAP = 64;
+	const ExplicitTable<CAP,N,M,V> table(flat.data(), int(regions.size()));
+
+	std::vector<Matrix<N,1>> states;
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> dist(-bound, bound);
+
+	const TrajectoryView cosim = cosimTrajectory();
+
+	for(long i = 0; i < cosim.samples; ++i)
+	{
+		states.push_back(Matrix<N,1>(cosim.x(i)));
+	}
+
+	for(int i = 0; i < 10000; ++i)
+	{
+		Matrix<N,1> x;
+
+		for(int j = 0; j < N; ++j)
+		{
+			x(j,0) = dist(rng);
+		}
+
+		states.push_back(x);
+	}
+
+	// Accuracy against a long fixed-centering solve, as the QP is cold started far from the solution on large states,
+	// and against the configured solver and algorithm, the one the table replaces
+
+	constexpr Solvers QP_SOLVER = SOLVER == EXPLICIT ? CHOLESKY : SOLVER;
+	double max_err = 0, max_err_cfg = 0;
+	int misses = 0;
+
+	for(auto &x : states)
+	{
+		Matrix<M,1> u_exp(0.0);
+		Matrix<M,1> u_qp = solveQp<CHOLESKY, 10*QP_ITER, false, PDIP_FIXED_CENTERING>(x);
+		Matrix<M,1> u_cfg = solveQp<QP_SOLVER, QP_ITER, EARLY_EXIT, QP_ALGORITHM>(x);
+
+		misses += explicitLocate(table, x, u_exp) < 0;
+
+		for(int i = 0; i < M; ++i)
+		{
+			max_err = std::max(max_err, double(std::fabs(u_exp(i,0) - u_qp(i,0)) / (1 + std::fabs(u_qp(i,0)))));
+			max_err_cfg = std::max(max_err_cfg, double(std::fabs(u_exp(i,0) - u_cfg(i,0)) / (1 + std::fabs(u_cfg(i,0)))));
+		}
+	}
+
+	std::cout << "Validation on " << states.size() << " states: " << misses << " outside the table, max relative |du| "
+		<< std::scientific << std::setprecision(2) << max_err << " against fixed centering, " << max_err_cfg << " against the configured "
+		<< (QP_ALGORITHM == PDIP_MEHROTRA ? "mehrotra" : "fixed centering") << " solve" << std::endl;
+
+	// Latency against the configured solver, cold started
+
+	double explicit_ns = 0, qp_ns = 0;
+
+	for(auto &x : states)
+	{
+		Matrix<M,1> u;
+
+		auto t0 = std::chrono::steady_clock::now();
+		explicitLocate(table, x, u);
+		auto t1 = std::chrono::steady_clock::now();
+		u = solveQp<QP_SOLVER, QP_ITER, EARLY_EXIT, QP_ALGORITHM>(x);
+		auto t2 = std::chrono::steady_clock::now();
+
+		explicit_ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+		qp_ns += std::chrono::duration<double, std::nano>(t2 - t1).count();
+	}
+
+	std::cout << std::fixed << std::setprecision(1) << "Mean ns per call: explicit " << explicit_ns / states.size()
+		<< ", mpc_dense " << qp_ns / states.size() << std::endl;
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,117 @@
+#include "mpc/systems/hls_generic_dense.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "mpc/mpc_controller.hpp"
+#include "mpc/scheduler.hpp"
+#include "mpc/generic_dense_init.hpp"
+#include "mpc/generic_dense_cosim.hpp"
+
+/*!
+@file   fleet_generic_dense.cpp
+@brief  Closed loop of many simulated motors on one host, one GenericDenseController per motor.
+
+Every sample period the PeriodicScheduler steps all controllers and plants on a pool of worker threads, then reports
+throughput, missed deadlines and the load of every worker.
+*/
+
+namespace
+{
+
+struct Motor
+{
+	Motor(const GenericDenseModel &model, const Matrix<N,1> &x0) : controller(model, WARM_START), x(x0) { }
+
+	GenericDenseController controller;
+	Matrix<N,1> x;
+};
+
+void report(const SchedulerStats &stats, int motors, double period_ns)
+{
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "Periods: " << stats.periods << ", solves: " << stats.jobs
+		<< ", solves/s: " << std::setprecision(0) << stats.jobs / (stats.elapsed_ns * 1e-9) << std::endl;
+	std::cout << std::setprecision(1)
+		<< "Missed deadlines: " << stats.missed << " (" << 100.0 * stats.missed / (stats.jobs ? stats.jobs : 1) << "%)"
+		<< ", overrun periods: " << stats.overruns
+		<< ", worst latency: " << stats.max_latency_ns * 1e-3 << " us of " << period_ns * 1e-3 << " us" << std::endl;
+	std::cout << "Mean solve: " << std::setprecision(3);
+
+	double busy = 0;
+
+	for(const auto &w : stats.workers)
+	{
+		busy += w.busy_ns;
+	}
+
+	std::cout << busy / (stats.jobs ? stats.jobs : 1) * 1e-3 << " us, motors per worker: "
+		<< double(motors) / stats.workers.size() << std::endl << std::endl;
+
+	std::cout << std::left << std::setw(8) << "worker" << std::setw(6) << "cpu" << std::right
+		<< std::setw(12) << "solves" << std::setw(10) << "steals" << std::setw(10) << "load %" << std::endl;
+
+	for(size_t w = 0; w < stats.workers.size(); ++w)
+	{
+		const WorkerStats &s = stats.workers[w];
+
+		std::cout << std::left << std::setw(8) << w << std::setw(6) << s.cpu << std::right
+			<< std::setw(12) << s.jobs << std::setw(10) << s.steals
+			<< std::setw(10) << std::setprecision(1) << 100.0 * s.busy_ns / stats.elapsed_ns << std::endl;
+	}
+}
+
+} // namespace
+
+/*!
+@brief  Usage: fleet_generic_dense [motors] [workers] [period_us] [periods]
+*/
+int main(int argc, char **argv)
+{
+	const int motors = argc > 1 ? std::atoi(argv[1]) : 1000;
+	const int hw = int(std::thread::hardware_concurrency());
+	const int workers = argc > 2 ? std::atoi(argv[2]) : (hw > 0 ? hw : 1);
+	const double period_us = argc > 3 ? std::atof(argv[3]) : 1000;
+	const long periods = argc > 4 ? std::atol(argv[4]) : 1000;
+
+	if(motors < 1 || workers < 1 || period_us <= 0 || periods < 1)
+	{
+		std::cerr << "Usage: " << argv[0] << " [motors] [workers] [period_us] [periods]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	const GenericDenseModel model = genericDenseModel();
+	const auto A = Matrix<N,N>(__init_A);
+	const auto B = Matrix<N,M>(__init_B);
+	const auto x0 = Matrix<N,1>(__cosim_x0);
+
+	// Spread the initial states, so the solvers take different iterations
+
+	std::vector<Motor> fleet;
+	fleet.reserve(motors);
+
+	for(int i = 0; i < motors; ++i)
+	{
+		fleet.emplace_back(model, x0 * (float(i % 17) / 8 - 1));
+	}
+
+	std::cout << "Motors: " << motors << ", workers: " << workers << ", period: " << period_us << " us" << std::endl;
+
+	const auto period = std::chrono::nanoseconds(long(period_us * 1e3));
+	PeriodicScheduler scheduler(motors, workers, period);
+
+	SchedulerStats stats = scheduler.run(periods, [&](int i)
+	{
+		Motor &m = fleet[i];
+		Matrix<M,1> u = m.controller.step(m.x);
+		m.x = A * m.x + B * u;
+	});
+
+	report(stats, motors, period.count());
+
+	return EXIT_SUCCESS;
+}
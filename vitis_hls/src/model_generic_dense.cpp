@@ -0,0 +1,223 @@
+#include "mpc/systems/hls_generic_dense.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mpc/dyn_mpc.hpp"
+#include "mpc/mpc_controller.hpp"
+#include "mpc/generic_dense_init.hpp"
+#include "mpc/generic_dense_cosim.hpp"
+
+/*!
+@file   model_generic_dense.cpp
+@brief  Writes the generated system as a model file for the runtime-dimensioned engine, dyn_mpc.hpp.
+
+The file is mapped back and the closed loop of the cosim run is replayed with DynMpcController and with the static
+MpcController, both with CHOLESKY and the settings of generic_dense_defaults.hpp, reporting the largest difference of
+the inputs. A copy with a horizon beyond MPC_MODEL_MAX_VALUES must be rejected with MODEL_BAD_SIZE before anything is
+allocated. Further model files given on the command line are mapped next to it and run for a few cycles, one
+controller per model, to show a single process hosting models of different sizes.
+*/
+
+namespace
+{
+
+typedef MpcController<GenericDenseModel, CHOLESKY, CONSTRAINTS, TRACK_REF, QP_ITER, TOL, EARLY_EXIT, EXIT_TOL, QP_ALGORITHM> StaticController;
+
+const char *statusName(MpcModelStatus status)
+{
+	switch(status)
+	{
+		case MODEL_OK: return "ok";
+		case MODEL_OPEN_FAILED: return "cannot open";
+		case MODEL_BAD_MAGIC: return "not a model file";
+		case MODEL_BAD_VERSION: return "unsupported version";
+		default: return "inconsistent or too large sizes";
+	}
+}
+
+DynMpcOptions defaultOptions()
+{
+	DynMpcOptions options;
+
+	options.qpiter = QP_ITER;
+	options.early_exit = EARLY_EXIT;
+	options.exit_tol = EXIT_TOL;
+	options.algorithm = QP_ALGORITHM;
+	options.track_ref = TRACK_REF;
+	options.warm_start = WARM_START;
+
+	return options;
+}
+
+/*!
+@brief  Replays the cosim closed loop with both engines
+@return Largest |u_dynamic - u_static|
+*/
+double validate(const DynMpcModel<float> &dyn_model)
+{
+	const GenericDenseModel model = genericDenseModel();
+	const auto A = Matrix<N,N>(__init_A);
+	const auto B = Matrix<N,M>(__init_B);
+
+	StaticController reference(model, WARM_START);
+	DynMpcController<float> controller(dyn_model, defaultOptions());
+
+	const TrajectoryView ref = cosimTrajectory();
+	Matrix<N,1> x(ref.x0);
+	double max_du = 0;
+
+	for(long i = 0; i < ref.samples; ++i)
+	{
+#if MPC_TRACK_REF
+		Matrix<P,1> y_ref(ref.yref(i));
+		reference.setReference(y_ref);
+		controller.setReference(ref.yref(i));
+#endif
+		Matrix<M,1> u = reference.step(x);
+		float u_dyn[M];
+
+		controller.step(&x(0,0), u_dyn);
+
+		for(int j = 0; j < M; ++j)
+		{
+			double du = std::fabs(double(u_dyn[j]) - double(u(j,0)));
+			max_du = du > max_du ? du : max_du;
+		}
+
+		x = A * x + B * u;
+	}
+
+	return max_du;
+}
+
+/*!
+@brief  Writes the model with a horizon of 4096, within the header checks but beyond MPC_MODEL_MAX_VALUES, and maps it
+@return Status of the mapped file, MODEL_BAD_SIZE when the limits hold
+*/
+MpcModelStatus openOversized(const std::string &path, MpcModelView view)
+{
+	view.L = 4096;
+
+	if(!writeMpcModelFile(path.c_str(), view))
+	{
+		return MODEL_OPEN_FAILED;
+	}
+
+	const MpcModelStatus status = MpcModelFile(path.c_str()).status();
+	std::remove(path.c_str());
+
+	return status;
+}
+
+/*!
+@brief  Closed loop of a mapped model from x0 = 1 for a few cycles
+*/
+void run(const MpcModelView &view)
+{
+	DynMpcModel<float> model(view);
+	DynMpcController<float> controller(model, defaultOptions());
+
+	std::vector<float> x(view.N, 1.0f), x_next(view.N), u(view.M);
+	int iterations = 0;
+
+	for(int k = 0; k < 50; ++k)
+	{
+		controller.step(x.data(), u.data());
+		iterations += controller.result().iterations;
+
+		for(int i = 0; i < view.N; ++i)
+		{
+			float sum = 0;
+
+			for(int j = 0; j < view.N; ++j)
+			{
+				sum += view.A[i*view.N + j] * x[j];
+			}
+
+			for(int j = 0; j < view.M; ++j)
+			{
+				sum += view.B[i*view.M + j] * u[j];
+			}
+
+			x_next[i] = sum;
+		}
+
+		x.swap(x_next);
+	}
+
+	std::cout << std::left << std::setw(20) << view.name << std::right
+		<< std::setw(4) << view.N << std::setw(4) << view.M << std::setw(4) << view.L << std::setw(5) << view.V()
+		<< std::setw(12) << model.bytes() + controller.bytes()
+		<< std::setw(10) << std::fixed << std::setprecision(1) << iterations / 50.0 << std::endl;
+}
+
+} // namespace
+
+/*!
+@brief  Usage: model_generic_dense <output.mpcm> [other.mpcm ...]
+*/
+int main(int argc, char **argv)
+{
+	if(argc < 2)
+	{
+		std::cerr << "Usage: " << argv[0] << " <output.mpcm> [other.mpcm ...]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	const MpcModelView generated =
+	{
+		N, M, P, L, CONSTRAINTS, MPC_NAME_STR,
+		__init_A, __init_B, __init_Q, __init_R, __init_P,
+		__init_umin, __init_umax, __init_xmin, __init_xmax, __init_Nxmin, __init_Nxmax,
+		__init_Lx, __init_Lu
+	};
+
+	if(!writeMpcModelFile(argv[1], generated))
+	{
+		std::cerr << "Cannot write " << argv[1] << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// Every file stays mapped while its model is in use
+
+	std::vector<std::unique_ptr<MpcModelFile>> files;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		files.emplace_back(new MpcModelFile(argv[i]));
+
+		if(files.back()->status() != MODEL_OK)
+		{
+			std::cerr << argv[i] << ": " << statusName(files.back()->status()) << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	const DynMpcModel<float> model(files[0]->view());
+	const double max_du = validate(model);
+	const MpcModelStatus oversized = openOversized(std::string(argv[1]) + ".oversized", generated);
+
+	std::cout << "Wrote " << argv[1] << ", version " << MPC_MODEL_VERSION << ", "
+		<< sizeof(MpcModelHeader) + mpcModelPayload(N, M, P) * sizeof(float) << " bytes" << std::endl;
+	std::cout << "Dynamic against static controller over " << cosimTrajectory().samples << " cycles, max |du| = "
+		<< std::scientific << std::setprecision(2) << max_du << std::endl;
+	std::cout << "Horizon of 4096: " << statusName(oversized) << std::endl << std::endl;
+
+	std::cout << std::left << std::setw(20) << "model" << std::right
+		<< std::setw(4) << "N" << std::setw(4) << "M" << std::setw(4) << "L" << std::setw(5) << "V"
+		<< std::setw(12) << "bytes" << std::setw(10) << "iters" << std::endl;
+
+	for(const auto &file : files)
+	{
+		run(file->view());
+	}
+
+	return max_du <= 1e-3 && oversized == MODEL_BAD_SIZE ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -2,22 +2,28 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <vector>
 
+#include "MatrixExpr.hpp"
+#include "matrix_simd.hpp"
+
 /*!
 @file   Matrix.hpp
 */
 
 /*!
-@brief A class support for matrices
+@brief A class support for matrices. Arithmetic operators return lazy expressions (see MatrixExpr.hpp) that are
+       evaluated when assigned to a Matrix.
 @tparam N number of rows
 @tparam M number of columns
 @tparam T Data type. float as default
 */
 template<int N, int M, typename T = float>
-class Matrix
+class Matrix : public MatrixExpr<Matrix<N,M,T>, N, M, T>
 {
 public:
     /*!
@@ -32,20 +38,7 @@ public:
     */
 	Matrix(T init, bool diagonal = false)
 	{
-		for(int i = 0; i < N; i++)
-		{
-			for(int j = 0; j < M; ++j)
-			{
-				if(!diagonal || i == j)
-				{
-					m_values[i][j] = init;
-				}
-				else
-				{
-					m_values[i][j] = 0;
-				}
-			}
-		}
+		MatrixForEach<N,M>::run([&](int i, int j) { m_values[i][j] = !diagonal || i == j ? init : T(0); });
 	}
     /*!
     @brief Creates a matrix using 1-D array elements
@@ -84,6 +77,15 @@ public:
 		}
 	}
     /*!
+    @brief Evaluates an expression into a new matrix
+    @param expr Expression to evaluate
+    */
+	template<typename E>
+	Matrix(const MatrixExpr<E,N,M,T> &expr)
+	{
+		assign(expr);
+	}
+    /*!
     @brief Extracts a value from matrix
     @param row
     @param column
@@ -110,124 +112,66 @@ public:
 		return m_values[row][column];
 	}
     /*!
-    @brief Allow assignment as matrix copy
-    @param rhs Right hand of the assignment. Assigned matrix
-    @return Asigned matrix
+    @brief Row-major contiguous storage, used by the vector kernels
     */
-	Matrix<N,M,T> &operator=(const Matrix<N,M,T> &rhs)
+	T *data()
 	{
-		for(int i = 0; i < N; ++i)
-		{
-			for(int j = 0; j < M; ++j)
-			{
-				m_values[i][j] = rhs(i,j);
-			}
-		}
+		return &m_values[0][0];
+	}
 
-		return *this;
+	const T *data() const
+	{
+		return &m_values[0][0];
 	}
     /*!
-    @brief Overloaded member function. Provided by convenience.
-    @param rhs Value to assign to every matrix slot
-    @return Asigned matrix
+    @brief Element access used by the expressions
     */
-	Matrix<N,M,T> &operator=(const T &rhs)
+	T coeff(int row, int column) const
 	{
-		for(int i = 0; i < N; ++i)
-		{
-			for(int j = 0; j < M; ++j)
-			{
-				m_values[i][j] = rhs;
-			}
-		}
-
-		return *this;
+		return m_values[row][column];
 	}
     /*!
-    @brief Matrix negative operator
-    @return Matrix with inverted sign
+    @brief Allow assignment as matrix copy
+    @param rhs Right hand of the assignment. Assigned matrix
+    @return Asigned matrix
     */
-	Matrix<N,M,T> operator-() const
+	Matrix<N,M,T> &operator=(const Matrix<N,M,T> &rhs)
 	{
-		Matrix<N,M,T> res;
-
-		for(int i = 0; i < N; ++i)
-		{
-			for(int j = 0; j < M; ++j)
-			{
-				res(i,j) = -m_values[i][j];
-			}
-		}
+		MatrixForEach<N,M>::run([&](int i, int j) { m_values[i][j] = rhs(i,j); });
 
-		return res;
+		return *this;
 	}
-
-	// Matrix-Matrix operations
-	/*!
-    @brief Matrix add operator
-    @param rhs Matrix to add
-    @return Matrix sum
+    /*!
+    @brief Expression assignment. Expressions that may read the current matrix after writing it, as x = A * x, are
+           evaluated through a temporary.
+    @param rhs Expression to evaluate
+    @return Asigned matrix
     */
-
-	Matrix<N,M,T> operator+(const Matrix<N,M,T> &rhs) const
+	template<typename E>
+	Matrix<N,M,T> &operator=(const MatrixExpr<E,N,M,T> &rhs)
 	{
-		Matrix<N,M,T> res;
-
-		for(int i = 0; i < N; ++i)
+		if(MatrixExprAlias<E>::value)
 		{
-			for(int j = 0; j < M; ++j)
-			{
-				res(i,j) = m_values[i][j] + rhs(i,j);
-			}
+			Matrix<N,M,T> tmp(rhs);
+			*this = tmp;
 		}
-
-		return res;
-	}
-
-    /*!
-    @brief Matrix difference operator
-    @param rhs Matrix to subtract
-    @return Matrix difference
-    */
-	Matrix<N,M,T> operator-(const Matrix<N,M,T> &rhs) const
-	{
-		Matrix<N,M,T> res;
-
-		for(int i = 0; i < N; ++i)
+		else
 		{
-			for(int j = 0; j < M; ++j)
-			{
-				res(i,j) = m_values[i][j] - rhs(i,j);
-			}
+			assign(rhs);
 		}
 
-		return res;
+		return *this;
 	}
     /*!
-    @brief Multiplication operator
-    @tparam P Number of columns of input/right-hand matrix
-    @param rhs Right hand of matrix multiplication
-    @return Result matrix
+    @brief Overloaded member function. Provided by convenience.
+    @param rhs Value to assign to every matrix slot
+    @return Asigned matrix
     */
-	template<int P>
-	Matrix<N,P,T> operator*(const Matrix<M,P,T> &rhs) const
+	Matrix<N,M,T> &operator=(const T &rhs)
 	{
-		Matrix<N,P,T> res;
-
-		for(int i = 0; i < N; ++i)
-		{
-			for(int j = 0; j < P; ++j)
-			{
-				res(i,j) = m_values[i][0] * rhs(0,j);
-
-				for(int k = 1; k < M; ++k)
-				{
-					res(i,j) += m_values[i][k] * rhs(k,j);
-				}
-			}
-		}
+		MatrixForEach<N,M>::run([&](int i, int j) { m_values[i][j] = rhs; });
 
-		return res;
+		return *this;
 	}
 
 	// Self-Matrix operations
@@ -236,117 +180,37 @@ public:
     @brief Matrix add overloaded for convenience
     @param rhs Right side operator. Matrix to be added.
     */
-	Matrix<N,M,T> &operator+=(const Matrix<N,M,T> &rhs)
+	template<typename E>
+	Matrix<N,M,T> &operator+=(const MatrixExpr<E,N,M,T> &rhs)
 	{
-		for(int i = 0; i < N; ++i)
+		if(MatrixExprAlias<E>::value)
 		{
-			for(int j = 0; j < M; ++j)
-			{
-				m_values[i][j] += rhs(i,j);
-			}
+			return *this += Matrix<N,M,T>(rhs);
 		}
 
+		MatrixForEach<N,M>::run([&](int i, int j) { m_values[i][j] += rhs.coeff(i,j); });
+
 		return *this;
 	}
     /*!
     @brief Substract operation overload for convenience
     @param rhs Right-side matrix to substract
     */
-	Matrix<N,M,T> &operator-=(const Matrix<N,M,T> &rhs)
+	template<typename E>
+	Matrix<N,M,T> &operator-=(const MatrixExpr<E,N,M,T> &rhs)
 	{
-		for(int i = 0; i < N; ++i)
+		if(MatrixExprAlias<E>::value)
 		{
-			for(int j = 0; j < M; ++j)
-			{
-				m_values[i][j] -= rhs(i,j);
-			}
+			return *this -= Matrix<N,M,T>(rhs);
 		}
 
+		MatrixForEach<N,M>::run([&](int i, int j) { m_values[i][j] -= rhs.coeff(i,j); });
+
 		return *this;
 	}
 
 	// Matrix-Value operations
 
-	/*!
-    @brief Matrix plus scalar overload for convenience. Allows to add a scalar value for every matrix position
-    @param rhs Scalar value to add to matrix
-    @return Resulting matrix
-    */
-	Matrix<N,M,T> operator+(const T &rhs)
-	{
-		Matrix<N,M> res;
-
-		for(int i = 0; i < N; ++i)
-		{
-			for(int j = 0; j < M; ++j)
-			{
-				res(i,j) = m_values[i][j] + rhs;
-			}
-		}
-
-		return res;
-	}
-    /*!
-    @brief  Matrix minus scalar overload for convenience. Allows to substract a scalar value for every matrix position
-    @param  rhs Scalar value to substract.
-    @return Resulting matrix
-    */
-
-	Matrix<N,M,T> operator-(const T &rhs)
-	{
-		Matrix<N,M,T> res;
-
-		for(int i = 0; i < N; ++i)
-		{
-			for(int j = 0; j < M; ++j)
-			{
-				res(i,j) = m_values[i][j] - rhs;
-			}
-		}
-
-		return res;
-	}
-
-    /*!
-    @brief  Scalar-matrix product overload for convenience
-    @param T Scalar value for matrix multiplication
-    @return Resulting matrix
-    */
-	Matrix<N,M,T> operator*(const T &rhs)
-	{
-		Matrix<N,M,T> res;
-
-		for(int i = 0; i < N; ++i)
-		{
-			for(int j = 0; j < M; ++j)
-			{
-				res(i,j) = m_values[i][j] * rhs;
-			}
-		}
-
-		return res;
-	}
-
-	/*!
-    @brief  Matrix division by scalar for convenience
-    @param  T   Scalar value used to perform matrix division
-    @return Resulting matrix
-    */
-	Matrix<N,M,T> operator/(const T &rhs)
-	{
-		Matrix<N,M,T> res;
-
-		for(int i = 0; i < N; ++i)
-		{
-			for(int j = 0; j < M; ++j)
-			{
-				res(i,j) = m_values[i][j] / rhs;
-			}
-		}
-
-		return res;
-	}
-
 	/*!
     @brief  Power operator for convenience. Computes the power operation for every matrix position
     @param  T   Exponent to power the matrix values
@@ -456,136 +320,49 @@ public:
 
 	// Others
 
-	/*!
-    @brief  Squared sum method. Computes squared sum for every element in current matrix.
-    @return Squared sum.
-    */
-	T squaredSum() const
-	{
-		T res = 0;
-
-		for(int i = 0; i < N; ++i)
-		{
-			for(int j = 0; j < M; ++j)
-			{
-				res += ::pow(m_values[i][j], 2);
-			}
-		}
-
-		return res;
-	}
-
-	/*!
-    @brief  Dot product method. Computes the dot product between the current matrix and the given matrix.
-    @param  rhs Matrix to compute the dot product
-    @return Scalar result of the inner product.
-    */
-	T dot(const Matrix<N,M,T> &rhs) const
-	{
-		T res = 0;
-
-		for(int i = 0; i < N; ++i)
-		{
-			for(int j = 0; j < M; ++j)
-			{
-				res += m_values[i][j] * rhs(i,j);
-			}
-		}
-
-		return res;
-	}
-
     /*!
     @brief  Element-wise multiplication method. The current matrix is updated with the result
     @param  rhs Matrix to perform the element-wise multiplication
     */
-	void emul(const Matrix<N,M,T> &rhs)
+	template<typename E>
+	void emul(const MatrixExpr<E,N,M,T> &rhs)
 	{
-		for(int i = 0; i < N; ++i)
-		{
-			for(int j = 0; j < M; ++j)
-			{
-				m_values[i][j] *= rhs(i,j);
-			}
-		}
+		*this = this->emulCopy(rhs);
 	}
 
     /*!
     @brief  Element-wise divition method. The current matrix is updated with the result.
     @param  rhs Matrix to perform the element-wise divition
     */
-	void ediv(const Matrix<N,M,T> &rhs)
-	{
-		for(int i = 0; i < N; ++i)
-		{
-			for(int j = 0; j < M; ++j)
-			{
-				m_values[i][j] /= rhs(i,j);
-			}
-		}
-	}
-
-    /*!
-    @brief  Element-wise matrix multiplication method.
-    @param  rhs Matrix to perform the element-wise multiplication
-    @return Resulting matrix
-    */
-	Matrix<N,M,T> emulCopy(const Matrix<N,M,T> &rhs) const
+	template<typename E>
+	void ediv(const MatrixExpr<E,N,M,T> &rhs)
 	{
-		Matrix<N,M,T> res;
-
-		for(int i = 0; i < N; ++i)
-		{
-			for(int j = 0; j < M; ++j)
-			{
-				res(i,j) = m_values[i][j] * rhs(i,j);
-			}
-		}
-
-		return res;
-	}
-
-	/*!
-    @brief  Element-wise matrix divition method.
-    @param  rhs Matrix to perform the element-wise divition
-    @return Resulting matrix
-    */
-	Matrix<N,M,T> edivCopy(const Matrix<N,M,T> &rhs) const
-	{
-		Matrix<N,M,T> res;
-
-		for(int i = 0; i < N; ++i)
-		{
-			for(int j = 0; j < M; ++j)
-			{
-				res(i,j) = m_values[i][j] / rhs(i,j);
-			}
-		}
-
-		return res;
+		*this = this->edivCopy(rhs);
 	}
 
 	/*!
-    @brief  Multiply current matrix with the transpose input matrix. This method allows to avoid single tranpose operations by computing multiplication using convenient indexes.
-    @tparam P   Second dimension of the input matrix. Column size of rhs
-    @param  rhs Matrix to be transposed and multiplied
-    @return Result of current matrix by the transpose of the input matrix, rhs.
+    @brief  Scaled Gram product. Computes the transpose of the current matrix by diag(d) by the current matrix without building diag(d).
+            Only the lower triangle is computed, the upper one is mirrored since the result is symmetric.
+    @param  d   Vector with the diagonal elements of the scaling matrix
+    @return MxM symmetric result of current matrix transposed by diag(d) by current matrix.
     */
-	template<int P>
-	Matrix<M,P,T> multTr(const Matrix<N,P,T> &rhs) const
+	Matrix<M,M,T> scaledGram(const Matrix<N,1,T> &d) const
 	{
-		Matrix<M,P,T> res;
+		Matrix<M,M,T> res;
 
 		for(int i = 0; i < M; ++i)
 		{
-			for(int j = 0; j < P; ++j)
+			for(int j = 0; j <= i; ++j)
 			{
-				res(i,j) = m_values[0][i] * rhs(0,j);
+				T sum = m_values[0][i] * d(0,0) * m_values[0][j];
 
 				for(int k = 1; k < N; ++k)
 				{
-					res(i,j) += m_values[k][i] * rhs(k,j);
+					sum += m_values[k][i] * d(k,0) * m_values[k][j];
 				}
+
+				res(i,j) = sum;
+				res(j,i) = sum;
 			}
 		}
 
@@ -612,6 +389,27 @@ public:
 		}
 	}
 
+	/*!
+    @brief  Shifts blocks of a vector one position towards its beginning. The last block is kept unchanged.
+    @tparam begin   Offset of the first block
+    @tparam size    Number of elements of every block
+    @tparam times   Number of blocks
+    */
+	template<int begin, int size, int times>
+	void shift()
+	{
+		static_assert(M == 1, "Must be used on a vector");
+		static_assert(begin >= 0, "Begin offset must be at least 0");
+		static_assert(size > 0, "Number of elements must be at least 1");
+		static_assert(times > 0, "Number of blocks must be at least 1");
+		static_assert(begin + size*times <= N, "Shift overflows the vector");
+
+		for(int i = begin; i < begin + size*(times-1); ++i)
+		{
+			m_values[i][0] = m_values[i+size][0];
+		}
+	}
+
     /*!
     @brief  Power matrix method. Computes the matrix by itself product
     @param  exponent    Times to compute the matrix by itself product.
@@ -650,7 +448,34 @@ public:
 		return res;
 	}
 
+	/*!
+    @brief  Element type conversion method.
+    @tparam U   Destination data type. Must be constructible from T
+    @return Matrix with every element converted to U
+    */
+	template<typename U>
+	Matrix<N,M,U> cast() const
+	{
+		Matrix<N,M,U> res;
+
+		for(int i = 0; i < N; ++i)
+		{
+			for(int j = 0; j < M; ++j)
+			{
+				res(i,j) = static_cast<U>(m_values[i][j]);
+			}
+		}
+
+		return res;
+	}
+
 	T mse(const std::vector<T> &ref) const
+	{
+		return mse(ref.data());
+	}
+
+	//! Mean squared error against N*M row-major values
+	T mse(const T *ref) const
 	{
 		T res = 0.0;
 		int k = 0;
@@ -659,7 +484,7 @@ public:
 		{
 			for(int j = 0; j < M; ++j)
 			{
-				res += ::pow(ref[k] - m_values[j][i], 2) / (N * M);
+				res += ::pow(ref[k] - m_values[i][j], 2) / (N * M);
 				++k;
 			}
 		}
@@ -727,6 +552,61 @@ public:
 		output << std::endl;
 	}
 
+	/*!
+    @brief  Writes the values row by row as little-endian IEEE-754 floats, the payload format of serial_frame.hpp
+    @param  buffer  Destination of 4*N*M bytes
+    @return Number of bytes written
+    */
+	int serialize(unsigned char *buffer) const
+	{
+		for(int i = 0; i < N; i++)
+		{
+			for(int j = 0; j < M; j++)
+			{
+				const float value = static_cast<float>(m_values[i][j]);
+				std::uint32_t bits;
+
+				std::memcpy(&bits, &value, sizeof(bits));
+
+				for(int b = 0; b < 4; ++b)
+				{
+					*buffer++ = static_cast<unsigned char>(bits >> (8*b));
+				}
+			}
+		}
+
+		return 4*N*M;
+	}
+
+	/*!
+    @brief  Reads a matrix written by serialize
+    @param  buffer  Source of 4*N*M bytes
+    @return Matrix with the read values.
+    */
+	static Matrix<N,M,T> deserialize(const unsigned char *buffer)
+	{
+		Matrix<N,M,T> res;
+
+		for(int i = 0; i < N; i++)
+		{
+			for(int j = 0; j < M; j++)
+			{
+				std::uint32_t bits = 0;
+				float value;
+
+				for(int b = 0; b < 4; ++b)
+				{
+					bits |= std::uint32_t(*buffer++) << (8*b);
+				}
+
+				std::memcpy(&value, &bits, sizeof(value));
+				res(i, j) = static_cast<T>(value);
+			}
+		}
+
+		return res;
+	}
+
 	/*!
     @brief  Prints formatted matrix
     */
@@ -751,6 +631,19 @@ public:
 	}
 
 private:
+    /*!
+    @brief  Evaluates an expression into the current matrix
+    */
+	template<typename E>
+	void assign(const MatrixExpr<E,N,M,T> &expr)
+	{
+		MatrixEval<E>::assign(*this, expr);
+	}
+
     //! Array container for matrix values
+#ifdef MATRIX_SIMD
+	alignas(MatrixAlign<N,M,T>::value) T m_values[N][M];
+#else
 	T m_values[N][M];
+#endif
 };
@@ -0,0 +1,531 @@
+#pragma once
+
+#include <utility>
+
+/*!
+@file   MatrixExpr.hpp
+@brief  Lazy matrix expressions. Element-wise operations, scalar operations and products return expression objects that
+        are evaluated in a single fused loop when assigned to a Matrix, so no intermediate matrices are created.
+*/
+
+// Largest number of elements for which matrix visits are unrolled into straight-line code. Host builds with vector
+// units keep the loops, which the compiler vectorises and which measured faster than the unrolled sequences
+#ifndef MATRIX_UNROLL_MAX
+#if !defined(__SYNTHESIS__) && !defined(MATRIX_NO_SIMD) && (defined(__AVX2__) || defined(__ARM_NEON))
+#define MATRIX_UNROLL_MAX 0
+#else
+#define MATRIX_UNROLL_MAX 16
+#endif
+#endif
+
+// Longest inner product of a matrix product unrolled into straight-line code, in every build. Rolled, the reduction of
+// every coefficient is vectorised poorly and the 5x5 and 10x10 products run twice as slow
+#ifndef MATRIX_UNROLL_PRODUCT
+#define MATRIX_UNROLL_PRODUCT 16
+#endif
+
+// Element visitors are inlined with the whole body of the visit, so expressions fold into a single loop or sequence
+#if defined(__GNUC__) && !defined(__SYNTHESIS__)
+#define MATRIX_VISIT inline __attribute__((always_inline, flatten))
+#else
+#define MATRIX_VISIT inline
+#endif
+
+template<int N, int M, typename T>
+class Matrix;
+
+template<typename E>
+struct MatrixEval;
+
+/*!
+@brief  Base class of every matrix expression, including Matrix itself (CRTP).
+@tparam E   Derived expression type
+@tparam N   Number of rows
+@tparam M   Number of columns
+@tparam T   Data type
+*/
+template<typename E, int N, int M, typename T>
+class MatrixExpr
+{
+public:
+	//! Element type, used to keep scalar arguments out of template deduction
+	using Scalar = T;
+
+	static constexpr int ROWS = N;
+	static constexpr int COLS = M;
+
+	//! Derived expression
+	const E &derived() const
+	{
+		return static_cast<const E&>(*this);
+	}
+
+	/*!
+	@brief  Evaluates a single element of the expression
+	@param  row
+	@param  column
+	@return Value of the expression in the given position
+	*/
+	T coeff(int row, int column) const
+	{
+		return derived().coeff(row, column);
+	}
+
+	/*!
+	@brief  Evaluates the expression into a matrix
+	*/
+	Matrix<N,M,T> eval() const
+	{
+		return Matrix<N,M,T>(*this);
+	}
+
+	/*!
+    @brief  Squared sum method. Computes squared sum for every element in current matrix.
+    @return Squared sum.
+    */
+	T squaredSum() const
+	{
+		return MatrixEval<E>::squaredSum(*this);
+	}
+
+	/*!
+    @brief  Infinity norm method. Computes the largest absolute value of the current matrix elements.
+    @return Maximum absolute value.
+    */
+	T maxAbs() const
+	{
+		return MatrixEval<E>::maxAbs(*this);
+	}
+
+	/*!
+    @brief  Dot product method. Computes the dot product between the current matrix and the given matrix.
+    @param  rhs Matrix to compute the dot product
+    @return Scalar result of the inner product.
+    */
+	template<typename R>
+	T dot(const MatrixExpr<R,N,M,T> &rhs) const
+	{
+		return MatrixEval<E>::dot(*this, rhs);
+	}
+
+	/*!
+    @brief  Element-wise matrix multiplication method.
+    @param  rhs Matrix to perform the element-wise multiplication
+    @return Resulting matrix expression
+    */
+	template<typename R>
+	auto emulCopy(const MatrixExpr<R,N,M,T> &rhs) const;
+
+	/*!
+    @brief  Element-wise matrix divition method.
+    @param  rhs Matrix to perform the element-wise divition
+    @return Resulting matrix expression
+    */
+	template<typename R>
+	auto edivCopy(const MatrixExpr<R,N,M,T> &rhs) const;
+
+	/*!
+    @brief  Multiply current matrix with the transpose input matrix. This method allows to avoid single tranpose operations by computing multiplication using convenient indexes.
+    @tparam P   Second dimension of the input matrix. Column size of rhs
+    @param  rhs Matrix to be transposed and multiplied
+    @return Result of current matrix by the transpose of the input matrix, rhs.
+    */
+	template<typename R, int P>
+	auto multTr(const MatrixExpr<R,N,P,T> &rhs) const;
+};
+
+/*!
+@brief  Compile-time loop over the indices [0, K). run(f) expands into the straight-line sequence f(0), ..., f(K-1).
+*/
+template<int K, typename S = std::make_integer_sequence<int, K>>
+struct MatrixUnroll;
+
+template<int K, int... I>
+struct MatrixUnroll<K, std::integer_sequence<int, I...>>
+{
+	template<typename F>
+	static MATRIX_VISIT void run(F &f)
+	{
+		int expand[] = {0, (f(I), 0)...};
+		(void) expand;
+	}
+};
+
+/*!
+@brief  Visits every position of an NxM matrix in row-major order, calling f(row, column). Matrices up to
+        MATRIX_UNROLL_MAX elements are fully unrolled, so the tiny controllers run without loop counters or branches.
+*/
+template<int N, int M, bool unrolled = (N*M <= MATRIX_UNROLL_MAX)>
+struct MatrixForEach
+{
+	template<typename F>
+	static MATRIX_VISIT void run(F &&f)
+	{
+		for(int i = 0; i < N; ++i)
+		{
+			for(int j = 0; j < M; ++j)
+			{
+				f(i, j);
+			}
+		}
+	}
+};
+
+template<int N, int M>
+struct MatrixForEach<N, M, true>
+{
+	template<typename F>
+	static MATRIX_VISIT void run(F &&f)
+	{
+		auto g = [&f](int k) { f(k / M, k % M); };
+		MatrixUnroll<N*M>::run(g);
+	}
+};
+
+/*!
+@brief  Reference loops evaluating an expression element by element.
+*/
+struct MatrixEvalLoops
+{
+	template<typename E, int N, int M, typename T>
+	static void assign(Matrix<N,M,T> &dst, const MatrixExpr<E,N,M,T> &expr)
+	{
+		MatrixForEach<N,M>::run([&](int i, int j) { dst(i,j) = expr.coeff(i,j); });
+	}
+
+	template<typename E, typename R, int N, int M, typename T>
+	static T dot(const MatrixExpr<E,N,M,T> &lhs, const MatrixExpr<R,N,M,T> &rhs)
+	{
+		T res = 0;
+
+		MatrixForEach<N,M>::run([&](int i, int j) { res += lhs.coeff(i,j) * rhs.coeff(i,j); });
+
+		return res;
+	}
+
+	template<typename E, int N, int M, typename T>
+	static T squaredSum(const MatrixExpr<E,N,M,T> &expr)
+	{
+		T res = 0;
+
+		MatrixForEach<N,M>::run([&](int i, int j)
+		{
+			T v = expr.coeff(i,j);
+			res += v * v;
+		});
+
+		return res;
+	}
+
+	template<typename E, int N, int M, typename T>
+	static T maxAbs(const MatrixExpr<E,N,M,T> &expr)
+	{
+		T res = 0;
+
+		MatrixForEach<N,M>::run([&](int i, int j)
+		{
+			T v = expr.coeff(i,j);
+			v = v < 0 ? -v : v;
+			res = v > res ? v : res;
+		});
+
+		return res;
+	}
+};
+
+/*!
+@brief  Evaluation of an expression of type E into a matrix, and reductions over it. Specialised in matrix_simd.hpp
+        with vector kernels for the host build.
+*/
+template<typename E>
+struct MatrixEval : MatrixEvalLoops
+{ };
+
+/*!
+@brief  Storage of an operand inside an expression node. Matrices are kept by reference, expression nodes by value so
+        that expressions remain valid when stored with auto.
+*/
+template<typename E>
+struct MatrixExprStorage
+{
+	using type = const E;
+};
+
+template<int N, int M, typename T>
+struct MatrixExprStorage<Matrix<N,M,T>>
+{
+	using type = const Matrix<N,M,T>&;
+};
+
+/*!
+@brief  Storage of a product operand. Every element of an operand is read several times by a product, so expression
+        operands are evaluated once into a matrix.
+*/
+template<typename E, int N, int M, typename T>
+struct MatrixProductStorage
+{
+	using type = const Matrix<N,M,T>;
+};
+
+template<int N, int M, typename T>
+struct MatrixProductStorage<Matrix<N,M,T>, N, M, T>
+{
+	using type = const Matrix<N,M,T>&;
+};
+
+/*!
+@brief  True if evaluating E directly into one of its operands may give wrong results, as in x = A * x
+*/
+template<typename E>
+struct MatrixExprAlias
+{
+	static constexpr bool value = E::MAY_ALIAS;
+};
+
+template<int N, int M, typename T>
+struct MatrixExprAlias<Matrix<N,M,T>>
+{
+	static constexpr bool value = false;
+};
+
+// Element-wise operators
+
+struct MatrixAddOp
+{
+	template<typename T>
+	static T apply(const T &a, const T &b) { return a + b; }
+};
+
+struct MatrixSubOp
+{
+	template<typename T>
+	static T apply(const T &a, const T &b) { return a - b; }
+};
+
+struct MatrixMulOp
+{
+	template<typename T>
+	static T apply(const T &a, const T &b) { return a * b; }
+};
+
+struct MatrixDivOp
+{
+	template<typename T>
+	static T apply(const T &a, const T &b) { return a / b; }
+};
+
+/*!
+@brief  Element-wise operation between two expressions of the same size
+*/
+template<typename Op, typename L, typename R, int N, int M, typename T>
+class MatrixBinaryExpr : public MatrixExpr<MatrixBinaryExpr<Op, L, R, N, M, T>, N, M, T>
+{
+public:
+	static constexpr bool MAY_ALIAS = MatrixExprAlias<L>::value || MatrixExprAlias<R>::value;
+
+	MatrixBinaryExpr(const L &lhs, const R &rhs) : m_lhs(lhs), m_rhs(rhs) { }
+
+	T coeff(int row, int column) const
+	{
+		return Op::apply(m_lhs.coeff(row, column), m_rhs.coeff(row, column));
+	}
+
+	const L &lhs() const { return m_lhs; }
+	const R &rhs() const { return m_rhs; }
+
+private:
+	typename MatrixExprStorage<L>::type m_lhs;
+	typename MatrixExprStorage<R>::type m_rhs;
+};
+
+/*!
+@brief  Element-wise operation between an expression and a scalar
+*/
+template<typename Op, typename E, int N, int M, typename T>
+class MatrixScalarExpr : public MatrixExpr<MatrixScalarExpr<Op, E, N, M, T>, N, M, T>
+{
+public:
+	static constexpr bool MAY_ALIAS = MatrixExprAlias<E>::value;
+
+	MatrixScalarExpr(const E &lhs, const T &rhs) : m_lhs(lhs), m_rhs(rhs) { }
+
+	T coeff(int row, int column) const
+	{
+		return Op::apply(m_lhs.coeff(row, column), m_rhs);
+	}
+
+	const E &lhs() const { return m_lhs; }
+	const T &rhs() const { return m_rhs; }
+
+private:
+	typename MatrixExprStorage<E>::type m_lhs;
+	const T m_rhs;
+};
+
+/*!
+@brief  Sign inversion of an expression
+*/
+template<typename E, int N, int M, typename T>
+class MatrixNegateExpr : public MatrixExpr<MatrixNegateExpr<E, N, M, T>, N, M, T>
+{
+public:
+	static constexpr bool MAY_ALIAS = MatrixExprAlias<E>::value;
+
+	explicit MatrixNegateExpr(const E &expr) : m_expr(expr) { }
+
+	T coeff(int row, int column) const
+	{
+		return -m_expr.coeff(row, column);
+	}
+
+private:
+	typename MatrixExprStorage<E>::type m_expr;
+};
+
+/*!
+@brief  Matrix product, L*R. When transpose_lhs is set, computes L'*R without building the transpose.
+*/
+template<bool transpose_lhs, typename L, typename R, int N, int K, int P, typename T>
+class MatrixProductExpr : public MatrixExpr<MatrixProductExpr<transpose_lhs, L, R, N, K, P, T>, N, P, T>
+{
+	static constexpr int LN = transpose_lhs ? K : N;
+	static constexpr int LM = transpose_lhs ? N : K;
+
+public:
+	static constexpr bool MAY_ALIAS = true;
+
+	MatrixProductExpr(const L &lhs, const R &rhs) : m_lhs(lhs), m_rhs(rhs) { }
+
+	T coeff(int row, int column) const
+	{
+		T res = lhsCoeff(row, 0) * m_rhs.coeff(0, column);
+
+		MatrixForEach<1, K-1, (K-1 <= MATRIX_UNROLL_PRODUCT)>::run([&](int, int k) { res += lhsCoeff(row, k+1) * m_rhs.coeff(k+1, column); });
+
+		return res;
+	}
+
+	//! Left operand, evaluated into a matrix
+	const Matrix<LN,LM,T> &lhs() const { return m_lhs; }
+	//! Right operand, evaluated into a matrix
+	const Matrix<K,P,T> &rhs() const { return m_rhs; }
+
+private:
+	T lhsCoeff(int row, int k) const
+	{
+		return transpose_lhs ? m_lhs.coeff(k, row) : m_lhs.coeff(row, k);
+	}
+
+	typename MatrixProductStorage<L, LN, LM, T>::type m_lhs;
+	typename MatrixProductStorage<R, K, P, T>::type m_rhs;
+};
+
+// Member functions returning expressions
+
+template<typename E, int N, int M, typename T>
+template<typename R>
+auto MatrixExpr<E,N,M,T>::emulCopy(const MatrixExpr<R,N,M,T> &rhs) const
+{
+	return MatrixBinaryExpr<MatrixMulOp, E, R, N, M, T>(derived(), rhs.derived());
+}
+
+template<typename E, int N, int M, typename T>
+template<typename R>
+auto MatrixExpr<E,N,M,T>::edivCopy(const MatrixExpr<R,N,M,T> &rhs) const
+{
+	return MatrixBinaryExpr<MatrixDivOp, E, R, N, M, T>(derived(), rhs.derived());
+}
+
+template<typename E, int N, int M, typename T>
+template<typename R, int P>
+auto MatrixExpr<E,N,M,T>::multTr(const MatrixExpr<R,N,P,T> &rhs) const
+{
+	return MatrixProductExpr<true, E, R, M, N, P, T>(derived(), rhs.derived());
+}
+
+// Matrix-Matrix operations
+
+/*!
+@brief Matrix add operator
+@param lhs Left-hand matrix
+@param rhs Matrix to add
+@return Matrix sum expression
+*/
+template<typename L, typename R, int N, int M, typename T>
+MatrixBinaryExpr<MatrixAddOp, L, R, N, M, T> operator+(const MatrixExpr<L,N,M,T> &lhs, const MatrixExpr<R,N,M,T> &rhs)
+{
+	return MatrixBinaryExpr<MatrixAddOp, L, R, N, M, T>(lhs.derived(), rhs.derived());
+}
+
+/*!
+@brief Matrix difference operator
+@param lhs Left-hand matrix
+@param rhs Matrix to subtract
+@return Matrix difference expression
+*/
+template<typename L, typename R, int N, int M, typename T>
+MatrixBinaryExpr<MatrixSubOp, L, R, N, M, T> operator-(const MatrixExpr<L,N,M,T> &lhs, const MatrixExpr<R,N,M,T> &rhs)
+{
+	return MatrixBinaryExpr<MatrixSubOp, L, R, N, M, T>(lhs.derived(), rhs.derived());
+}
+
+/*!
+@brief Multiplication operator
+@tparam P Number of columns of input/right-hand matrix
+@param lhs Left hand of matrix multiplication
+@param rhs Right hand of matrix multiplication
+@return Product expression
+*/
+template<typename L, typename R, int N, int K, int P, typename T>
+MatrixProductExpr<false, L, R, N, K, P, T> operator*(const MatrixExpr<L,N,K,T> &lhs, const MatrixExpr<R,K,P,T> &rhs)
+{
+	return MatrixProductExpr<false, L, R, N, K, P, T>(lhs.derived(), rhs.derived());
+}
+
+/*!
+@brief Matrix negative operator
+@return Expression with inverted sign
+*/
+template<typename E, int N, int M, typename T>
+MatrixNegateExpr<E, N, M, T> operator-(const MatrixExpr<E,N,M,T> &expr)
+{
+	return MatrixNegateExpr<E, N, M, T>(expr.derived());
+}
+
+// Matrix-Value operations
+
+/*!
+@brief Matrix plus scalar. Adds a scalar value to every matrix position
+*/
+template<typename E, int N, int M, typename T>
+MatrixScalarExpr<MatrixAddOp, E, N, M, T> operator+(const MatrixExpr<E,N,M,T> &lhs, const typename MatrixExpr<E,N,M,T>::Scalar &rhs)
+{
+	return MatrixScalarExpr<MatrixAddOp, E, N, M, T>(lhs.derived(), rhs);
+}
+
+/*!
+@brief Matrix minus scalar. Substracts a scalar value from every matrix position
+*/
+template<typename E, int N, int M, typename T>
+MatrixScalarExpr<MatrixSubOp, E, N, M, T> operator-(const MatrixExpr<E,N,M,T> &lhs, const typename MatrixExpr<E,N,M,T>::Scalar &rhs)
+{
+	return MatrixScalarExpr<MatrixSubOp, E, N, M, T>(lhs.derived(), rhs);
+}
+
+/*!
+@brief Scalar-matrix product
+*/
+template<typename E, int N, int M, typename T>
+MatrixScalarExpr<MatrixMulOp, E, N, M, T> operator*(const MatrixExpr<E,N,M,T> &lhs, const typename MatrixExpr<E,N,M,T>::Scalar &rhs)
+{
+	return MatrixScalarExpr<MatrixMulOp, E, N, M, T>(lhs.derived(), rhs);
+}
+
+/*!
+@brief Matrix division by scalar
+*/
+template<typename E, int N, int M, typename T>
+MatrixScalarExpr<MatrixDivOp, E, N, M, T> operator/(const MatrixExpr<E,N,M,T> &lhs, const typename MatrixExpr<E,N,M,T>::Scalar &rhs)
+{
+	return MatrixScalarExpr<MatrixDivOp, E, N, M, T>(lhs.derived(), rhs);
+}
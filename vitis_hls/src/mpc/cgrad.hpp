@@ -16,10 +16,11 @@
 @param  iter_max    Maximum of iterations of the algorithm
 @param  tolerance   Maximum error tolerated by the algorithm
 @param  x   Nx1 vector with the aproximated solution
+@param  iter_cap    Runtime limit of the iterations, below iter_max when a rough solution is enough
 @return Number of iterations performed
 */
 template<int iter_max, int N, typename T = float>
-int cgrad(const Matrix<N,N,T> &A, const Matrix<N,1,T> &b, Matrix<N,1,T> &x0, T tolerance, Matrix<N,1,T> &x)
+int cgrad(const Matrix<N,N,T> &A, const Matrix<N,1,T> &b, Matrix<N,1,T> &x0, T tolerance, Matrix<N,1,T> &x, int iter_cap = iter_max)
 {
 	Matrix<N,1,T> r = b - A*x0;
 	Matrix<N,1,T> d = r;
@@ -32,9 +33,9 @@ int cgrad(const Matrix<N,N,T> &A, const Matrix<N,1,T> &b, Matrix<N,1,T> &x0, T t
 
 	x = x0;
 
-	while(i < iter_max)
+	while(i < iter_max && i < iter_cap)
 	{
-		if(tce <= tolerance) break;
+		if(tce <= tolerance || dw == 0) break;
 
 		q = A*d;
 		alpha = dw / d.dot(q);
@@ -63,3 +64,65 @@ int cgrad(const Matrix<N,N,T> &A, const Matrix<N,1,T> &b, Matrix<N,1,T> &x0, T t
 
 	return i;
 }
+
+/*!
+@brief  Preconditioned conjugate gradient. Solves Ax=b with the search directions conjugated in the inner product of the
+        preconditioner Mp of Pc. Same stopping test as cgrad, on the size of the last step.
+@tparam iter_max    Maximum of iterations of the algorithm
+@tparam Pc  Preconditioner, see precond.hpp
+@param  A   NxN matrix with system coefficients
+@param  b   Nx1 vector with system constant terms
+@param  x0  Nx1 vector with starting points for the algorithm. Updated with the solution
+@param  tolerance   Maximum error tolerated by the algorithm
+@param  F   Preconditioner factorization of A, computed by Pc::factor
+@param  x   Nx1 vector with the aproximated solution
+@param  iter_cap    Runtime limit of the iterations, below iter_max when a rough solution is enough
+@return Number of iterations performed
+*/
+template<int iter_max, typename Pc, int N, typename T = float>
+int pcgrad(const Matrix<N,N,T> &A, const Matrix<N,1,T> &b, Matrix<N,1,T> &x0, T tolerance, const typename Pc::Factor &F, Matrix<N,1,T> &x, int iter_cap = iter_max)
+{
+	Matrix<N,1,T> r = b - A*x0;
+	Matrix<N,1,T> z, q;
+
+	Pc::apply(F, r, z);
+
+	Matrix<N,1,T> d = z;
+	T dw = r.dot(z);
+	T tce = sqrt(r.squaredSum());
+	int i = 0;
+
+	x = x0;
+
+	while(i < iter_max && i < iter_cap)
+	{
+		if(tce <= tolerance || dw == 0) break;
+
+		q = A*d;
+		T alpha = dw / d.dot(q);
+
+		x += d*alpha;
+
+		if((i % 50) == 0)
+		{
+			r = b - A*x;
+		}
+		else
+		{
+			r -= q*alpha;
+		}
+
+		Pc::apply(F, r, z);
+
+		T dl = dw;
+		dw = r.dot(z);
+
+		d = z + d*(dw / dl);
+
+		++i;
+		tce = sqrt((x - x0).squaredSum());
+		x0 = x;
+	}
+
+	return i;
+}
@@ -0,0 +1,285 @@
+#pragma once
+
+#include "mpc_constraints.hpp"
+
+/*!
+@file   condense.hpp
+@brief  Condensing of the MPC problem at compile time. Eliminates the states of
+                    min sum_{k=1}^{L-1} x_k'*Q*x_k + x_L'*P*x_L + sum_{k=0}^{L-1} u_k'*R*u_k,  x_{k+1} = A*x_k + B*u_k
+        into the QP of mpc_dense over U = [u_0; ...; u_{L-1}], with X = Acal*x_0 + Bcal*U:
+                    Hcal = Bcal'*blkdiag(Q, ..., Q, P)*Bcal + blkdiag(R, ..., R),   h_base = Bcal'*blkdiag(Q, ..., Q, P)*Acal
+        The tables are computed in double by constexpr functions on plain arrays, Matrix is not a literal type, and
+        rounded to T once.
+*/
+
+/*!
+@brief  Plant, weights and bounds of an MPC problem. Every pointer refers to a row-major constexpr array, so the
+        plant can be condensed in a constant expression.
+@tparam N   Number of states
+@tparam M   Number of inputs
+@tparam T   Data type
+*/
+template<int N, int M, typename T = float>
+struct MpcPlant
+{
+	const T *A;     //!< NxN state matrix
+	const T *B;     //!< NxM input matrix
+	const T *Q;     //!< NxN state weight of the stages 1 to L-1
+	const T *R;     //!< MxM input weight
+	const T *P;     //!< NxN final state weight
+	const T *umin;
+	const T *umax;
+	const T *xmin;
+	const T *xmax;
+	const T *Nxmin;
+	const T *Nxmax;
+};
+
+/*!
+@brief  Condensed tables of an MPC problem, row-major, laid out as the matrices of MpcModel
+@tparam N   Number of states
+@tparam M   Number of inputs
+@tparam L   Prediction horizon
+@tparam V   Length of the constraints vector
+@tparam T   Data type
+*/
+template<int N, int M, int L, int V, typename T = float>
+struct MpcCondensed
+{
+	T AL[N*N];          //!< A^L
+	T Acal[N*L*N];      //!< Stacked powers of A
+	T Hcal[M*L*M*L];    //!< Cost matrix of the QP
+	T h_base[M*L*N];    //!< Cost vector of the QP is h_base * x
+	T Mx[V*M*L];        //!< Constraints matrix of the QP
+	T cx[V];            //!< Initial constraints vector
+
+	constexpr MpcCondensed() : AL(), Acal(), Hcal(), h_base(), Mx(), cx()
+	{ }
+};
+
+/*!
+@brief  Length of the double scratch buffer of mpcCondenseInto
+*/
+constexpr int mpcCondenseScratch(int N, int M, int L)
+{
+	return N*L*N + 2*N*L*M*L;
+}
+
+/*!
+@brief  Condenses an MPC problem of runtime size into caller-provided buffers. Shared by mpcCondense at compile time and
+        the runtime-dimensioned engine of dyn_mpc.hpp. Rows of Mx and cx follow updateConstraintsVector: final state
+        [BL; -BL], states [Bcal; -Bcal] and inputs [I; -I], where BL is the last block row of Bcal. cx holds the
+        bounds, the terms in x_0 are added by updateConstraintsVector on every control cycle.
+@param  constraints Type of constraints of the system
+@param  N   Number of states
+@param  M   Number of inputs
+@param  L   Prediction horizon
+@param  A, B, Q, R, P, umin, umax, xmin, xmax, Nxmin, Nxmax  Row-major plant, weights and bounds, as in MpcPlant
+@param  work    Scratch of mpcCondenseScratch(N, M, L) doubles
+@param  AL, Acal, Hcal, h_base, Mx, cx  Resulting row-major tables, sized as in MpcCondensed
+*/
+template<typename T, typename U>
+constexpr void mpcCondenseInto
+(
+	MpcConstraints constraints, int N, int M, int L,
+	const T *A, const T *B, const T *Q, const T *R, const T *P,
+	const T *umin, const T *umax, const T *xmin, const T *xmax, const T *Nxmin, const T *Nxmax,
+	double *work,
+	U *AL, U *Acal, U *Hcal, U *h_base, U *Mx, U *cx
+)
+{
+	const bool finalstate = (constraints & FINALSTATE) != 0;
+	const bool state = (constraints & STATE) != 0;
+	const bool input = (constraints & INPUT) != 0;
+
+	const int NL = N*L;
+	const int ML = M*L;
+
+	double *Acal_d = work;
+	double *Bcal = Acal_d + NL*N;
+	double *WB = Bcal + NL*ML;
+
+	// Acal = [A; A^2; ...; A^L]
+
+	for(int i = 0; i < N*N; ++i)
+	{
+		Acal_d[i] = A[i];
+	}
+
+	for(int k = 1; k < L; ++k)
+	{
+		for(int i = 0; i < N; ++i)
+		{
+			for(int j = 0; j < N; ++j)
+			{
+				double sum = 0;
+
+				for(int l = 0; l < N; ++l)
+				{
+					sum += double(A[i*N + l]) * Acal_d[((k-1)*N + l)*N + j];
+				}
+
+				Acal_d[(k*N + i)*N + j] = sum;
+			}
+		}
+	}
+
+	// Bcal(k,j) = A^(k-j)*B for j <= k. The blocks of a diagonal are equal, so each one is computed once
+
+	for(int i = 0; i < NL*ML; ++i)
+	{
+		Bcal[i] = 0;
+	}
+
+	for(int d = 0; d < L; ++d)
+	{
+		for(int i = 0; i < N; ++i)
+		{
+			for(int j = 0; j < M; ++j)
+			{
+				double sum = 0;
+
+				for(int l = 0; l < N; ++l)
+				{
+					sum += (d == 0 ? (i == l ? 1.0 : 0.0) : Acal_d[((d-1)*N + i)*N + l]) * double(B[l*M + j]);
+				}
+
+				for(int k = d; k < L; ++k)
+				{
+					Bcal[(k*N + i)*ML + (k-d)*M + j] = sum;
+				}
+			}
+		}
+	}
+
+	// WB = blkdiag(Q, ..., Q, P)*Bcal
+
+	for(int k = 0; k < L; ++k)
+	{
+		const T *W = k < L-1 ? Q : P;
+
+		for(int i = 0; i < N; ++i)
+		{
+			for(int c = 0; c < ML; ++c)
+			{
+				double sum = 0;
+
+				for(int l = 0; l < N; ++l)
+				{
+					sum += double(W[i*N + l]) * Bcal[(k*N + l)*ML + c];
+				}
+
+				WB[(k*N + i)*ML + c] = sum;
+			}
+		}
+	}
+
+	// Hcal = Bcal'*WB + blkdiag(R, ..., R), h_base = WB'*Acal
+
+	for(int a = 0; a < ML; ++a)
+	{
+		for(int b = 0; b < ML; ++b)
+		{
+			double sum = a/M == b/M ? double(R[(a%M)*M + b%M]) : 0.0;
+
+			for(int r = 0; r < NL; ++r)
+			{
+				sum += Bcal[r*ML + a] * WB[r*ML + b];
+			}
+
+			Hcal[a*ML + b] = U(sum);
+		}
+
+		for(int j = 0; j < N; ++j)
+		{
+			double sum = 0;
+
+			for(int r = 0; r < NL; ++r)
+			{
+				sum += WB[r*ML + a] * Acal_d[r*N + j];
+			}
+
+			h_base[a*N + j] = U(sum);
+		}
+	}
+
+	for(int i = 0; i < NL*N; ++i)
+	{
+		Acal[i] = U(Acal_d[i]);
+	}
+
+	for(int i = 0; i < N*N; ++i)
+	{
+		AL[i] = U(Acal_d[(L-1)*N*N + i]);
+	}
+
+	// Constraints, in the order of updateConstraintsVector
+
+	int row = 0;
+
+	for(int sign = 1; finalstate && sign >= -1; sign -= 2)
+	{
+		for(int i = 0; i < N; ++i, ++row)
+		{
+			for(int c = 0; c < ML; ++c)
+			{
+				Mx[row*ML + c] = U(sign * Bcal[((L-1)*N + i)*ML + c]);
+			}
+
+			cx[row] = sign > 0 ? U(Nxmax[i]) : U(-double(Nxmin[i]));
+		}
+	}
+
+	for(int sign = 1; state && sign >= -1; sign -= 2)
+	{
+		for(int i = 0; i < NL; ++i, ++row)
+		{
+			for(int c = 0; c < ML; ++c)
+			{
+				Mx[row*ML + c] = U(sign * Bcal[i*ML + c]);
+			}
+
+			cx[row] = sign > 0 ? U(xmax[i%N]) : U(-double(xmin[i%N]));
+		}
+	}
+
+	for(int sign = 1; input && sign >= -1; sign -= 2)
+	{
+		for(int i = 0; i < ML; ++i, ++row)
+		{
+			for(int c = 0; c < ML; ++c)
+			{
+				Mx[row*ML + c] = U(i == c ? sign : 0);
+			}
+
+			cx[row] = sign > 0 ? U(umax[i%M]) : U(-double(umin[i%M]));
+		}
+	}
+}
+
+/*!
+@brief  Condenses an MPC problem, see mpcCondenseInto
+@tparam constraints Type of constraints of the system
+@tparam L   Prediction horizon
+@tparam V   Length of the constraints vector, must match the constraints
+@param  plant   Plant, weights and bounds
+@return Condensed tables
+*/
+template<MpcConstraints constraints, int L, int V, int N, int M, typename T>
+constexpr MpcCondensed<N,M,L,V,T> mpcCondense(const MpcPlant<N,M,T> &plant)
+{
+	static_assert(V == mpcConstraintRows(constraints, N, M, L), "Constraints vector length mismatch");
+
+	MpcCondensed<N,M,L,V,T> res;
+	double work[mpcCondenseScratch(N, M, L)] = {};
+
+	mpcCondenseInto(
+		constraints, N, M, L,
+		plant.A, plant.B, plant.Q, plant.R, plant.P,
+		plant.umin, plant.umax, plant.xmin, plant.xmax, plant.Nxmin, plant.Nxmax,
+		work,
+		res.AL, res.Acal, res.Hcal, res.h_base, res.Mx, res.cx
+	);
+
+	return res;
+}
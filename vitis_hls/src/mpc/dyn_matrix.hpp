@@ -0,0 +1,306 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+/*!
+@file   dyn_matrix.hpp
+@brief  Matrices of runtime size for the engine of dyn_mpc.hpp. DynMatrix is a row-major view that owns no memory, its
+        elements live in a DynArena sized once when a model is loaded, so no control cycle allocates. Host only, Vitis
+        HLS needs the compile-time sizes of Matrix.
+*/
+
+/*!
+@brief  Row-major view of a RxC block of memory
+@tparam T   Data type
+*/
+template<typename T = float>
+class DynMatrix
+{
+public:
+	DynMatrix() : m_data(nullptr), m_rows(0), m_cols(0)
+	{ }
+
+	DynMatrix(T *data, int rows, int cols) : m_data(data), m_rows(rows), m_cols(cols)
+	{ }
+
+	T &operator()(int row, int column)
+	{
+		assert(row >= 0 && row < m_rows);
+		assert(column >= 0 && column < m_cols);
+		return m_data[row*m_cols + column];
+	}
+
+	const T &operator()(int row, int column) const
+	{
+		assert(row >= 0 && row < m_rows);
+		assert(column >= 0 && column < m_cols);
+		return m_data[row*m_cols + column];
+	}
+
+	//! Element i of a vector
+	T &operator[](int i)
+	{
+		assert(i >= 0 && i < m_rows*m_cols);
+		return m_data[i];
+	}
+
+	const T &operator[](int i) const
+	{
+		assert(i >= 0 && i < m_rows*m_cols);
+		return m_data[i];
+	}
+
+	int rows() const { return m_rows; }
+	int cols() const { return m_cols; }
+	int size() const { return m_rows*m_cols; }
+
+	T *data() { return m_data; }
+	const T *data() const { return m_data; }
+
+	//! Sets every element to value
+	void fill(T value)
+	{
+		for(int i = 0; i < size(); ++i)
+		{
+			m_data[i] = value;
+		}
+	}
+
+	//! Copies the elements of a view of the same size
+	void copy(const DynMatrix<T> &other)
+	{
+		assert(other.size() == size());
+
+		for(int i = 0; i < size(); ++i)
+		{
+			m_data[i] = other.m_data[i];
+		}
+	}
+
+	//! Copies size() elements from a row-major array of another type
+	template<typename U>
+	void copy(const U *values)
+	{
+		for(int i = 0; i < size(); ++i)
+		{
+			m_data[i] = T(values[i]);
+		}
+	}
+
+	/*!
+	@brief  Shifts blocks of a vector one position towards its beginning, as Matrix::shift. The last block is kept
+	@param  begin   Offset of the first block
+	@param  block   Number of elements of every block
+	@param  times   Number of blocks
+	*/
+	void shift(int begin, int block, int times)
+	{
+		for(int i = begin; i < begin + block*(times-1); ++i)
+		{
+			m_data[i] = m_data[i+block];
+		}
+	}
+
+	//! Largest absolute value of the elements
+	T maxAbs() const
+	{
+		T res = 0;
+
+		for(int i = 0; i < size(); ++i)
+		{
+			T v = m_data[i] < 0 ? -m_data[i] : m_data[i];
+			res = v > res ? v : res;
+		}
+
+		return res;
+	}
+
+	//! Dot product with a vector of the same size
+	T dot(const DynMatrix<T> &other) const
+	{
+		assert(other.size() == size());
+		T res = 0;
+
+		for(int i = 0; i < size(); ++i)
+		{
+			res += m_data[i] * other.m_data[i];
+		}
+
+		return res;
+	}
+
+private:
+	T *m_data;
+	int m_rows;
+	int m_cols;
+};
+
+/*!
+@brief  Preallocated storage for DynMatrix views. Views are carved out in order and aligned to a cache line, the
+        capacity is fixed at construction and nothing is ever freed: a model or controller computes its footprint
+        first, then allocates every view it needs once.
+@tparam T   Data type
+*/
+template<typename T = float>
+class DynArena
+{
+public:
+	//! Elements per cache line, every view starts on one
+	static constexpr std::size_t ALIGN = 64 / sizeof(T) > 0 ? 64 / sizeof(T) : 1;
+
+	//! Elements taken by a RxC view, padding included
+	static std::size_t footprint(int rows, int cols)
+	{
+		std::size_t n = std::size_t(rows) * std::size_t(cols);
+		return (n + ALIGN - 1) / ALIGN * ALIGN;
+	}
+
+	/*!
+	@param  capacity    Number of elements, the sum of the footprint of every view
+	*/
+	explicit DynArena(std::size_t capacity = 0) : m_storage(capacity + ALIGN), m_used(0)
+	{
+		// Skip the elements before the first cache line boundary
+
+		std::size_t addr = reinterpret_cast<std::size_t>(m_storage.data());
+		std::size_t misalign = addr % 64 / sizeof(T);
+		m_base = misalign ? ALIGN - misalign : 0;
+	}
+
+	DynArena(const DynArena&) = delete;
+	DynArena &operator=(const DynArena&) = delete;
+
+	/*!
+	@brief  Carves a zero-filled RxC view. The capacity must cover it
+	*/
+	DynMatrix<T> alloc(int rows, int cols)
+	{
+		std::size_t n = footprint(rows, cols);
+		assert(m_used + n <= capacity());
+
+		DynMatrix<T> res(m_storage.data() + m_base + m_used, rows, cols);
+		res.fill(T(0));
+		m_used += n;
+
+		return res;
+	}
+
+	std::size_t capacity() const { return m_storage.size() - ALIGN; }
+	std::size_t used() const { return m_used; }
+
+private:
+	std::vector<T> m_storage;
+	std::size_t m_base;
+	std::size_t m_used;
+};
+
+/*!
+@brief  y = A*x
+*/
+template<typename T>
+void dynMul(const DynMatrix<T> &A, const DynMatrix<T> &x, DynMatrix<T> &y)
+{
+	assert(A.cols() == x.size() && A.rows() == y.size());
+
+	for(int i = 0; i < A.rows(); ++i)
+	{
+		const T *a = A.data() + i*A.cols();
+		T sum = 0;
+
+		for(int j = 0; j < A.cols(); ++j)
+		{
+			sum += a[j] * x[j];
+		}
+
+		y[i] = sum;
+	}
+}
+
+/*!
+@brief  y = A'*x
+*/
+template<typename T>
+void dynMulTr(const DynMatrix<T> &A, const DynMatrix<T> &x, DynMatrix<T> &y)
+{
+	assert(A.rows() == x.size() && A.cols() == y.size());
+
+	y.fill(T(0));
+
+	for(int i = 0; i < A.rows(); ++i)
+	{
+		const T *a = A.data() + i*A.cols();
+		T xi = x[i];
+
+		for(int j = 0; j < A.cols(); ++j)
+		{
+			y[j] += a[j] * xi;
+		}
+	}
+}
+
+/*!
+@brief  LDL' factorization of a symmetric matrix, same column loops as LdlKernel. Only the elements of L below the
+        diagonal are written
+@param  A   NxN matrix
+@param  L   NxN unit lower-triangular factor
+@param  D   Nx1 diagonal factor
+@param  work    Nx1 scratch
+*/
+template<typename T>
+void dynLdlFactor(const DynMatrix<T> &A, DynMatrix<T> &L, DynMatrix<T> &D, DynMatrix<T> &work)
+{
+	const int N = A.rows();
+
+	work.fill(T(0));
+
+	for(int j = 0; j < N; ++j)
+	{
+		D[j] = A(j,j) - work[j];
+
+		for(int i = j+1; i < N; ++i)
+		{
+			T sum = A(i,j);
+
+			for(int k = 0; k < j; ++k)
+			{
+				sum -= L(i,k) * L(j,k) * D[k];
+			}
+
+			T sum2 = sum / D[j];
+			work[i] += sum * sum2;
+
+			L(i,j) = sum2;
+		}
+	}
+}
+
+/*!
+@brief  Solves L*D*L'*x = v from the factors of dynLdlFactor. v is overwritten
+*/
+template<typename T>
+void dynLdlSolve(const DynMatrix<T> &L, const DynMatrix<T> &D, DynMatrix<T> &v, DynMatrix<T> &x)
+{
+	const int N = D.size();
+
+	for(int j = 0; j < N; ++j)
+	{
+		for(int i = j+1; i < N; ++i)
+		{
+			v[i] -= L(i,j) * v[j];
+		}
+
+		v[j] /= D[j];
+	}
+
+	for(int j = N-1; j >= 0; --j)
+	{
+		x[j] = v[j];
+
+		for(int i = j-1; i >= 0; --i)
+		{
+			v[i] -= L(j,i) * v[j];
+		}
+	}
+}
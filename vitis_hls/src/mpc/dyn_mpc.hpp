@@ -0,0 +1,670 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "condense.hpp"
+#include "dyn_matrix.hpp"
+#include "model_file.hpp"
+#include "pdip.hpp"
+
+/*!
+@file   dyn_mpc.hpp
+@brief  Runtime-dimensioned counterpart of MpcModel, pdip, mpc_dense and MpcController. N, M, P and L come from a
+        model file instead of the MPC_ macros, so one process can host any number of heterogeneous models without a
+        rebuild per motor. Every buffer is a DynMatrix carved from a DynArena sized when the model or the controller
+        is built, a control cycle does not allocate. The Newton systems are solved with the LDL' factorization of
+        CHOLESKY, the only solver of the engine. Same iterations as the static path, which stays the one for Vitis
+        HLS and the fastest for a fixed size: see the dynamic rows of the benchmark for the gap.
+*/
+
+/*!
+@brief  Condensed MPC problem of runtime size, built once from the arrays of a model file or any MpcModelView.
+        Immutable once built, so it can be shared by any number of controllers, as MpcModel.
+@tparam T   Data type
+*/
+template<typename T = float>
+class DynMpcModel
+{
+public:
+	explicit DynMpcModel(const MpcModelView &view) :
+		m_N(view.N), m_M(view.M), m_P(view.P), m_L(view.L), m_V(view.V()), m_constraints(view.constraints),
+		m_arena(footprint(view.N, view.M, view.P, view.L, view.V()))
+	{
+		const int N = m_N, M = m_M, P = m_P, L = m_L, V = m_V;
+
+		AL = m_arena.alloc(N, N);
+		Acal = m_arena.alloc(N*L, N);
+		Hcal = m_arena.alloc(M*L, M*L);
+		h_base = m_arena.alloc(M*L, N);
+		Mx = m_arena.alloc(V, M*L);
+		cx = m_arena.alloc(V, 1);
+		umin = m_arena.alloc(M, 1);
+		umax = m_arena.alloc(M, 1);
+		xmin = m_arena.alloc(N, 1);
+		xmax = m_arena.alloc(N, 1);
+		Nxmin = m_arena.alloc(N, 1);
+		Nxmax = m_arena.alloc(N, 1);
+		Lx = m_arena.alloc(N, P);
+		Lu = m_arena.alloc(M, P);
+
+		// Same condensing as the constexpr tables of the static path, in double on a scratch freed on return
+
+		std::vector<double> work(mpcCondenseScratch(N, M, L));
+
+		mpcCondenseInto(
+			m_constraints, N, M, L,
+			view.A, view.B, view.Q, view.R, view.Pw,
+			view.umin, view.umax, view.xmin, view.xmax, view.Nxmin, view.Nxmax,
+			work.data(),
+			AL.data(), Acal.data(), Hcal.data(), h_base.data(), Mx.data(), cx.data()
+		);
+
+		umin.copy(view.umin);
+		umax.copy(view.umax);
+		xmin.copy(view.xmin);
+		xmax.copy(view.xmax);
+		Nxmin.copy(view.Nxmin);
+		Nxmax.copy(view.Nxmax);
+		Lx.copy(view.Lx);
+		Lu.copy(view.Lu);
+	}
+
+	DynMpcModel(const DynMpcModel&) = delete;
+	DynMpcModel &operator=(const DynMpcModel&) = delete;
+
+	int states() const { return m_N; }
+	int inputs() const { return m_M; }
+	int outputs() const { return m_P; }
+	int horizon() const { return m_L; }
+	int constraintRows() const { return m_V; }
+	MpcConstraints constraints() const { return m_constraints; }
+
+	//! Mx = [I; -I], as MpcConstraintsStructure
+	bool box() const { return m_constraints == INPUT; }
+
+	//! Bytes of the arena of the model
+	std::size_t bytes() const { return m_arena.capacity() * sizeof(T); }
+
+private:
+	static std::size_t footprint(int N, int M, int P, int L, int V)
+	{
+		using A = DynArena<T>;
+
+		return A::footprint(N, N) + A::footprint(N*L, N) + A::footprint(M*L, M*L) + A::footprint(M*L, N)
+			+ A::footprint(V, M*L) + A::footprint(V, 1) + 2*A::footprint(M, 1) + 4*A::footprint(N, 1)
+			+ A::footprint(N, P) + A::footprint(M, P);
+	}
+
+	const int m_N;
+	const int m_M;
+	const int m_P;
+	const int m_L;
+	const int m_V;
+	const MpcConstraints m_constraints;
+	DynArena<T> m_arena;
+
+public:
+	DynMatrix<T> AL;        //!< A^L
+	DynMatrix<T> Acal;      //!< Stacked powers of A
+	DynMatrix<T> Hcal;      //!< Cost matrix of the QP
+	DynMatrix<T> h_base;    //!< Cost vector of the QP is h_base * x
+	DynMatrix<T> Mx;        //!< Constraints matrix of the QP
+	DynMatrix<T> cx;        //!< Initial constraints vector
+	DynMatrix<T> umin;
+	DynMatrix<T> umax;
+	DynMatrix<T> xmin;
+	DynMatrix<T> xmax;
+	DynMatrix<T> Nxmin;
+	DynMatrix<T> Nxmax;
+	DynMatrix<T> Lx;        //!< Stationary state for a reference, xinfy = Lx * y_ref
+	DynMatrix<T> Lu;        //!< Stationary input for a reference, uinfy = Lu * y_ref
+};
+
+/*!
+@brief  Settings of DynMpcController, the template parameters of MpcController and mpc_dense at runtime
+*/
+struct DynMpcOptions
+{
+	int qpiter = 20;                            //!< Number of iterations for QP algorithm
+	bool early_exit = false;                    //!< Stop the QP iterations once the exit criteria are met
+	int exit_tol = -4;                          //!< Magnitude order of the early exit tolerances
+	PdipAlgorithm algorithm = PDIP_FIXED_CENTERING; //!< Search direction strategy of the QP solver
+	bool track_ref = false;                     //!< Use the reference of setReference
+	bool warm_start = true;                     //!< Warm start the QP solver from the previous control cycle
+	float warm_floor = 1e-3f;                   //!< Minimum value for the shifted multipliers and slacks
+};
+
+/*!
+@brief  Workspace of dynPdip for n optimization values and V constraints
+@tparam T   Data type
+*/
+template<typename T = float>
+struct DynPdipWork
+{
+	static std::size_t footprint(int n, int V)
+	{
+		using A = DynArena<T>;
+		return 2*A::footprint(n, n) + 5*A::footprint(n, 1) + 7*A::footprint(V, 1);
+	}
+
+	DynPdipWork(DynArena<T> &arena, int n, int V) :
+		Ak(arena.alloc(n, n)), Lf(arena.alloc(n, n)), D(arena.alloc(n, 1)), ldl(arena.alloc(n, 1)),
+		HK(arena.alloc(n, 1)), bk(arena.alloc(n, 1)), zk(arena.alloc(n, 1)),
+		rk(arena.alloc(V, 1)), GK(arena.alloc(V, 1)), LS(arena.alloc(V, 1)), TK(arena.alloc(V, 1)),
+		Dlk(arena.alloc(V, 1)), Dsk(arena.alloc(V, 1)), tmp(arena.alloc(V, 1))
+	{ }
+
+	DynMatrix<T> Ak, Lf, D, ldl, HK, bk, zk;
+	DynMatrix<T> rk, GK, LS, TK, Dlk, Dsk, tmp;
+};
+
+/*!
+@brief  y = Mx*x, with Mx = [I; -I] if box
+*/
+template<typename T>
+void dynMxMul(bool box, const DynMatrix<T> &Mx, const DynMatrix<T> &x, DynMatrix<T> &y)
+{
+	if(!box)
+	{
+		dynMul(Mx, x, y);
+		return;
+	}
+
+	const int n = x.size();
+
+	for(int i = 0; i < n; ++i)
+	{
+		y[i] = x[i];
+		y[i+n] = -x[i];
+	}
+}
+
+/*!
+@brief  y = Mx'*v, with Mx = [I; -I] if box
+*/
+template<typename T>
+void dynMxMulTr(bool box, const DynMatrix<T> &Mx, const DynMatrix<T> &v, DynMatrix<T> &y)
+{
+	if(!box)
+	{
+		dynMulTr(Mx, v, y);
+		return;
+	}
+
+	const int n = y.size();
+
+	for(int i = 0; i < n; ++i)
+	{
+		y[i] = v[i] - v[i+n];
+	}
+}
+
+/*!
+@brief  Largest step in (0,1] keeping k + alp*delta positive, shortened by a factor bt, as computeAlp
+*/
+template<typename T>
+T dynComputeAlp(const DynMatrix<T> &delta, const DynMatrix<T> &k, T bt = T(0.99999))
+{
+	T alp = 1;
+
+	for(int i = 0; i < k.size(); ++i)
+	{
+		T ratio = -delta[i] / k[i];
+		alp = (delta[i] < 0) & (ratio > alp) ? ratio : alp;
+	}
+
+	return bt/alp;
+}
+
+/*!
+@brief  Search direction of dynPdip from the factorized Newton system, see pdipDirection. Reads HK, GK and TK of w,
+        writes zk, Dlk and Dsk
+*/
+template<typename T>
+void dynPdipDirection(bool box, const DynMatrix<T> &Mx, const DynMatrix<T> &lk, const DynMatrix<T> &sk, DynPdipWork<T> &w)
+{
+	const int V = lk.size();
+
+	for(int i = 0; i < V; ++i)
+	{
+		w.tmp[i] = (lk[i] * w.GK[i] - w.TK[i]) / sk[i];
+	}
+
+	dynMxMulTr(box, Mx, w.tmp, w.bk);
+
+	for(int i = 0; i < w.bk.size(); ++i)
+	{
+		w.bk[i] += w.HK[i];
+	}
+
+	dynLdlSolve(w.Lf, w.D, w.bk, w.zk);
+	dynMxMul(box, Mx, w.zk, w.tmp);
+
+	for(int i = 0; i < V; ++i)
+	{
+		w.Dsk[i] = w.GK[i] - w.tmp[i];
+		w.Dlk[i] = (w.TK[i] - lk[i] * w.Dsk[i]) / sk[i];
+	}
+}
+
+/*!
+@brief  Primal-Dual Interior-Point method of runtime size, the iterations of pdip with S = CHOLESKY
+@param  box Mx = [I; -I], Mx is not read
+@param  algorithm   Search direction strategy
+@param  IT  Maximum of iterations for the main algorithm
+@param  w   Workspace, sized for H and Mx
+@see    pdip for the other parameters
+*/
+template<typename T>
+void dynPdip
+(
+	const DynMatrix<T> &H, const DynMatrix<T> &h, const DynMatrix<T> &Mx, const DynMatrix<T> &cx, bool box,
+	PdipAlgorithm algorithm, int IT, const PdipCriteria<T> &criteria, PdipResult<T> &result,
+	DynMatrix<T> &tk, DynMatrix<T> &lk, DynMatrix<T> &sk, DynPdipWork<T> &w
+)
+{
+	const int n = tk.size();
+	const int V = lk.size();
+	T sgk = 0.5;
+	const T lk_min = std::numeric_limits<T>::min();
+
+	result.status = PDIP_MAX_ITER;
+	result.inner_iterations = 0;
+
+	int k;
+
+	// One pass more than IT evaluates the final iterate, see pdip
+
+	for(k = 0; k <= IT; ++k)
+	{
+		// Residuals
+
+		T muk = lk.dot(sk)/V;
+
+		dynMul(H, tk, w.HK);
+		dynMxMulTr(box, Mx, lk, w.bk);
+
+		for(int i = 0; i < n; ++i)
+		{
+			w.HK[i] = -w.HK[i] - h[i] - w.bk[i];
+		}
+
+		dynMxMul(box, Mx, tk, w.tmp);
+
+		for(int i = 0; i < V; ++i)
+		{
+			w.GK[i] = cx[i] - sk[i] - w.tmp[i];
+		}
+
+		// Check exit criteria
+
+		T res_d = w.HK.maxAbs();
+		T res_p = w.GK.maxAbs();
+		result.gap = muk;
+		result.residual = res_d > res_p ? res_d : res_p;
+		result.status = pdipExitStatus(criteria, muk, result.residual, res_p, lk.maxAbs());
+
+		if(result.status != PDIP_MAX_ITER || k == IT)
+		{
+			break;
+		}
+
+		// Build Ak = H + Mx'*diag(lk/sk)*Mx
+
+		for(int i = 0; i < V; ++i)
+		{
+			w.rk[i] = lk[i] / sk[i];
+		}
+
+		w.Ak.copy(H);
+
+		if(box)
+		{
+			for(int i = 0; i < n; ++i)
+			{
+				w.Ak(i,i) += w.rk[i] + w.rk[i+n];
+			}
+		}
+		else
+		{
+			for(int r = 0; r < V; ++r)
+			{
+				const T *m = Mx.data() + r*n;
+
+				for(int i = 0; i < n; ++i)
+				{
+					T mi = m[i] * w.rk[r];
+
+					for(int j = 0; j < n; ++j)
+					{
+						w.Ak(i,j) += mi * m[j];
+					}
+				}
+			}
+		}
+
+		dynLdlFactor(w.Ak, w.Lf, w.D, w.ldl);
+
+		for(int i = 0; i < V; ++i)
+		{
+			w.LS[i] = lk[i] * sk[i];
+		}
+
+		if(algorithm == PDIP_MEHROTRA)
+		{
+			// Predictor: affine scaling direction, sgk = 0
+
+			for(int i = 0; i < V; ++i)
+			{
+				w.TK[i] = -w.LS[i];
+			}
+
+			dynPdipDirection(box, Mx, lk, sk, w);
+
+			T alp_p = dynComputeAlp(w.Dsk, sk, T(1));
+			T alp_d = dynComputeAlp(w.Dlk, lk, T(1));
+			T mu_aff = 0;
+
+			for(int i = 0; i < V; ++i)
+			{
+				mu_aff += (lk[i] + w.Dlk[i] * alp_d) * (sk[i] + w.Dsk[i] * alp_p);
+			}
+
+			T ratio = mu_aff/V / muk;
+
+			// Corrector: adaptive centering plus second order term
+
+			sgk = ratio * ratio * ratio;
+			sgk = sgk < 1 ? sgk : T(1);
+			sgk = sgk > 0 ? sgk : T(0);
+
+			for(int i = 0; i < V; ++i)
+			{
+				w.TK[i] = sgk * muk - w.LS[i] - w.Dlk[i] * w.Dsk[i];
+			}
+		}
+		else
+		{
+			for(int i = 0; i < V; ++i)
+			{
+				w.TK[i] = sgk * muk - w.LS[i];
+			}
+		}
+
+		dynPdipDirection(box, Mx, lk, sk, w);
+
+		// Find max ak in (0,1], separate primal and dual lengths for Mehrotra, see pdip
+
+		T alp_p, alp_d;
+
+		if(algorithm == PDIP_MEHROTRA)
+		{
+			alp_p = dynComputeAlp(w.Dsk, sk);
+			alp_d = dynComputeAlp(w.Dlk, lk);
+		}
+		else
+		{
+			T alp_lk = dynComputeAlp(w.Dlk, lk);
+			T alp_sk = dynComputeAlp(w.Dsk, sk);
+			alp_p = alp_lk > alp_sk ? alp_sk : alp_lk;
+			alp_d = alp_p;
+		}
+
+		for(int i = 0; i < n; ++i)
+		{
+			tk[i] += w.zk[i] * alp_p;
+		}
+
+		for(int i = 0; i < V; ++i)
+		{
+			lk[i] += w.Dlk[i] * alp_d;
+			sk[i] += w.Dsk[i] * alp_p;
+			lk[i] = lk[i] < lk_min ? lk_min : lk[i];
+			sk[i] = sk[i] < lk_min ? lk_min : sk[i];
+		}
+	}
+
+	result.iterations = k;
+}
+
+/*!
+@brief  MPC dense controller for one plant of runtime size, the counterpart of MpcController. Reads the shared model
+        and owns the constraints vector, stationary targets, warm start iterates and the workspace of dynPdip, all in
+        one arena allocated by the constructor.
+@tparam T   Data type
+*/
+template<typename T = float>
+class DynMpcController
+{
+public:
+	/*!
+	@brief  Creates a controller for a model, which must outlive it
+	*/
+	DynMpcController(const DynMpcModel<T> &model, const DynMpcOptions &options = DynMpcOptions()) :
+		m_model(model), m_options(options),
+		m_arena(footprint(model.states(), model.inputs(), model.outputs(), model.horizon(), model.constraintRows())),
+		m_work(m_arena, model.inputs()*model.horizon(), model.constraintRows()), m_valid(false), m_result()
+	{
+		const int N = model.states(), M = model.inputs(), P = model.outputs(), L = model.horizon();
+		const int V = model.constraintRows();
+
+		m_cx = m_arena.alloc(V, 1);
+		m_xinfy = m_arena.alloc(N, 1);
+		m_uinfy = m_arena.alloc(M, 1);
+		m_yref = m_arena.alloc(P, 1);
+		m_x0nau = m_arena.alloc(N, 1);
+		m_Ax0 = m_arena.alloc(N*L, 1);
+		m_h = m_arena.alloc(M*L, 1);
+		m_tk = m_arena.alloc(M*L, 1);
+		m_lk = m_arena.alloc(V, 1);
+		m_sk = m_arena.alloc(V, 1);
+		m_warm_tk = m_arena.alloc(M*L, 1);
+		m_warm_lk = m_arena.alloc(V, 1);
+
+		m_criteria = pdipCriteria<T>(options.early_exit, options.exit_tol);
+		m_store_tol = T(std::pow(10.0, options.exit_tol));
+
+		reset();
+	}
+
+	/*!
+	@brief  Sets the output reference to track, only used with track_ref
+	@param  y_ref   P outputs
+	*/
+	void setReference(const T *y_ref)
+	{
+		m_yref.copy(y_ref);
+		dynMul(m_model.Lx, m_yref, m_xinfy);
+		dynMul(m_model.Lu, m_yref, m_uinfy);
+	}
+
+	/*!
+	@brief  Runs one control cycle
+	@param  x   N states of the plant
+	@param  u   M inputs to apply to the plant
+	*/
+	void step(const T *x, T *u)
+	{
+		const DynMpcModel<T> &m = m_model;
+		const int N = m.states(), M = m.inputs(), L = m.horizon(), V = m.constraintRows();
+
+		for(int i = 0; i < N; ++i)
+		{
+			m_x0nau[i] = x[i] - m_xinfy[i];
+		}
+
+		dynMul(m.h_base, m_x0nau, m_h);
+		updateConstraints();
+
+		// Cold start, or the previous solution shifted one stage and pushed back into the interior. Slacks come from
+		// the constraints in both cases, see pdipStartSlacks
+
+		const bool warm = m_options.warm_start && m_valid;
+		const T floor = warm ? T(m_options.warm_floor) : T(0.5);
+
+		m_tk.fill(T(1));
+		m_lk.fill(T(0.5));
+
+		if(warm)
+		{
+			m_tk.copy(m_warm_tk);
+			m_lk.copy(m_warm_lk);
+			m_tk.shift(0, M, L);
+			shiftConstraints(m_lk);
+		}
+
+		dynMxMul(m.box(), m.Mx, m_tk, m_sk);
+
+		for(int i = 0; i < V; ++i)
+		{
+			m_sk[i] = m_cx[i] - m_sk[i];
+			m_sk[i] = m_sk[i] < floor ? floor : m_sk[i];
+
+			T lk_min = warm ? floor / m_sk[i] : T(0);
+			m_lk[i] = m_lk[i] < lk_min ? lk_min : m_lk[i];
+		}
+
+		dynPdip(m.Hcal, m_h, m.Mx, m_cx, m.box(), m_options.algorithm, m_options.qpiter, m_criteria, m_result,
+			m_tk, m_lk, m_sk, m_work);
+
+		// Keep the iterates only when they solve the QP, see mpc_dense
+
+		m_valid = m_options.warm_start && (m_result.status == PDIP_CONVERGED ||
+			(!m_options.early_exit && m_result.gap <= m_store_tol && m_result.residual <= m_store_tol));
+
+		if(m_valid)
+		{
+			m_warm_tk.copy(m_tk);
+			m_warm_lk.copy(m_lk);
+		}
+
+		for(int i = 0; i < M; ++i)
+		{
+			u[i] = m_tk[i] + m_uinfy[i];
+		}
+	}
+
+	/*!
+	@brief  Drops the state carried between control cycles. The next step is cold started
+	*/
+	void reset()
+	{
+		m_cx.copy(m_model.cx);
+		m_valid = false;
+	}
+
+	//! Statistics and exit status of the last QP solve
+	const PdipResult<T> &result() const { return m_result; }
+
+	const DynMpcModel<T> &model() const { return m_model; }
+
+	//! Bytes of the arena of the controller
+	std::size_t bytes() const { return m_arena.capacity() * sizeof(T); }
+
+private:
+	static std::size_t footprint(int N, int M, int P, int L, int V)
+	{
+		using A = DynArena<T>;
+
+		return DynPdipWork<T>::footprint(M*L, V) + 4*A::footprint(V, 1) + 2*A::footprint(N, 1) + A::footprint(M, 1)
+			+ A::footprint(P, 1) + A::footprint(N*L, 1) + 3*A::footprint(M*L, 1);
+	}
+
+	//! Runtime counterpart of updateConstraintsVector
+	void updateConstraints()
+	{
+		const DynMpcModel<T> &m = m_model;
+		const int N = m.states(), M = m.inputs(), L = m.horizon();
+		const bool track_ref = m_options.track_ref;
+		const MpcConstraints c = m.constraints();
+
+		int begin = 0;
+
+		if(c & FINALSTATE)
+		{
+			DynMatrix<T> ALx(m_Ax0.data(), N, 1);
+			dynMul(m.AL, m_x0nau, ALx);
+
+			for(int j = 0; j < N; ++j)
+			{
+				m_cx[begin + j] = track_ref ? m.Nxmax[j] - m_xinfy[j] - ALx[j] : m.Nxmax[j] - ALx[j];
+				m_cx[begin + N + j] = track_ref ? m_xinfy[j] - m.Nxmin[j] + ALx[j] : ALx[j] - m.Nxmin[j];
+			}
+
+			begin += 2*N;
+		}
+
+		if(c & STATE)
+		{
+			dynMul(m.Acal, m_x0nau, m_Ax0);
+
+			for(int j = 0; j < N*L; ++j)
+			{
+				const int k = j % N;
+
+				m_cx[begin + j] = track_ref ? m.xmax[k] - m_xinfy[k] - m_Ax0[j] : m.xmax[k] - m_Ax0[j];
+				m_cx[begin + N*L + j] = track_ref ? m_xinfy[k] - m.xmin[k] + m_Ax0[j] : m_Ax0[j] - m.xmin[k];
+			}
+
+			begin += 2*N*L;
+		}
+
+		if((c & INPUT) && track_ref)
+		{
+			for(int j = 0; j < M*L; ++j)
+			{
+				const int k = j % M;
+
+				m_cx[begin + j] = m.umax[k] - m_uinfy[k];
+				m_cx[begin + M*L + j] = m_uinfy[k] - m.umin[k];
+			}
+		}
+	}
+
+	//! Runtime counterpart of shiftConstraintsVector
+	void shiftConstraints(DynMatrix<T> &v)
+	{
+		const DynMpcModel<T> &m = m_model;
+		const int N = m.states(), M = m.inputs(), L = m.horizon();
+		const MpcConstraints c = m.constraints();
+
+		int begin = (c & FINALSTATE) ? 2*N : 0;
+
+		if(c & STATE)
+		{
+			v.shift(begin, N, L);
+			v.shift(begin + N*L, N, L);
+			begin += 2*N*L;
+		}
+
+		if(c & INPUT)
+		{
+			v.shift(begin, M, L);
+			v.shift(begin + M*L, M, L);
+		}
+	}
+
+	const DynMpcModel<T> &m_model;
+	const DynMpcOptions m_options;
+	DynArena<T> m_arena;
+	DynPdipWork<T> m_work;
+	PdipCriteria<T> m_criteria;
+	T m_store_tol;                  //!< Gap and residual below which a solve without early exit is kept for warm start
+
+	DynMatrix<T> m_cx;
+	DynMatrix<T> m_xinfy;
+	DynMatrix<T> m_uinfy;
+	DynMatrix<T> m_yref;
+	DynMatrix<T> m_x0nau;
+	DynMatrix<T> m_Ax0;     //!< Acal*x0nau, or AL*x0nau while the final state rows are updated
+	DynMatrix<T> m_h;
+	DynMatrix<T> m_tk;
+	DynMatrix<T> m_lk;
+	DynMatrix<T> m_sk;
+	DynMatrix<T> m_warm_tk;
+	DynMatrix<T> m_warm_lk;
+	bool m_valid;
+	PdipResult<T> m_result;
+};
@@ -0,0 +1,198 @@
+#pragma once
+
+#include "Matrix.hpp"
+#include "pdip.hpp"
+#include "mpc_constraints.hpp"
+#include "mpc_dense.hpp"
+
+/*!
+@file   explicit_mpc.hpp
+@brief  Explicit MPC. The QP of mpc_dense is a parametric QP in x0nau: its solution is piecewise affine over a partition
+        of the state space in critical regions, one per optimal active set. The regions are computed offline by
+        explicit_generic_dense.cpp, and the online controller only locates x0nau in the table and applies one affine map.
+*/
+
+/*!
+@brief  Critical region of the parametric QP. x0nau belongs to it if G*x0nau <= g, and then the first input of the
+        optimal sequence is K*x0nau + k.
+@tparam N   Number of states
+@tparam M   Number of inputs
+@tparam V   Number of inequalities, one per constraint of the QP
+@tparam T   Data type
+*/
+template<int N, int M, int V, typename T = float>
+struct ExplicitRegion
+{
+	static constexpr int SIZE = V*N + V + M*N + M;  //!< Number of values of a region in a flat table
+
+	Matrix<V,N,T> G;
+	Matrix<V,1,T> g;
+	Matrix<M,N,T> K;
+	Matrix<M,1,T> k;
+};
+
+/*!
+@brief  Region table of an explicit MPC controller
+@tparam R   Capacity of the table
+@tparam N   Number of states
+@tparam M   Number of inputs
+@tparam V   Number of inequalities of every region
+@tparam T   Data type
+*/
+template<int R, int N, int M, int V, typename T = float>
+struct ExplicitTable
+{
+	typedef ExplicitRegion<N,M,V,T> Region;
+
+	ExplicitTable() : size(0) { }
+
+	/*!
+	@brief  Loads the table from a flat array, every region stored as G, g, K and k in row-major order
+	@param  data    Flat table, as generated by explicit_generic_dense
+	@param  regions Number of regions in data, at most R
+	*/
+	ExplicitTable(const float *data, int regions) : size(regions < R ? regions : R)
+	{
+		for(int r = 0; r < size; ++r)
+		{
+			const float *p = data + r * Region::SIZE;
+
+			region[r].G = Matrix<V,N,T>(p);
+			region[r].g = Matrix<V,1,T>(p + V*N);
+			region[r].K = Matrix<M,N,T>(p + V*N + V);
+			region[r].k = Matrix<M,1,T>(p + V*N + V + M*N);
+		}
+	}
+
+	/*!
+	@brief  Converts every region to another data type
+	*/
+	template<typename U>
+	ExplicitTable<R,N,M,V,U> cast() const
+	{
+		ExplicitTable<R,N,M,V,U> res;
+
+		res.size = size;
+
+		for(int r = 0; r < size; ++r)
+		{
+			res.region[r].G = region[r].G.template cast<U>();
+			res.region[r].g = region[r].g.template cast<U>();
+			res.region[r].K = region[r].K.template cast<U>();
+			res.region[r].k = region[r].k.template cast<U>();
+		}
+
+		return res;
+	}
+
+	Region region[R];
+	int size;   //!< Number of valid regions
+};
+
+/*!
+@brief  Point location. Finds the first region containing x0nau and evaluates its affine control law
+@param  table   Region table
+@param  x0nau   Difference between the current state and the stationary state target
+@param  u       First input of the optimal sequence, relative to the stationary target. Unchanged if not found
+@return Index of the region, -1 if x0nau lies outside every region
+*/
+template<int R, int N, int M, int V, typename T>
+int explicitLocate(const ExplicitTable<R,N,M,V,T> &table, const Matrix<N,1,T> &x0nau, Matrix<M,1,T> &u)
+{
+	for(int r = 0; r < R; ++r)
+	{
+		if(r >= table.size)
+		{
+			break;
+		}
+
+		const ExplicitRegion<N,M,V,T> &region = table.region[r];
+		bool inside = true;
+
+		for(int i = 0; i < V; ++i)
+		{
+			T s = region.G(i,0) * x0nau(0,0);
+
+			for(int j = 1; j < N; ++j)
+			{
+				s += region.G(i,j) * x0nau(j,0);
+			}
+
+			inside = inside && s <= region.g(i,0);
+		}
+
+		if(inside)
+		{
+			u = region.K * x0nau + region.k;
+			return r;
+		}
+	}
+
+	return -1;
+}
+
+/*!
+@brief  Explicit MPC implementation. Same interface and result as mpc_dense, with the QP replaced by a lookup in the
+        region table. If x0nau lies outside the table, the QP is solved by mpc_dense with LDL' factorization instead.
+        Regions depend on the constraints vector only through x0nau, so reference tracking is not supported.
+@param  table   Region table generated for the same system and constraints
+@param  result  Solver statistics. A table hit reports a converged QP with 0 iterations
+@param  warm    Warm start of the fallback solver. Invalidated by table hits, which do not produce QP iterates
+*/
+template<
+	MpcConstraints constraints,
+	int L,
+	bool track_ref = false,
+	int qpiter = 20,
+	int tol = -9,
+	bool early_exit = false,
+	int exit_tol = -4,
+	PdipAlgorithm algorithm = PDIP_FIXED_CENTERING,
+	int N, int M, int V, int R, typename T = float // automatically deduced from input arguments
+>
+void mpc_explicit
+(
+	const Matrix<N,N,T> &AL,
+	const Matrix<N*L,N,T> &Acal, const Matrix<M*L,M*L,T> &Hcal, const Matrix<V,M*L,T> &Mx,
+	const Matrix<M,1,T> &umin, const Matrix<M,1,T> &umax, const Matrix<M,1,T> &uinfy,
+	const Matrix<N,1,T> &xmin, const Matrix<N,1,T> &xmax, const Matrix<N,1,T> &xinfy,
+	const Matrix<N,1,T> &Nxmin, const Matrix<N,1,T> &Nxmax,
+	const Matrix<M*L,N,T> &h_base,
+	const ExplicitTable<R,N,M,V,T> &table,
+	Matrix<V,1,T> &cx, Matrix<N,1,T> &x, Matrix<M,1,T> &u,
+	PdipResult<T> &result, MpcWarmStart<M*L,V,T> &warm
+)
+{
+	static_assert(!track_ref, "Explicit MPC regions are computed for a fixed stationary target");
+
+	Matrix<N,1,T> x0nau(x - xinfy);
+	Matrix<M,1,T> unau;
+
+	if(explicitLocate(table, x0nau, unau) >= 0)
+	{
+		for(int i = 0; i < M; ++i)
+		{
+			u(i,0) = unau(i,0) + uinfy(i,0);
+		}
+
+		result.iterations = 0;
+		result.gap = 0;
+		result.residual = 0;
+		result.status = PDIP_CONVERGED;
+		result.inner_iterations = 0;
+		warm.valid = false;
+
+		return;
+	}
+
+	mpc_dense<CHOLESKY, constraints, L, track_ref, qpiter, tol, early_exit, exit_tol, algorithm>(
+		AL,
+		Acal, Hcal, Mx,
+		umin, umax, uinfy,
+		xmin, xmax, xinfy,
+		Nxmin, Nxmax,
+		h_base,
+		cx, x, u,
+		result, warm
+	);
+}
@@ -0,0 +1,267 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+
+/*!
+@file   fixed_point.hpp
+*/
+
+/*!
+@brief  Signed fixed-point number with saturating arithmetic. Host model of an ap_fixed<I+F, I, AP_RND, AP_SAT> value,
+        meant to evaluate the accuracy of Matrix and the solvers without floating-point units.
+@tparam I   Number of integer bits, including the sign bit
+@tparam F   Number of fractional bits
+*/
+template<int I, int F>
+class FixedPoint
+{
+	static_assert(I >= 1, "At least the sign bit is needed");
+	static_assert(F >= 0, "Number of fractional bits must be positive");
+	static_assert(I + F <= 32, "Up to 32 bits are supported");
+
+public:
+	//! Integer type holding the raw value
+	using raw_type = std::int32_t;
+	//! Integer type used for intermediate results
+	using wide_type = std::int64_t;
+
+	static constexpr int WIDTH = I + F;
+	static constexpr wide_type RAW_MAX = (wide_type(1) << (WIDTH - 1)) - 1;
+	static constexpr wide_type RAW_MIN = -(wide_type(1) << (WIDTH - 1));
+
+	/*!
+	@brief  Zero initialized value
+	*/
+	FixedPoint() : m_raw(0) { }
+
+	/*!
+	@brief  Creates a value from an integer, saturating if out of range
+	*/
+	FixedPoint(int value) : m_raw(saturate(wide_type(value) * (wide_type(1) << F))) { }
+
+	/*!
+	@brief  Creates a value from a floating-point number, rounding to the nearest representable value and saturating
+	*/
+	FixedPoint(double value) : m_raw(fromDouble(value)) { }
+
+	/*!
+	@brief  Overloaded constructor provided by convenience
+	*/
+	FixedPoint(float value) : m_raw(fromDouble(value)) { }
+
+	/*!
+	@brief  Creates a value from its raw representation, saturating if out of range
+	@param  raw Value scaled by 2^F
+	*/
+	static FixedPoint fromRaw(wide_type raw)
+	{
+		FixedPoint res;
+		res.m_raw = saturate(raw);
+		return res;
+	}
+
+	//! Raw representation, value scaled by 2^F
+	raw_type raw() const
+	{
+		return m_raw;
+	}
+
+	explicit operator double() const
+	{
+		return static_cast<double>(m_raw) / static_cast<double>(wide_type(1) << F);
+	}
+
+	explicit operator float() const
+	{
+		return static_cast<float>(static_cast<double>(*this));
+	}
+
+	// Arithmetic
+
+	FixedPoint operator-() const
+	{
+		return fromRaw(-wide_type(m_raw));
+	}
+
+	friend FixedPoint operator+(const FixedPoint &lhs, const FixedPoint &rhs)
+	{
+		return fromRaw(wide_type(lhs.m_raw) + rhs.m_raw);
+	}
+
+	friend FixedPoint operator-(const FixedPoint &lhs, const FixedPoint &rhs)
+	{
+		return fromRaw(wide_type(lhs.m_raw) - rhs.m_raw);
+	}
+
+	friend FixedPoint operator*(const FixedPoint &lhs, const FixedPoint &rhs)
+	{
+		return fromRaw(roundShift(wide_type(lhs.m_raw) * rhs.m_raw));
+	}
+
+	/*!
+	@brief  Division. Division by zero saturates towards the sign of the dividend.
+	*/
+	friend FixedPoint operator/(const FixedPoint &lhs, const FixedPoint &rhs)
+	{
+		if(rhs.m_raw == 0)
+		{
+			return fromRaw(lhs.m_raw > 0 ? RAW_MAX : (lhs.m_raw < 0 ? RAW_MIN : 0));
+		}
+
+		wide_type num = wide_type(lhs.m_raw) * (wide_type(1) << F);
+		wide_type half = (rhs.m_raw > 0 ? rhs.m_raw : -wide_type(rhs.m_raw)) / 2;
+
+		// Round to nearest
+
+		num += ((num < 0) != (rhs.m_raw < 0)) ? -half : half;
+
+		return fromRaw(num / rhs.m_raw);
+	}
+
+	FixedPoint &operator+=(const FixedPoint &rhs) { return *this = *this + rhs; }
+	FixedPoint &operator-=(const FixedPoint &rhs) { return *this = *this - rhs; }
+	FixedPoint &operator*=(const FixedPoint &rhs) { return *this = *this * rhs; }
+	FixedPoint &operator/=(const FixedPoint &rhs) { return *this = *this / rhs; }
+
+	// Comparison
+
+	friend bool operator==(const FixedPoint &lhs, const FixedPoint &rhs) { return lhs.m_raw == rhs.m_raw; }
+	friend bool operator!=(const FixedPoint &lhs, const FixedPoint &rhs) { return lhs.m_raw != rhs.m_raw; }
+	friend bool operator<(const FixedPoint &lhs, const FixedPoint &rhs) { return lhs.m_raw < rhs.m_raw; }
+	friend bool operator>(const FixedPoint &lhs, const FixedPoint &rhs) { return lhs.m_raw > rhs.m_raw; }
+	friend bool operator<=(const FixedPoint &lhs, const FixedPoint &rhs) { return lhs.m_raw <= rhs.m_raw; }
+	friend bool operator>=(const FixedPoint &lhs, const FixedPoint &rhs) { return lhs.m_raw >= rhs.m_raw; }
+
+	// Math functions, found through ADL by the solvers
+
+	friend FixedPoint fabs(const FixedPoint &x)
+	{
+		return x.m_raw < 0 ? -x : x;
+	}
+
+	/*!
+	@brief  Square root computed bit by bit on the raw value. Negative inputs return zero.
+	*/
+	friend FixedPoint sqrt(const FixedPoint &x)
+	{
+		if(x.m_raw <= 0)
+		{
+			return FixedPoint();
+		}
+
+		// sqrt(raw * 2^F) is the raw result
+
+		std::uint64_t op = std::uint64_t(x.m_raw) << F;
+		std::uint64_t res = 0;
+		std::uint64_t one = std::uint64_t(1) << 62;
+
+		while(one > op)
+		{
+			one >>= 2;
+		}
+
+		while(one != 0)
+		{
+			if(op >= res + one)
+			{
+				op -= res + one;
+				res = (res >> 1) + one;
+			}
+			else
+			{
+				res >>= 1;
+			}
+
+			one >>= 2;
+		}
+
+		return fromRaw(static_cast<wide_type>(res));
+	}
+
+	/*!
+	@brief  Power function. Computed in double precision, provided for Matrix::operator^ and the tolerance set up.
+	*/
+	friend FixedPoint pow(const FixedPoint &x, const FixedPoint &e)
+	{
+		return FixedPoint(std::pow(static_cast<double>(x), static_cast<double>(e)));
+	}
+
+	// IO
+
+	friend std::ostream &operator<<(std::ostream &os, const FixedPoint &x)
+	{
+		return os << static_cast<double>(x);
+	}
+
+	friend std::istream &operator>>(std::istream &is, FixedPoint &x)
+	{
+		double value;
+
+		if(is >> value)
+		{
+			x = FixedPoint(value);
+		}
+
+		return is;
+	}
+
+private:
+	static raw_type saturate(wide_type raw)
+	{
+		return static_cast<raw_type>(raw > RAW_MAX ? RAW_MAX : (raw < RAW_MIN ? RAW_MIN : raw));
+	}
+
+	static raw_type fromDouble(double value)
+	{
+		double scaled = std::round(value * static_cast<double>(wide_type(1) << F));
+
+		// NaN saturates to the maximum
+
+		if(!(scaled < static_cast<double>(RAW_MAX)))
+		{
+			return static_cast<raw_type>(RAW_MAX);
+		}
+
+		if(!(scaled > static_cast<double>(RAW_MIN)))
+		{
+			return static_cast<raw_type>(RAW_MIN);
+		}
+
+		return static_cast<raw_type>(scaled);
+	}
+
+	static wide_type roundShift(wide_type value)
+	{
+		if(F == 0)
+		{
+			return value;
+		}
+
+		return (value + (wide_type(1) << (F > 0 ? F - 1 : 0))) >> F;
+	}
+
+	//! Value scaled by 2^F
+	raw_type m_raw;
+};
+
+/*!
+@brief  Numeric limits of FixedPoint. min() and epsilon() are the smallest positive value, one LSB.
+*/
+template<int I, int F>
+class std::numeric_limits<FixedPoint<I,F>>
+{
+public:
+	static constexpr bool is_specialized = true;
+	static constexpr bool is_signed = true;
+	static constexpr bool is_integer = false;
+	static constexpr bool is_exact = true;
+	static constexpr int digits = I + F - 1;
+
+	static FixedPoint<I,F> min() { return FixedPoint<I,F>::fromRaw(1); }
+	static FixedPoint<I,F> max() { return FixedPoint<I,F>::fromRaw(FixedPoint<I,F>::RAW_MAX); }
+	static FixedPoint<I,F> lowest() { return FixedPoint<I,F>::fromRaw(FixedPoint<I,F>::RAW_MIN); }
+	static FixedPoint<I,F> epsilon() { return FixedPoint<I,F>::fromRaw(1); }
+};
@@ -1,9 +1,30 @@
 #pragma once
 
-#include <vector>
+#include "generic_dense_defaults.hpp"
+#include "trajectory_file.hpp"
 
+//! Samples of the cosim trajectory. The arrays are flat, row-major per sample, as the columns of a trajectory file
 extern const int __cosim_iters;
-extern const std::vector<std::vector<float>> __cosim_x0;
-extern const std::vector<std::vector<float>> __cosim_x;
-extern const std::vector<std::vector<float>> __cosim_u;
-extern const std::vector<std::vector<float>> __cosim_yref;
+extern const float __cosim_x0[MPC_N];
+extern const float __cosim_x[];
+extern const float __cosim_u[];
+extern const float __cosim_yref[];
+
+/*!
+@brief  Cosim trajectory linked into the program, laid out as a mapped trajectory file
+*/
+inline TrajectoryView cosimTrajectory()
+{
+	TrajectoryView t;
+
+	t.samples = __cosim_iters;
+	t.N = MPC_N;
+	t.M = MPC_M;
+	t.P = MPC_P;
+	t.x0 = __cosim_x0;
+	t.u_data = __cosim_u;
+	t.x_data = __cosim_x;
+	t.yref_data = __cosim_yref;
+
+	return t;
+}
@@ -9,5 +9,21 @@
 #define MPC_CONSTRAINTS INPUT
 #define MPC_TRACK_REF 0
 #define MPC_QP_ITER 20
+#define MPC_INEXACT_NEWTON 0
 #define MPC_TOL -9
+#define MPC_EXIT_TOL -4
+// Options left at the baseline for the synthesized IP. The host tools of the Makefile change them with -D, see
+// HOST_OPTIONS
+#ifndef MPC_QP_ALGORITHM
+#define MPC_QP_ALGORITHM PDIP_FIXED_CENTERING
+#endif
+#ifndef MPC_EARLY_EXIT
+#define MPC_EARLY_EXIT 0
+#endif
+#ifndef MPC_WARM_START
+#define MPC_WARM_START 0
+#endif
+#define MPC_EXPLICIT_REGIONS 9
+#define MPC_CACHE_SIZE 0
+#define MPC_CACHE_TOL -3
 #define MPC_NAME dc_motor_2
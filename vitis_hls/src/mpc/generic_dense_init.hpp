@@ -1,25 +1,58 @@
 #pragma once
 
+#include "condense.hpp"
 #include "generic_dense_defaults.hpp"
+#include "mpc_controller.hpp"
 
-#define MPC_NAME_STR __str_name(MPC_NAME)
+#define MPC_NAME_STR __xstr_name(MPC_NAME)
+#define __xstr_name(x) __str_name(x)
 #define __str_name(x) #x
 
 extern const float __init_A[MPC_N*MPC_N];
 extern const float __init_B[MPC_N*MPC_M];
 
-extern const float __init_Acal[MPC_N*MPC_L*MPC_N];
-extern const float __init_Hcal[MPC_M*MPC_L*MPC_M*MPC_L];
-extern const float __init_h_base[MPC_M*MPC_L*MPC_N];
+extern const float __init_Q[MPC_N*MPC_N];
+extern const float __init_R[MPC_M*MPC_M];
+extern const float __init_P[MPC_N*MPC_N];
 
-extern const float __init_Mx[MPC_V*MPC_M*MPC_L];
 extern const float __init_umin[MPC_M];
 extern const float __init_umax[MPC_M];
 extern const float __init_xmin[MPC_N];
 extern const float __init_xmax[MPC_N];
 extern const float __init_Nxmin[MPC_N];
 extern const float __init_Nxmax[MPC_N];
-extern const float __init_cx[MPC_V];
+
+//! AL, Acal, Hcal, h_base, Mx and cx condensed from the arrays above. Defined constexpr, see condense.hpp
+extern const MpcCondensed<MPC_N, MPC_M, MPC_L, MPC_V> __init_condensed;
 
 extern const float __init_Lu[MPC_M*MPC_P];
 extern const float __init_Lx[MPC_N*MPC_P];
+
+extern const int __explicit_regions;
+extern const float __explicit_table[MPC_EXPLICIT_REGIONS*(MPC_V*MPC_N + MPC_V + MPC_M*MPC_N + MPC_M)];
+
+/*!
+@brief  Model of the generated system, built from __init_condensed and the __init_ and __explicit_ tables
+*/
+inline MpcModel<MPC_N, MPC_M, MPC_P, MPC_L, MPC_V, float, MPC_EXPLICIT_REGIONS> genericDenseModel()
+{
+	MpcModel<MPC_N, MPC_M, MPC_P, MPC_L, MPC_V, float, MPC_EXPLICIT_REGIONS> model;
+
+	model.AL = Matrix<MPC_N,MPC_N>(__init_condensed.AL);
+	model.Acal = Matrix<MPC_N*MPC_L,MPC_N>(__init_condensed.Acal);
+	model.Hcal = Matrix<MPC_M*MPC_L,MPC_M*MPC_L>(__init_condensed.Hcal);
+	model.h_base = Matrix<MPC_M*MPC_L,MPC_N>(__init_condensed.h_base);
+	model.Mx = Matrix<MPC_V,MPC_M*MPC_L>(__init_condensed.Mx);
+	model.umin = Matrix<MPC_M,1>(__init_umin);
+	model.umax = Matrix<MPC_M,1>(__init_umax);
+	model.xmin = Matrix<MPC_N,1>(__init_xmin);
+	model.xmax = Matrix<MPC_N,1>(__init_xmax);
+	model.Nxmin = Matrix<MPC_N,1>(__init_Nxmin);
+	model.Nxmax = Matrix<MPC_N,1>(__init_Nxmax);
+	model.cx = Matrix<MPC_V,1>(__init_condensed.cx);
+	model.Lx = Matrix<MPC_N,MPC_P>(__init_Lx);
+	model.Lu = Matrix<MPC_M,MPC_P>(__init_Lu);
+	model.table = ExplicitTable<MPC_EXPLICIT_REGIONS, MPC_N, MPC_M, MPC_V>(__explicit_table, __explicit_regions);
+
+	return model;
+}
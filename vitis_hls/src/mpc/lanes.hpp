@@ -0,0 +1,263 @@
+#pragma once
+
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+/*!
+@file   lanes.hpp
+*/
+
+/*!
+@brief  Per-lane boolean, result of comparing two Lanes values
+@tparam K   Number of lanes
+*/
+template<int K>
+struct LaneMask
+{
+	bool m[K];
+
+	bool operator[](int i) const { return m[i]; }
+
+	//! Mask with every lane set to value
+	static LaneMask all(bool value)
+	{
+		LaneMask res;
+
+		for(int i = 0; i < K; ++i)
+		{
+			res.m[i] = value;
+		}
+
+		return res;
+	}
+
+	//! True if any lane is set
+	bool any() const
+	{
+		bool res = false;
+
+		for(int i = 0; i < K; ++i)
+		{
+			res = res || m[i];
+		}
+
+		return res;
+	}
+
+	friend LaneMask operator&&(const LaneMask &lhs, const LaneMask &rhs)
+	{
+		LaneMask res;
+
+		for(int i = 0; i < K; ++i)
+		{
+			res.m[i] = lhs.m[i] && rhs.m[i];
+		}
+
+		return res;
+	}
+
+	friend LaneMask operator||(const LaneMask &lhs, const LaneMask &rhs)
+	{
+		LaneMask res;
+
+		for(int i = 0; i < K; ++i)
+		{
+			res.m[i] = lhs.m[i] || rhs.m[i];
+		}
+
+		return res;
+	}
+
+	friend LaneMask operator!(const LaneMask &mask)
+	{
+		LaneMask res;
+
+		for(int i = 0; i < K; ++i)
+		{
+			res.m[i] = !mask.m[i];
+		}
+
+		return res;
+	}
+};
+
+/*!
+@brief  Native vector type holding K values of type T. With GCC and Clang, floating-point lanes whose size is a power of
+        two use the vector extensions, so arithmetic maps to SIMD instructions at any optimization level. Otherwise
+        lanes are processed by plain loops.
+*/
+template<int K, typename T, bool = std::is_floating_point<T>::value && (K & (K - 1)) == 0>
+struct LaneVector
+{
+	static constexpr bool enabled = false;
+	static constexpr int align = alignof(T);
+};
+
+#if defined(__GNUC__) && !defined(__SYNTHESIS__)
+template<int K, typename T>
+struct LaneVector<K, T, true>
+{
+	typedef T type __attribute__((vector_size(K * sizeof(T))));
+
+	static constexpr bool enabled = true;
+	static constexpr int align = K * sizeof(T) > 64 ? 64 : K * sizeof(T);
+};
+#endif
+
+/*!
+@brief  K values of type T processed in lockstep, one per SIMD lane. A Matrix<N,M,Lanes<K,T>> stores K matrices in
+        structure-of-arrays layout: every element keeps its K lanes contiguous, so element-wise code compiles to
+        vector instructions without intrinsics. Comparisons return a LaneMask, branches are written with select().
+@tparam K   Number of lanes
+@tparam T   Data type of every lane
+*/
+template<int K, typename T = float>
+class Lanes
+{
+	static_assert(K >= 1, "At least one lane is needed");
+
+public:
+	static constexpr int LANES = K;
+
+	Lanes() { }
+
+	/*!
+	@brief  Broadcasts a value to every lane
+	*/
+	Lanes(T value)
+	{
+		for(int i = 0; i < K; ++i)
+		{
+			m_v[i] = value;
+		}
+	}
+
+	/*!
+	@brief  Overloaded constructor provided by convenience, so literals broadcast as they do for T
+	*/
+	template<typename U, typename = typename std::enable_if<std::is_arithmetic<U>::value>::type>
+	Lanes(U value) : Lanes(T(value)) { }
+
+	T &operator[](int i) { return m_v[i]; }
+	const T &operator[](int i) const { return m_v[i]; }
+
+	// Arithmetic
+
+	Lanes operator-() const
+	{
+		Lanes res;
+
+		for(int i = 0; i < K; ++i)
+		{
+			res.m_v[i] = -m_v[i];
+		}
+
+		return res;
+	}
+
+	friend Lanes operator+(const Lanes &lhs, const Lanes &rhs) { return apply(lhs, rhs, [](auto a, auto b) { return a + b; }); }
+	friend Lanes operator-(const Lanes &lhs, const Lanes &rhs) { return apply(lhs, rhs, [](auto a, auto b) { return a - b; }); }
+	friend Lanes operator*(const Lanes &lhs, const Lanes &rhs) { return apply(lhs, rhs, [](auto a, auto b) { return a * b; }); }
+	friend Lanes operator/(const Lanes &lhs, const Lanes &rhs) { return apply(lhs, rhs, [](auto a, auto b) { return a / b; }); }
+
+	Lanes &operator+=(const Lanes &rhs) { return *this = *this + rhs; }
+	Lanes &operator-=(const Lanes &rhs) { return *this = *this - rhs; }
+	Lanes &operator*=(const Lanes &rhs) { return *this = *this * rhs; }
+	Lanes &operator/=(const Lanes &rhs) { return *this = *this / rhs; }
+
+	// Comparison
+
+	friend LaneMask<K> operator<(const Lanes &lhs, const Lanes &rhs) { return compare(lhs, rhs, [](T a, T b) { return a < b; }); }
+	friend LaneMask<K> operator>(const Lanes &lhs, const Lanes &rhs) { return compare(lhs, rhs, [](T a, T b) { return a > b; }); }
+	friend LaneMask<K> operator<=(const Lanes &lhs, const Lanes &rhs) { return compare(lhs, rhs, [](T a, T b) { return a <= b; }); }
+	friend LaneMask<K> operator>=(const Lanes &lhs, const Lanes &rhs) { return compare(lhs, rhs, [](T a, T b) { return a >= b; }); }
+
+	/*!
+	@brief  Per-lane choice, mask ? a : b
+	*/
+	friend Lanes select(const LaneMask<K> &mask, const Lanes &a, const Lanes &b)
+	{
+		Lanes res;
+
+		for(int i = 0; i < K; ++i)
+		{
+			res.m_v[i] = mask.m[i] ? a.m_v[i] : b.m_v[i];
+		}
+
+		return res;
+	}
+
+	// Math functions, found through ADL
+
+	friend Lanes fabs(const Lanes &x)
+	{
+		Lanes res;
+
+		for(int i = 0; i < K; ++i)
+		{
+			using std::fabs;
+			res.m_v[i] = fabs(x.m_v[i]);
+		}
+
+		return res;
+	}
+
+	friend Lanes sqrt(const Lanes &x)
+	{
+		Lanes res;
+
+		for(int i = 0; i < K; ++i)
+		{
+			using std::sqrt;
+			res.m_v[i] = sqrt(x.m_v[i]);
+		}
+
+		return res;
+	}
+
+private:
+	template<typename F>
+	static Lanes apply(const Lanes &lhs, const Lanes &rhs, F f)
+	{
+		Lanes res;
+		apply(res, lhs, rhs, f, std::integral_constant<bool, LaneVector<K,T>::enabled>());
+		return res;
+	}
+
+	template<typename F>
+	static void apply(Lanes &res, const Lanes &lhs, const Lanes &rhs, F f, std::false_type)
+	{
+		for(int i = 0; i < K; ++i)
+		{
+			res.m_v[i] = f(lhs.m_v[i], rhs.m_v[i]);
+		}
+	}
+
+	template<typename F>
+	static void apply(Lanes &res, const Lanes &lhs, const Lanes &rhs, F f, std::true_type)
+	{
+		typename LaneVector<K,T>::type a, b, r;
+
+		std::memcpy(&a, lhs.m_v, sizeof(a));
+		std::memcpy(&b, rhs.m_v, sizeof(b));
+		r = f(a, b);
+		std::memcpy(res.m_v, &r, sizeof(r));
+	}
+
+	template<typename F>
+	static LaneMask<K> compare(const Lanes &lhs, const Lanes &rhs, F f)
+	{
+		LaneMask<K> res;
+
+		for(int i = 0; i < K; ++i)
+		{
+			res.m[i] = f(lhs.m_v[i], rhs.m_v[i]);
+		}
+
+		return res;
+	}
+
+	//! One value per lane
+	alignas(LaneVector<K,T>::align) T m_v[K];
+};
@@ -7,72 +7,271 @@
 */
 
 /*!
-@brief  Solves a linear system using Cholesky factorization. Considers the system in the form Ax=v
-@tparam N   Number of equations of the linear system
+@brief  LDL' factorization of a symmetric matrix
+@tparam N   Size of the factorized matrix
 @tparam T   Data type
-@param  A   NxN matrix with system coefficients
-@param  v   Nx1 vector with constant coefficients
-@param  x   Nx1 resulting vector with system solution
 */
 template<int N, typename T = float>
-void lschol(const Matrix<N,N,T> &A, Matrix<N,1,T> &v, Matrix<N,1,T> &x)
+struct LdlFactor
 {
-	Matrix<N,N,T> L;
-	Matrix<N,1,T> D, sumCache(0, false);
-
-	// Get diagonal and lower-triangular matrices
+	Matrix<N,N,T> L;    //!< Unit lower-triangular factor. Only the elements below the diagonal are valid
+	Matrix<N,1,T> D;    //!< Diagonal factor
+};
 
-	for(int j = 0; j < N; ++j)
+/*!
+@brief  LDL' factorization and triangular solves, specialised on the size. The general case runs the column loops,
+        sizes 1 to 4 are closed-form straight-line code for the tiny controllers.
+@tparam N   Size of the factorized matrix
+@tparam T   Data type
+*/
+template<int N, typename T>
+struct LdlKernel
+{
+	static void factor(const Matrix<N,N,T> &A, LdlFactor<N,T> &F)
 	{
-		// Get value for the diagonal
-
-		D(j,0) = A(j,j) - sumCache(j,0);
+		Matrix<N,1,T> sumCache(T(0), false);
 
-		// Iterate across rows
+		// Get diagonal and lower-triangular matrices
 
-		for(int i = j+1; i < N; ++i)
+		for(int j = 0; j < N; ++j)
 		{
-			T sum = A(i,j);
+			// Get value for the diagonal
+
+			F.D(j,0) = A(j,j) - sumCache(j,0);
 
-			for(int k = 0; k < j; ++k)
+			// Iterate across rows
+
+			for(int i = j+1; i < N; ++i)
 			{
-				sum -= L(i,k) * L(j,k) * D(k,0);
-			}
+				T sum = A(i,j);
 
-			T sum2 = sum / D(j,0);
-			sumCache(i,0) += sum * sum2;
+				for(int k = 0; k < j; ++k)
+				{
+					sum -= F.L(i,k) * F.L(j,k) * F.D(k,0);
+				}
 
-			L(i,j) = sum2;
+				T sum2 = sum / F.D(j,0);
+				sumCache(i,0) += sum * sum2;
+
+				F.L(i,j) = sum2;
+			}
 		}
 	}
 
-	// Solve first system
+	static void solve(const LdlFactor<N,T> &F, Matrix<N,1,T> &v, Matrix<N,1,T> &x)
+	{
+		// Solve first system
 
-	Matrix<N,1,T> y;
+		Matrix<N,1,T> y;
 
-	for(int j = 0; j < N; ++j)
-	{
+		for(int j = 0; j < N; ++j)
+		{
 #pragma HLS PIPELINE II=10
-		y(j,0) = v(j,0);
+			y(j,0) = v(j,0);
+
+			for(int i = j+1; i < N; ++i)
+			{
+				v(i,0) -= F.L(i,j) * v(j,0);
+			}
+
+			y(j,0) /= F.D(j,0);
+		}
 
-		for(int i = j+1; i < N; ++i)
+		// Solve final system
+
+		for(int j = N-1; j >= 0; --j)
 		{
-			v(i,0) -= L(i,j) * v(j,0);
+#pragma HLS PIPELINE II=10
+			x(j,0) = y(j,0);
+
+			for(int i = j-1; i >= 0; --i)
+			{
+				y(i,0) -= F.L(j,i) * y(j,0);
+			}
 		}
+	}
+};
 
-		y(j,0) /= D(j,0);
+template<typename T>
+struct LdlKernel<1, T>
+{
+	static void factor(const Matrix<1,1,T> &A, LdlFactor<1,T> &F)
+	{
+		F.D(0,0) = A(0,0);
 	}
 
-	// Solve final system
+	static void solve(const LdlFactor<1,T> &F, Matrix<1,1,T> &v, Matrix<1,1,T> &x)
+	{
+		x(0,0) = v(0,0) / F.D(0,0);
+	}
+};
 
-	for(int j = N-1; j >= 0; --j)
+template<typename T>
+struct LdlKernel<2, T>
+{
+	static void factor(const Matrix<2,2,T> &A, LdlFactor<2,T> &F)
 	{
-#pragma HLS PIPELINE II=10
-		x(j,0) = y(j,0);
+		T l10 = A(1,0) / A(0,0);
+
+		F.D(0,0) = A(0,0);
+		F.D(1,0) = A(1,1) - l10 * A(1,0);
+		F.L(1,0) = l10;
+	}
+
+	static void solve(const LdlFactor<2,T> &F, Matrix<2,1,T> &v, Matrix<2,1,T> &x)
+	{
+		v(1,0) -= F.L(1,0) * v(0,0);
+
+		x(1,0) = v(1,0) / F.D(1,0);
+		x(0,0) = v(0,0) / F.D(0,0) - F.L(1,0) * x(1,0);
+	}
+};
+
+template<typename T>
+struct LdlKernel<3, T>
+{
+	static void factor(const Matrix<3,3,T> &A, LdlFactor<3,T> &F)
+	{
+		T d0 = A(0,0);
+		T l10 = A(1,0) / d0;
+		T l20 = A(2,0) / d0;
+		T d1 = A(1,1) - l10 * A(1,0);
+		T s21 = A(2,1) - l20 * A(1,0);
+		T l21 = s21 / d1;
+
+		F.D(0,0) = d0;
+		F.D(1,0) = d1;
+		F.D(2,0) = A(2,2) - l20 * A(2,0) - l21 * s21;
+		F.L(1,0) = l10;
+		F.L(2,0) = l20;
+		F.L(2,1) = l21;
+	}
+
+	static void solve(const LdlFactor<3,T> &F, Matrix<3,1,T> &v, Matrix<3,1,T> &x)
+	{
+		v(1,0) -= F.L(1,0) * v(0,0);
+		v(2,0) -= F.L(2,0) * v(0,0) + F.L(2,1) * v(1,0);
+
+		x(2,0) = v(2,0) / F.D(2,0);
+		x(1,0) = v(1,0) / F.D(1,0) - F.L(2,1) * x(2,0);
+		x(0,0) = v(0,0) / F.D(0,0) - F.L(1,0) * x(1,0) - F.L(2,0) * x(2,0);
+	}
+};
+
+template<typename T>
+struct LdlKernel<4, T>
+{
+	static void factor(const Matrix<4,4,T> &A, LdlFactor<4,T> &F)
+	{
+		T d0 = A(0,0);
+		T l10 = A(1,0) / d0;
+		T l20 = A(2,0) / d0;
+		T l30 = A(3,0) / d0;
+		T d1 = A(1,1) - l10 * A(1,0);
+		T s21 = A(2,1) - l20 * A(1,0);
+		T s31 = A(3,1) - l30 * A(1,0);
+		T l21 = s21 / d1;
+		T l31 = s31 / d1;
+		T d2 = A(2,2) - l20 * A(2,0) - l21 * s21;
+		T s32 = A(3,2) - l30 * A(2,0) - l31 * s21;
+		T l32 = s32 / d2;
+
+		F.D(0,0) = d0;
+		F.D(1,0) = d1;
+		F.D(2,0) = d2;
+		F.D(3,0) = A(3,3) - l30 * A(3,0) - l31 * s31 - l32 * s32;
+		F.L(1,0) = l10;
+		F.L(2,0) = l20;
+		F.L(3,0) = l30;
+		F.L(2,1) = l21;
+		F.L(3,1) = l31;
+		F.L(3,2) = l32;
+	}
+
+	static void solve(const LdlFactor<4,T> &F, Matrix<4,1,T> &v, Matrix<4,1,T> &x)
+	{
+		v(1,0) -= F.L(1,0) * v(0,0);
+		v(2,0) -= F.L(2,0) * v(0,0) + F.L(2,1) * v(1,0);
+		v(3,0) -= F.L(3,0) * v(0,0) + F.L(3,1) * v(1,0) + F.L(3,2) * v(2,0);
+
+		x(3,0) = v(3,0) / F.D(3,0);
+		x(2,0) = v(2,0) / F.D(2,0) - F.L(3,2) * x(3,0);
+		x(1,0) = v(1,0) / F.D(1,0) - F.L(2,1) * x(2,0) - F.L(3,1) * x(3,0);
+		x(0,0) = v(0,0) / F.D(0,0) - F.L(1,0) * x(1,0) - F.L(2,0) * x(2,0) - F.L(3,0) * x(3,0);
+	}
+};
+
+/*!
+@brief  Computes the Cholesky (LDL') factorization of A.
+@tparam N   Number of equations of the linear system
+@tparam T   Data type
+@param  A   NxN symmetric positive definite matrix
+@param  F   Resulting factorization
+*/
+template<int N, typename T = float>
+void lscholFactor(const Matrix<N,N,T> &A, LdlFactor<N,T> &F)
+{
+	LdlKernel<N,T>::factor(A, F);
+}
+
+/*!
+@brief  Solves a linear system Ax=v from the Cholesky (LDL') factorization of A.
+@tparam N   Number of equations of the linear system
+@tparam T   Data type
+@param  F   Factorization of A, computed by lscholFactor
+@param  v   Nx1 vector with constant coefficients. Overwritten during the forward substitution
+@param  x   Nx1 resulting vector with system solution
+*/
+template<int N, typename T = float>
+void lscholSolve(const LdlFactor<N,T> &F, Matrix<N,1,T> &v, Matrix<N,1,T> &x)
+{
+	LdlKernel<N,T>::solve(F, v, x);
+}
 
-		for(int i = j-1; i >= 0; --i)
+/*!
+@brief  Solves a linear system using Cholesky factorization. Considers the system in the form Ax=v
+@tparam N   Number of equations of the linear system
+@tparam T   Data type
+@param  A   NxN matrix with system coefficients
+@param  v   Nx1 vector with constant coefficients
+@param  x   Nx1 resulting vector with system solution
+*/
+template<int N, typename T = float>
+void lschol(const Matrix<N,N,T> &A, Matrix<N,1,T> &v, Matrix<N,1,T> &x)
+{
+	LdlFactor<N,T> F;
+
+	lscholFactor(A, F);
+	lscholSolve(F, v, x);
+}
+
+/*!
+@brief  Inverse of a symmetric positive definite matrix, one LDL' solve per column. Meant for small blocks
+@tparam N   Size of the matrix
+@tparam T   Data type
+@param  A   NxN symmetric positive definite matrix
+@return Inverse of A
+*/
+template<int N, typename T = float>
+Matrix<N,N,T> lscholInverse(const Matrix<N,N,T> &A)
+{
+	LdlFactor<N,T> F;
+	Matrix<N,N,T> res;
+
+	lscholFactor(A, F);
+
+	for(int j = 0; j < N; ++j)
+	{
+		Matrix<N,1,T> e(T(0)), x;
+		e(j,0) = 1;
+
+		lscholSolve(F, e, x);
+
+		for(int i = 0; i < N; ++i)
 		{
-			y(i,0) -= L(j,i) * y(j,0);
+			res(i,j) = x(i,0);
 		}
 	}
+
+	return res;
 }
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstddef>
+
+#ifdef _WIN32
+// windows.h would otherwise define min and max macros, which break std::numeric_limits<T>::min()
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*!
+@file   mapped_file.hpp
+@brief  Memory mapping of a whole file, shared by the model files of model_file.hpp and the trajectory files of
+        trajectory_file.hpp. POSIX mmap, or file mappings on Windows, where the Vitis HLS testbenches are also built.
+*/
+
+/*!
+@brief  RAII mapping of a file, read-only or created read-write with a fixed size. Pages are loaded on first access,
+        so mapping a file of any length costs the same and nothing is copied.
+*/
+class MappedFile
+{
+public:
+	MappedFile() : m_base(nullptr), m_bytes(0)
+	{ }
+
+	~MappedFile()
+	{
+		close();
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile &operator=(const MappedFile&) = delete;
+
+	/*!
+	@brief  Maps an existing file read-only, unmapping the previous one
+	@return false if the file is missing, empty or cannot be mapped
+	*/
+	bool open(const char *path)
+	{
+		close();
+
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		LARGE_INTEGER size;
+
+		if(file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size) || size.QuadPart <= 0)
+		{
+			if(file != INVALID_HANDLE_VALUE)
+			{
+				CloseHandle(file);
+			}
+
+			return false;
+		}
+
+		return map(file, std::size_t(size.QuadPart), false);
+#else
+		int fd = ::open(path, O_RDONLY);
+		struct stat st;
+
+		if(fd < 0 || fstat(fd, &st) != 0 || st.st_size <= 0)
+		{
+			if(fd >= 0)
+			{
+				::close(fd);
+			}
+
+			return false;
+		}
+
+		return map(fd, std::size_t(st.st_size), false);
+#endif
+	}
+
+	/*!
+	@brief  Creates or truncates a file of the given size and maps it read-write, unmapping the previous one
+	@return false if the file cannot be created, sized or mapped
+	*/
+	bool create(const char *path, std::size_t bytes)
+	{
+		close();
+
+		if(bytes == 0)
+		{
+			return false;
+		}
+
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+		if(file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		// The mapping object extends the file to its size
+
+		return map(file, bytes, true);
+#else
+		int fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+		if(fd < 0 || ftruncate(fd, off_t(bytes)) != 0)
+		{
+			if(fd >= 0)
+			{
+				::close(fd);
+			}
+
+			return false;
+		}
+
+		return map(fd, bytes, true);
+#endif
+	}
+
+	//! Unmaps the file. Pages written through a read-write mapping reach the file
+	void close()
+	{
+		if(m_base)
+		{
+#ifdef _WIN32
+			UnmapViewOfFile(m_base);
+#else
+			munmap(m_base, m_bytes);
+#endif
+		}
+
+		m_base = nullptr;
+		m_bytes = 0;
+	}
+
+	bool isOpen() const { return m_base != nullptr; }
+
+	void *data() { return m_base; }
+	const void *data() const { return m_base; }
+	std::size_t size() const { return m_bytes; }
+
+private:
+#ifdef _WIN32
+	bool map(HANDLE file, std::size_t bytes, bool write)
+	{
+		const unsigned long long size = bytes;
+		HANDLE mapping = CreateFileMappingA(file, nullptr, write ? PAGE_READWRITE : PAGE_READONLY,
+			DWORD(size >> 32), DWORD(size & 0xFFFFFFFFu), nullptr);
+		void *base = mapping ? MapViewOfFile(mapping, write ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, bytes) : nullptr;
+
+		// The view keeps the mapping alive
+
+		if(mapping)
+		{
+			CloseHandle(mapping);
+		}
+
+		CloseHandle(file);
+
+		if(!base)
+		{
+			return false;
+		}
+#else
+	bool map(int fd, std::size_t bytes, bool write)
+	{
+		void *base = mmap(nullptr, bytes, write ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd);
+
+		if(base == MAP_FAILED)
+		{
+			return false;
+		}
+#endif
+
+		m_base = base;
+		m_bytes = bytes;
+
+		return true;
+	}
+
+	void *m_base;
+	std::size_t m_bytes;
+};
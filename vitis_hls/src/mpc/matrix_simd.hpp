@@ -0,0 +1,292 @@
+#pragma once
+
+#include "MatrixExpr.hpp"
+
+/*!
+@file   matrix_simd.hpp
+@brief  Vector kernels for float matrices in the host build. The instruction set is selected at compile time, AVX-512,
+        AVX2 with FMA or AArch64 NEON in that order. Synthesis, data types other than float, targets without any of them
+        or builds defining MATRIX_NO_SIMD use the reference loops of MatrixEvalLoops.
+
+Only the kernels that beat the loops the compiler vectorises by itself are kept, and only from the sizes where they do,
+measured with bench_generic_dense against -DMATRIX_NO_SIMD on AVX-512:
+
+    products    Runs of at least one vector, MIN_RUN. The 20x20 product and the 40x20 and 128x20 multTr of the (4, 2, 10)
+                plant run 3 to 4.5 times faster. Shorter runs, as the 10x10 product or the 34x5 multTr of the (2, 1, 5)
+                plant, were no faster and use the loops
+    dot         From two vectors, MIN_DOT: 2 to 5 times faster from 34 elements. Below that the loops are as fast
+    emul, ediv, scalar operations   Never measurably faster than the fused loops, which also avoid a pass per operator,
+                so they have no kernel
+*/
+
+#if !defined(__SYNTHESIS__) && !defined(MATRIX_NO_SIMD)
+#if defined(__AVX512F__)
+#define MATRIX_SIMD_AVX512
+#elif defined(__AVX2__) && defined(__FMA__)
+#define MATRIX_SIMD_AVX2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define MATRIX_SIMD_NEON
+#endif
+#endif
+
+#if defined(MATRIX_SIMD_AVX512)
+
+#include <immintrin.h>
+
+#define MATRIX_SIMD "AVX-512"
+#define MATRIX_SIMD_ALIGN 64
+
+/*!
+@brief  Vector of floats of the selected instruction set
+*/
+struct SimdFloat
+{
+	using type = __m512;
+	static constexpr int WIDTH = 16;
+
+	static type load(const float *p) { return _mm512_loadu_ps(p); }
+	static void store(float *p, type v) { _mm512_storeu_ps(p, v); }
+	static type set(float v) { return _mm512_set1_ps(v); }
+	//! a*b + c
+	static type fma(type a, type b, type c) { return _mm512_fmadd_ps(a, b, c); }
+
+	static float sum(type v)
+	{
+		// Spilled to memory, the AVX-512 extract and reduce intrinsics trigger -Wuninitialized in GCC 12
+		alignas(64) float lanes[WIDTH];
+		_mm512_store_ps(lanes, v);
+
+		float res = 0.0f;
+
+		for(int i = 0; i < WIDTH; ++i)
+		{
+			res += lanes[i];
+		}
+
+		return res;
+	}
+};
+
+#elif defined(MATRIX_SIMD_AVX2)
+
+#include <immintrin.h>
+
+#define MATRIX_SIMD "AVX2"
+#define MATRIX_SIMD_ALIGN 32
+
+struct SimdFloat
+{
+	using type = __m256;
+	static constexpr int WIDTH = 8;
+
+	static type load(const float *p) { return _mm256_loadu_ps(p); }
+	static void store(float *p, type v) { _mm256_storeu_ps(p, v); }
+	static type set(float v) { return _mm256_set1_ps(v); }
+	static type fma(type a, type b, type c) { return _mm256_fmadd_ps(a, b, c); }
+
+	static float sum(type v)
+	{
+		__m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+		s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+		s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+		return _mm_cvtss_f32(s);
+	}
+};
+
+#elif defined(MATRIX_SIMD_NEON)
+
+#include <arm_neon.h>
+
+#define MATRIX_SIMD "NEON"
+#define MATRIX_SIMD_ALIGN 16
+
+struct SimdFloat
+{
+	using type = float32x4_t;
+	static constexpr int WIDTH = 4;
+
+	static type load(const float *p) { return vld1q_f32(p); }
+	static void store(float *p, type v) { vst1q_f32(p, v); }
+	static type set(float v) { return vdupq_n_f32(v); }
+	static type fma(type a, type b, type c) { return vfmaq_f32(c, a, b); }
+	static float sum(type v) { return vaddvq_f32(v); }
+};
+
+#endif
+
+#ifdef MATRIX_SIMD
+
+/*!
+@brief  Alignment of the storage of a matrix. Only float matrices of at least one vector are aligned to it, smaller
+        ones never reach a kernel and would only grow.
+*/
+template<int N, int M, typename T>
+struct MatrixAlign
+{
+	static constexpr int value = alignof(T);
+};
+
+template<int N, int M>
+struct MatrixAlign<N, M, float>
+{
+	static constexpr int value = N*M >= SimdFloat::WIDTH ? MATRIX_SIMD_ALIGN : alignof(float);
+};
+
+/*!
+@brief  Kernels over contiguous float arrays. The last n % WIDTH elements are processed by scalar code.
+*/
+struct MatrixSimd
+{
+	using S = SimdFloat;
+
+	//! Shortest contiguous run of a product computed by the kernels
+	static constexpr int MIN_RUN = S::WIDTH;
+	//! Fewest elements of a dot product or squared sum computed by the kernels
+	static constexpr int MIN_DOT = 2 * S::WIDTH;
+
+	/*!
+	@brief  Computes a'*b
+	*/
+	static float dot(const float *a, const float *b, int n)
+	{
+		S::type acc = S::set(0.0f);
+		int i = 0;
+
+		for(; i + S::WIDTH <= n; i += S::WIDTH)
+		{
+			acc = S::fma(S::load(a + i), S::load(b + i), acc);
+		}
+
+		float res = S::sum(acc);
+
+		for(; i < n; ++i)
+		{
+			res += a[i] * b[i];
+		}
+
+		return res;
+	}
+
+	/*!
+	@brief  Computes y += a*x
+	*/
+	static void axpy(float *y, float a, const float *x, int n)
+	{
+		S::type va = S::set(a);
+		int i = 0;
+
+		for(; i + S::WIDTH <= n; i += S::WIDTH)
+		{
+			S::store(y + i, S::fma(va, S::load(x + i), S::load(y + i)));
+		}
+
+		for(; i < n; ++i)
+		{
+			y[i] += a * x[i];
+		}
+	}
+
+	static void zero(float *dst, int n)
+	{
+		for(int i = 0; i < n; ++i)
+		{
+			dst[i] = 0.0f;
+		}
+	}
+};
+
+/*!
+@brief  Matrix products. Rows are accumulated with axpy so every operand is read with unit stride, including the
+        transposed one of multTr. Products whose contiguous runs are shorter than MIN_RUN use the reference loops.
+*/
+template<bool transpose_lhs, typename L, typename R, int N, int K, int P>
+struct MatrixEval<MatrixProductExpr<transpose_lhs, L, R, N, K, P, float>> : MatrixEvalLoops
+{
+	template<typename E>
+	static void assign(Matrix<N,P,float> &dst, const MatrixExpr<E,N,P,float> &expr)
+	{
+		// Length of the runs read by the kernels below
+		constexpr int run = (P == 1) ? (transpose_lhs ? N : K) : P;
+
+		if(run < MatrixSimd::MIN_RUN)
+		{
+			MatrixEvalLoops::assign(dst, expr);
+			return;
+		}
+
+		const float *a = expr.derived().lhs().data();
+		const float *b = expr.derived().rhs().data();
+		float *c = dst.data();
+
+		if(transpose_lhs)
+		{
+			// a is KxN
+			MatrixSimd::zero(c, N*P);
+
+			for(int k = 0; k < K; ++k)
+			{
+				if(P == 1)
+				{
+					MatrixSimd::axpy(c, b[k], a + k*N, N);
+				}
+				else
+				{
+					for(int i = 0; i < N; ++i)
+					{
+						MatrixSimd::axpy(c + i*P, a[k*N + i], b + k*P, P);
+					}
+				}
+			}
+		}
+		else if(P == 1)
+		{
+			for(int i = 0; i < N; ++i)
+			{
+				c[i] = MatrixSimd::dot(a + i*K, b, K);
+			}
+		}
+		else
+		{
+			for(int i = 0; i < N; ++i)
+			{
+				MatrixSimd::zero(c + i*P, P);
+
+				for(int k = 0; k < K; ++k)
+				{
+					MatrixSimd::axpy(c + i*P, a[i*K + k], b + k*P, P);
+				}
+			}
+		}
+	}
+};
+
+/*!
+@brief  Reductions over a matrix, dot and squaredSum, from MIN_DOT elements
+*/
+template<int N, int M>
+struct MatrixEval<Matrix<N,M,float>> : MatrixEvalLoops
+{
+	using MatrixEvalLoops::dot;
+
+	static float dot(const MatrixExpr<Matrix<N,M,float>,N,M,float> &lhs, const MatrixExpr<Matrix<N,M,float>,N,M,float> &rhs)
+	{
+		if(N*M < MatrixSimd::MIN_DOT)
+		{
+			return MatrixEvalLoops::dot(lhs, rhs);
+		}
+
+		return MatrixSimd::dot(lhs.derived().data(), rhs.derived().data(), N*M);
+	}
+
+	static float squaredSum(const MatrixExpr<Matrix<N,M,float>,N,M,float> &expr)
+	{
+		if(N*M < MatrixSimd::MIN_DOT)
+		{
+			return MatrixEvalLoops::squaredSum(expr);
+		}
+
+		return MatrixSimd::dot(expr.derived().data(), expr.derived().data(), N*M);
+	}
+};
+
+#endif
@@ -16,12 +16,13 @@
 @param  iter_max    Maximum number of iterations
 @param  tolerance   Maximum desirable error to stop iterations
 @param  x   Nx1 vector for resulting values.
+@param  iter_cap    Runtime limit of the iterations, below iter_max when a rough solution is enough
 @return Number of iterations performed by the algorithm
 */
 template<int iter_max, int N, typename T = float>
-int minres(const Matrix<N,N,T> &A, const Matrix<N,1,T> &b, Matrix<N,1,T> &x0, T tolerance, Matrix<N,1,T> &x)
+int minres(const Matrix<N,N,T> &A, const Matrix<N,1,T> &b, Matrix<N,1,T> &x0, T tolerance, Matrix<N,1,T> &x, int iter_cap = iter_max)
 {
-	Matrix<N,1,T> v(0, false), w(0, false), v_old, w_old, Av;
+	Matrix<N,1,T> v(T(0), false), w(T(0), false), v_old, w_old, Av;
 	Matrix<N,1,T> v_hat = b - A*x0;
 	T beta = sqrt(v_hat.squaredSum());
 	T beta_old = beta;
@@ -38,7 +39,7 @@ int minres(const Matrix<N,N,T> &A, const Matrix<N,1,T> &b, Matrix<N,1,T> &x0, T
 	x = x0;
 	w_old = w;
 
-	while(i < iter_max)
+	while(i < iter_max && i < iter_cap)
 	{
 		if((norm_rMR / norm_r0) <= tolerance) break;
 
@@ -84,5 +85,90 @@ int minres(const Matrix<N,N,T> &A, const Matrix<N,1,T> &b, Matrix<N,1,T> &x0, T
 		++i;
 	}
 
-	return i + 1;
+	return i;
+}
+
+/*!
+@brief  Preconditioned Minimal Residual method for Ax=b. Runs MINRES on the system preconditioned with the symmetric
+        positive definite Mp of Pc, which keeps the symmetry that unpreconditioned MINRES relies on. The stopping test
+        uses the Mp^-1 norm of the residual, relative to the initial one.
+@tparam iter_max    Maximum number of iterations
+@tparam Pc  Preconditioner, see precond.hpp
+@param  A   NxN matrix of coefficients of the system
+@param  b   Nx1 vector of constants of the systems
+@param  x0  Initial values for algorithm iterations
+@param  tolerance   Maximum desirable error to stop iterations
+@param  F   Preconditioner factorization of A, computed by Pc::factor
+@param  x   Nx1 vector for resulting values.
+@param  iter_cap    Runtime limit of the iterations, below iter_max when a rough solution is enough
+@return Number of iterations performed by the algorithm
+*/
+template<int iter_max, typename Pc, int N, typename T = float>
+int pminres(const Matrix<N,N,T> &A, const Matrix<N,1,T> &b, Matrix<N,1,T> &x0, T tolerance, const typename Pc::Factor &F, Matrix<N,1,T> &x, int iter_cap = iter_max)
+{
+	Matrix<N,1,T> v_old(T(0), false), w(T(0), false), w_old(T(0), false), z, z_hat, Az;
+	Matrix<N,1,T> v = b - A*x0;
+
+	Pc::apply(F, v, z);
+
+	T gamma = sqrt(v.dot(z));
+	T gamma_old = 1;
+	T norm_r0 = gamma;
+	T eta = gamma;
+	T c_old = 1;
+	T s_old = 0;
+	T c = 1;
+	T s = 0;
+	int i = 0;
+
+	x = x0;
+
+	while(i < iter_max && i < iter_cap)
+	{
+		if(!(fabs(eta) > tolerance * norm_r0)) break;
+
+		// Preconditioned Lanczos
+
+		z /= gamma;
+		Az = A * z;
+
+		T delta = z.dot(Az);
+		Matrix<N,1,T> v_hat = Az - v * (delta / gamma) - v_old * (gamma / gamma_old);
+
+		Pc::apply(F, v_hat, z_hat);
+
+		T gamma_new = sqrt(v_hat.dot(z_hat));
+
+		// QR Factorization
+
+		T a0 = c * delta - c_old * s * gamma;
+		T a1 = sqrt(a0*a0 + gamma_new*gamma_new);
+		T a2 = s * delta + c_old * c * gamma;
+		T a3 = s_old * gamma;
+
+		// Givens rotation
+
+		c_old = c;
+		s_old = s;
+		c = a0 / a1;
+		s = gamma_new / a1;
+
+		// Update
+
+		Matrix<N,1,T> w_new = (z - w_old * a3 - w * a2) / a1;
+		x += w_new * (c * eta);
+		eta *= -s;
+
+		w_old = w;
+		w = w_new;
+		v_old = v;
+		v = v_hat;
+		z = z_hat;
+		gamma_old = gamma;
+		gamma = gamma_new;
+
+		++i;
+	}
+
+	return i;
 }
@@ -0,0 +1,298 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "mapped_file.hpp"
+#include "mpc_constraints.hpp"
+
+/*!
+@file   model_file.hpp
+@brief  Binary model files for the runtime-dimensioned engine of dyn_mpc.hpp. A file holds the same arrays as
+        src/autogen/init_dc_motor_2.cpp, so the condensing is done when the model is loaded:
+
+            MpcModelHeader, then float arrays A, B, Q, R, P, umin, umax, xmin, xmax, Nxmin, Nxmax, Lx, Lu
+
+        Arrays are row-major, in host byte order, with the sizes given by N, M and P of the header. The magic and the
+        version reject files of another layout or byte order. Files are memory-mapped read-only, the arrays are read
+        in place and never copied.
+*/
+
+//! Layout version of the model files written by this header
+#define MPC_MODEL_VERSION 1
+
+// Largest problem a model file may describe. The engine sizes the condensed matrices and the Newton systems from the
+// header, so files beyond these limits are rejected before anything is allocated
+
+//! Optimization values, M*L
+#ifndef MPC_MODEL_MAX_VALUES
+#define MPC_MODEL_MAX_VALUES 1024
+#endif
+
+//! Rows of the constraints vector, V
+#ifndef MPC_MODEL_MAX_ROWS
+#define MPC_MODEL_MAX_ROWS 16384
+#endif
+
+//! Bytes of the model and of one controller, see mpcModelFootprint
+#ifndef MPC_MODEL_MAX_BYTES
+#define MPC_MODEL_MAX_BYTES (std::uint64_t(256) << 20)
+#endif
+
+/*! Outcome of opening a model file */
+enum MpcModelStatus
+{
+	MODEL_OK,           /*!< Model mapped and validated */
+	MODEL_OPEN_FAILED,  /*!< File missing, unreadable or not mappable */
+	MODEL_BAD_MAGIC,    /*!< Not a model file */
+	MODEL_BAD_VERSION,  /*!< Other layout version, or other byte order */
+	MODEL_BAD_SIZE      /*!< Sizes of the header inconsistent with the file length, the scalar type or each other, or
+	                         beyond MPC_MODEL_MAX_VALUES, MPC_MODEL_MAX_ROWS or MPC_MODEL_MAX_BYTES */
+};
+
+/*! Header of a model file */
+struct MpcModelHeader
+{
+	char magic[4];              //!< "MPCM"
+	std::uint32_t version;      //!< MPC_MODEL_VERSION
+	std::uint32_t header_bytes; //!< sizeof(MpcModelHeader), offset of the first array
+	std::uint32_t scalar_bytes; //!< Size of every array element, sizeof(float)
+	std::int32_t N;             //!< Number of states
+	std::int32_t M;             //!< Number of inputs
+	std::int32_t P;             //!< Number of outputs, used by reference tracking
+	std::int32_t L;             //!< Prediction horizon
+	std::int32_t constraints;   //!< MpcConstraints of the problem
+	std::uint32_t payload_bytes;    //!< Bytes of the arrays after the header
+	char name[32];              //!< Name of the system, nul-terminated
+};
+
+/*!
+@brief  Non-owning view of the plant, weights, bounds and reference gains of a model of runtime size. Every pointer
+        refers to a row-major array, sized as in MpcPlant and MpcModel.
+*/
+struct MpcModelView
+{
+	int N;
+	int M;
+	int P;
+	int L;
+	MpcConstraints constraints;
+	const char *name;
+
+	const float *A;
+	const float *B;
+	const float *Q;
+	const float *R;
+	const float *Pw;    //!< Final state weight, P of MpcPlant
+	const float *umin;
+	const float *umax;
+	const float *xmin;
+	const float *xmax;
+	const float *Nxmin;
+	const float *Nxmax;
+	const float *Lx;
+	const float *Lu;
+
+	//! Length of the constraints vector
+	int V() const { return mpcConstraintRows(constraints, N, M, L); }
+};
+
+/*!
+@brief  Number of floats after the header of a model file of the given sizes
+*/
+inline std::size_t mpcModelPayload(int N, int M, int P)
+{
+	return std::size_t(3*N*N + N*M + M*M + 2*M + 4*N + N*P + M*P);
+}
+
+/*!
+@brief  Bytes the runtime-dimensioned engine allocates for a model and one controller of it, without the cache line
+        padding of every array: the condensed matrices and the Newton system, which dominate, plus every vector.
+        Computed in 64 bits from sizes already checked positive, so it cannot overflow for any header within 4096.
+@param  V   Length of the constraints vector
+*/
+inline std::uint64_t mpcModelFootprint(int N, int M, int P, int L, int V)
+{
+	const std::uint64_t n = std::uint64_t(M) * std::uint64_t(L);
+	const std::uint64_t nl = std::uint64_t(N) * std::uint64_t(L);
+	const std::uint64_t v = std::uint64_t(V);
+
+	// DynMpcModel: AL, Acal, Hcal, h_base, Mx and the vectors. Controller: Ak, its factor and the vectors
+
+	const std::uint64_t model = std::uint64_t(N)*N + nl*N + n*n + n*N + v*n + v + 2*M + 4*N + std::uint64_t(N)*P + M*P;
+	const std::uint64_t controller = 2*n*n + 8*n + 11*v + 2*N + M + P + nl;
+
+	return (model + controller) * sizeof(float);
+}
+
+/*!
+@brief  Writes a model file
+@param  path    Destination
+@param  model   Arrays to store
+@return false if the file could not be written
+*/
+inline bool writeMpcModelFile(const char *path, const MpcModelView &model)
+{
+	MpcModelHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, "MPCM", 4);
+	header.version = MPC_MODEL_VERSION;
+	header.header_bytes = sizeof(MpcModelHeader);
+	header.scalar_bytes = sizeof(float);
+	header.N = model.N;
+	header.M = model.M;
+	header.P = model.P;
+	header.L = model.L;
+	header.constraints = model.constraints;
+	header.payload_bytes = std::uint32_t(mpcModelPayload(model.N, model.M, model.P) * sizeof(float));
+	std::strncpy(header.name, model.name ? model.name : "", sizeof(header.name) - 1);
+
+	const int N = model.N, M = model.M, P = model.P;
+	const struct { const float *data; int size; } arrays[] =
+	{
+		{model.A, N*N}, {model.B, N*M}, {model.Q, N*N}, {model.R, M*M}, {model.Pw, N*N},
+		{model.umin, M}, {model.umax, M}, {model.xmin, N}, {model.xmax, N}, {model.Nxmin, N}, {model.Nxmax, N},
+		{model.Lx, N*P}, {model.Lu, M*P}
+	};
+
+	std::FILE *file = std::fopen(path, "wb");
+
+	if(!file)
+	{
+		return false;
+	}
+
+	bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+
+	for(const auto &a : arrays)
+	{
+		ok = ok && std::fwrite(a.data, sizeof(float), a.size, file) == std::size_t(a.size);
+	}
+
+	return std::fclose(file) == 0 && ok;
+}
+
+/*!
+@brief  Read-only memory mapping of a model file. The view points into the mapping, so it is valid as long as the
+        MpcModelFile lives. Any number of files can be open at once, one per hosted model.
+*/
+class MpcModelFile
+{
+public:
+	MpcModelFile() : m_status(MODEL_OPEN_FAILED), m_view()
+	{ }
+
+	//! Maps path, check status() for the outcome
+	explicit MpcModelFile(const char *path) : MpcModelFile()
+	{
+		open(path);
+	}
+
+	/*!
+	@brief  Maps and validates a model file, unmapping the previous one
+	@return MODEL_OK, or the reason the file was rejected
+	*/
+	MpcModelStatus open(const char *path)
+	{
+		close();
+
+		if(!m_file.open(path) || m_file.size() < sizeof(MpcModelHeader))
+		{
+			m_file.close();
+			return m_status = MODEL_OPEN_FAILED;
+		}
+
+		MpcModelStatus status = validate();
+
+		if(status != MODEL_OK)
+		{
+			close();
+		}
+
+		return m_status = status;
+	}
+
+	//! Unmaps the file
+	void close()
+	{
+		m_file.close();
+		m_status = MODEL_OPEN_FAILED;
+		m_view = MpcModelView();
+	}
+
+	MpcModelStatus status() const { return m_status; }
+
+	//! Arrays of the model, only valid with MODEL_OK
+	const MpcModelView &view() const { return m_view; }
+
+	const MpcModelHeader &header() const { return *static_cast<const MpcModelHeader*>(m_file.data()); }
+
+private:
+	MpcModelStatus validate()
+	{
+		const MpcModelHeader &h = header();
+
+		if(std::memcmp(h.magic, "MPCM", 4) != 0)
+		{
+			return MODEL_BAD_MAGIC;
+		}
+
+		if(h.version != MPC_MODEL_VERSION)
+		{
+			return MODEL_BAD_VERSION;
+		}
+
+		const int constraints = h.constraints;
+		const bool sizes = h.header_bytes == sizeof(MpcModelHeader) && h.scalar_bytes == sizeof(float)
+			&& h.N > 0 && h.M > 0 && h.P > 0 && h.L > 0 && constraints > 0 && constraints <= CONSTRAINT_ALL
+			&& h.N <= 4096 && h.M <= 4096 && h.P <= 4096 && h.L <= 4096
+			&& h.payload_bytes == mpcModelPayload(h.N, h.M, h.P) * sizeof(float)
+			&& m_file.size() >= std::size_t(h.header_bytes) + h.payload_bytes
+			&& std::memchr(h.name, 0, sizeof(h.name)) != nullptr;
+
+		if(!sizes)
+		{
+			return MODEL_BAD_SIZE;
+		}
+
+		// The sizes are within 4096, so the products below fit in an int
+
+		const int V = mpcConstraintRows(MpcConstraints(constraints), h.N, h.M, h.L);
+
+		if(h.M * h.L > MPC_MODEL_MAX_VALUES || V > MPC_MODEL_MAX_ROWS
+			|| mpcModelFootprint(h.N, h.M, h.P, h.L, V) > MPC_MODEL_MAX_BYTES)
+		{
+			return MODEL_BAD_SIZE;
+		}
+
+		const int N = h.N, M = h.M, P = h.P;
+		const float *p = reinterpret_cast<const float*>(static_cast<const char*>(m_file.data()) + h.header_bytes);
+
+		m_view.N = N;
+		m_view.M = M;
+		m_view.P = P;
+		m_view.L = h.L;
+		m_view.constraints = MpcConstraints(constraints);
+		m_view.name = h.name;
+		m_view.A = p;       p += N*N;
+		m_view.B = p;       p += N*M;
+		m_view.Q = p;       p += N*N;
+		m_view.R = p;       p += M*M;
+		m_view.Pw = p;      p += N*N;
+		m_view.umin = p;    p += M;
+		m_view.umax = p;    p += M;
+		m_view.xmin = p;    p += N;
+		m_view.xmax = p;    p += N;
+		m_view.Nxmin = p;   p += N;
+		m_view.Nxmax = p;   p += N;
+		m_view.Lx = p;      p += N*P;
+		m_view.Lu = p;
+
+		return MODEL_OK;
+	}
+
+	MappedFile m_file;
+	MpcModelStatus m_status;
+	MpcModelView m_view;
+};
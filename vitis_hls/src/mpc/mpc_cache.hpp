@@ -0,0 +1,210 @@
+#pragma once
+
+#include <cmath>
+
+#include "Matrix.hpp"
+#include "explicit_mpc.hpp"
+
+/*!
+@file   mpc_cache.hpp
+*/
+
+/*!
+@brief  Lipschitz constant of the explicit control law in the infinity norm, |u(x) - u(x')| <= Lip*|x - x'|.
+        The law is continuous and piecewise affine, so the largest gain over the regions bounds it globally.
+@return Lipschitz constant, 0 if the table is empty
+*/
+template<int R, int N, int M, int V, typename T>
+double explicitLipschitz(const ExplicitTable<R,N,M,V,T> &table)
+{
+	double lip = 0;
+
+	for(int r = 0; r < table.size; ++r)
+	{
+		for(int i = 0; i < M; ++i)
+		{
+			double row = 0;
+
+			for(int j = 0; j < N; ++j)
+			{
+				row += std::fabs(double(table.region[r].K(i,j)));
+			}
+
+			lip = row > lip ? row : lip;
+		}
+	}
+
+	return lip;
+}
+
+/*!
+@brief  Bounded LRU cache of MPC solutions keyed by the quantised state. The quantisation step is the error bound
+        divided by the Lipschitz constant of the control law, so two states in the same cell are closer than the step
+        and their optimal inputs differ by less than the bound, on top of the solver tolerance at the stored state.
+        A hit also requires the same reference y_ref. Entries are looked up with a linear scan, so the capacity is
+        meant to be small.
+@tparam C   Capacity, number of entries
+@tparam N   Number of states
+@tparam M   Number of inputs
+@tparam P   Number of outputs
+@tparam T   Data type
+*/
+template<int C, int N, int M, int P, typename T = float>
+class MpcCache
+{
+public:
+	/*!
+	@param  step    Quantisation step of the states. Zero or negative disables the cache
+	*/
+	explicit MpcCache(double step = 0) : m_step(step), m_clock(0), m_hits(0), m_misses(0)
+	{
+		for(int c = 0; c < C; ++c)
+		{
+			m_entry[c].used = 0;
+		}
+	}
+
+	/*!
+	@brief  Looks up the input stored for the cell of x
+	@param  x       State
+	@param  y_ref   Reference, must match the stored one exactly
+	@param  u       Stored input, written on a hit
+	@return true on a hit
+	*/
+	bool lookup(const Matrix<N,1,T> &x, const Matrix<P,1,T> &y_ref, Matrix<M,1,T> &u)
+	{
+		long key[N];
+
+		if(m_step <= 0 || !quantise(x, key))
+		{
+			m_misses++;
+			return false;
+		}
+
+		for(int c = 0; c < C; ++c)
+		{
+			if(m_entry[c].used != 0 && matches(m_entry[c], key, y_ref))
+			{
+				m_entry[c].used = ++m_clock;
+				u = m_entry[c].u;
+				m_hits++;
+				return true;
+			}
+		}
+
+		m_misses++;
+		return false;
+	}
+
+	/*!
+	@brief  Stores the input solved for x, evicting the least recently used entry if the cache is full
+	*/
+	void insert(const Matrix<N,1,T> &x, const Matrix<P,1,T> &y_ref, const Matrix<M,1,T> &u)
+	{
+		long key[N];
+
+		if(m_step <= 0 || !quantise(x, key))
+		{
+			return;
+		}
+
+		int victim = 0;
+
+		for(int c = 1; c < C; ++c)
+		{
+			victim = m_entry[c].used < m_entry[victim].used ? c : victim;
+		}
+
+		Entry &e = m_entry[victim];
+
+		for(int i = 0; i < N; ++i)
+		{
+			e.key[i] = key[i];
+		}
+
+		e.y_ref = y_ref;
+		e.u = u;
+		e.used = ++m_clock;
+	}
+
+	//! Drops every entry, counters are kept
+	void clear()
+	{
+		for(int c = 0; c < C; ++c)
+		{
+			m_entry[c].used = 0;
+		}
+	}
+
+	long hits() const { return m_hits; }
+	long misses() const { return m_misses; }
+	double step() const { return m_step; }
+
+private:
+	struct Entry
+	{
+		long key[N];
+		Matrix<P,1,T> y_ref;
+		Matrix<M,1,T> u;
+		unsigned long used;     //!< Time of the last access, 0 if empty
+	};
+
+	//! Cell of x. false if x is too far from the origin to be quantised
+	bool quantise(const Matrix<N,1,T> &x, long key[N]) const
+	{
+		for(int i = 0; i < N; ++i)
+		{
+			double cell = std::floor(double(x(i,0)) / m_step);
+
+			if(!(std::fabs(cell) < 1e9))
+			{
+				return false;
+			}
+
+			key[i] = long(cell);
+		}
+
+		return true;
+	}
+
+	bool matches(const Entry &e, const long key[N], const Matrix<P,1,T> &y_ref) const
+	{
+		bool res = true;
+
+		for(int i = 0; i < N; ++i)
+		{
+			res = res && e.key[i] == key[i];
+		}
+
+		for(int i = 0; i < P; ++i)
+		{
+			res = res && e.y_ref(i,0) == y_ref(i,0);
+		}
+
+		return res;
+	}
+
+	double m_step;
+	unsigned long m_clock;
+	long m_hits;
+	long m_misses;
+	Entry m_entry[C];
+};
+
+/*!
+@brief  Disabled cache, every lookup misses without being counted
+*/
+template<int N, int M, int P, typename T>
+class MpcCache<0, N, M, P, T>
+{
+public:
+	explicit MpcCache(double = 0) { }
+
+	bool lookup(const Matrix<N,1,T>&, const Matrix<P,1,T>&, Matrix<M,1,T>&) { return false; }
+	void insert(const Matrix<N,1,T>&, const Matrix<P,1,T>&, const Matrix<M,1,T>&) { }
+	void clear() { }
+
+	long hits() const { return 0; }
+	long misses() const { return 0; }
+	double step() const { return 0; }
+};
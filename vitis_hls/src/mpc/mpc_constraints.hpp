@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Matrix.hpp"
+#include "mx_ops.hpp"
 
 /*!
 	@file mpc_constraints.hpp
@@ -24,6 +25,31 @@ enum MpcConstraints
 	CONSTRAINT_ALL   = FINALSTATE | STATE | INPUT /*!< Final state, state and input constraints */
 };
 
+/*!
+	@brief Structure of the constraints matrix Mx implied by the constraints combination. With input constraints only,
+	Mx = [I; -I] and pdip can use the box specialisation.
+
+	@tparam constraints Values to constraint
+*/
+template<MpcConstraints constraints>
+struct MpcConstraintsStructure
+{
+	static constexpr MxStructure value = constraints == INPUT ? MX_BOX : MX_DENSE;
+};
+
+/*!
+	@brief Length of the constraints vector, V, of a constraints combination
+
+	@param  constraints Values to constraint
+	@param  N           Size of the state vector, x
+	@param  M           Size of the input vector, u
+	@param  L           Prediction horizon
+*/
+constexpr int mpcConstraintRows(MpcConstraints constraints, int N, int M, int L)
+{
+	return ((constraints & FINALSTATE) ? 2*N : 0) + ((constraints & STATE) ? 2*N*L : 0) + ((constraints & INPUT) ? 2*M*L : 0);
+}
+
 template<bool enable, bool track_ref, int N, int M, int L, int V, typename T = float>
 struct MpcConstraintsImpl
 { };
@@ -83,6 +109,36 @@ void updateConstraintsVector
 	InputImpl::template constraintInput<InputOffset>(umin, umax, uinfy, cx);
 }
 
+/*!
+	@brief Shifts a vector laid out as the constraints vector, such as the multipliers or slacks of the QP, one stage
+	along the prediction horizon. Final state elements are kept unchanged.
+
+	@tparam constraints Values to constraint
+	@tparam N           Size of the state vector, x
+	@tparam M           Size of the input vector, u
+	@tparam L           Prediction horizon
+	@tparam V           Length of the constraints vector
+	@tparam T           Matrix elements type
+
+	@param  v           Vector to be shifted
+*/
+template<MpcConstraints constraints = INPUT, int N, int M, int L, int V, typename T = float>
+void shiftConstraintsVector(Matrix<V,1,T> &v)
+{
+	#pragma HLS INLINE
+
+	using InputImpl = MpcConstraintsImpl<!!(constraints & INPUT), false, N, M, L, V, T>;
+	using StateImpl = MpcConstraintsImpl<!!(constraints & STATE), false, N, M, L, V, T>;
+	using FinalStateImpl = MpcConstraintsImpl<!!(constraints & FINALSTATE), false, N, M, L, V, T>;
+
+	constexpr int StateOffset = FinalStateImpl::FINALSTATE_SIZE;
+	constexpr int InputOffset = StateOffset + StateImpl::STATE_SIZE;
+	static_assert(InputOffset + InputImpl::INPUT_SIZE == V, "Constraints vector length mismatch");
+
+	StateImpl::template shiftState<StateOffset>(v);
+	InputImpl::template shiftInput<InputOffset>(v);
+}
+
 template<bool track_ref, int N, int M, int L, int V, typename T>
 struct MpcConstraintsImpl<false, track_ref, N, M, L, V, T>
 {
@@ -121,6 +177,18 @@ struct MpcConstraintsImpl<false, track_ref, N, M, L, V, T>
 	{
 		// No-op, constraint disabled
 	}
+
+	template<int begin>
+	static void shiftInput(Matrix<V,1,T>&)
+	{
+		// No-op, constraint disabled
+	}
+
+	template<int begin>
+	static void shiftState(Matrix<V,1,T>&)
+	{
+		// No-op, constraint disabled
+	}
 };
 
 template<int N, int M, int L, int V, typename T>
@@ -148,7 +216,7 @@ struct MpcConstraintsImpl<true, false, N, M, L, V, T>
 		Matrix<V,1,T> &cx
 	)
 	{
-		auto Acal_mul = Acal * x0nau;
+		Matrix<N*L,1,T> Acal_mul = Acal * x0nau;
 
 		for(int i = begin, j = 0, k = 0; i < begin+N*L; ++i, ++j, ++k)
 		{
@@ -179,7 +247,7 @@ struct MpcConstraintsImpl<true, false, N, M, L, V, T>
 		Matrix<V,1,T> &cx
 	)
 	{
-		auto AL_mul = AL * x0nau;
+		Matrix<N,1,T> AL_mul = AL * x0nau;
 
 		for(int i = begin, j = 0; i < begin+N; ++i, ++j)
 		{
@@ -191,6 +259,20 @@ struct MpcConstraintsImpl<true, false, N, M, L, V, T>
 			cx(i,0) = AL_mul(j,0) - Nxmin(j,0);
 		}
 	}
+
+	template<int begin>
+	static void shiftInput(Matrix<V,1,T> &v)
+	{
+		v.template shift<begin, M, L>();
+		v.template shift<begin + L*M, M, L>();
+	}
+
+	template<int begin>
+	static void shiftState(Matrix<V,1,T> &v)
+	{
+		v.template shift<begin, N, L>();
+		v.template shift<begin + N*L, N, L>();
+	}
 };
 
 template<int N, int M, int L, int V, typename T>
@@ -229,7 +311,7 @@ struct MpcConstraintsImpl<true, true, N, M, L, V, T>
 		Matrix<V,1,T> &cx
 	)
 	{
-		auto Acal_mul = Acal * x0nau;
+		Matrix<N*L,1,T> Acal_mul = Acal * x0nau;
 
 		for(int i = begin, j = 0, k = 0; i < begin+N*L; ++i, ++j, ++k)
 		{
@@ -260,7 +342,7 @@ struct MpcConstraintsImpl<true, true, N, M, L, V, T>
 		Matrix<V,1,T> &cx
 	)
 	{
-		auto AL_mul = AL * x0nau;
+		Matrix<N,1,T> AL_mul = AL * x0nau;
 
 		for(int i = begin, j = 0; i < begin+N; ++i, ++j)
 		{
@@ -272,4 +354,18 @@ struct MpcConstraintsImpl<true, true, N, M, L, V, T>
 			cx(i,0) = xinfy(j,0) - Nxmin(j,0) + AL_mul(j,0);
 		}
 	}
+
+	template<int begin>
+	static void shiftInput(Matrix<V,1,T> &v)
+	{
+		v.template shift<begin, M, L>();
+		v.template shift<begin + L*M, M, L>();
+	}
+
+	template<int begin>
+	static void shiftState(Matrix<V,1,T> &v)
+	{
+		v.template shift<begin, N, L>();
+		v.template shift<begin + N*L, N, L>();
+	}
 };
@@ -0,0 +1,235 @@
+#pragma once
+
+#include "Matrix.hpp"
+#include "pdip.hpp"
+#include "mpc_constraints.hpp"
+#include "mpc_dense.hpp"
+#include "explicit_mpc.hpp"
+#include "mpc_cache.hpp"
+
+#include <type_traits>
+
+/*!
+@file   mpc_controller.hpp
+*/
+
+/*!
+@brief  Matrices of a condensed MPC problem. Immutable once built, so one model can be shared by any number of
+        controllers, including controllers running on different threads.
+@tparam N   Number of states
+@tparam M   Number of inputs
+@tparam P   Number of outputs, used by reference tracking
+@tparam L   Prediction horizon
+@tparam V   Length of the constraints vector
+@tparam T   Data type
+@tparam R   Capacity of the explicit MPC region table
+*/
+template<int N, int M, int P, int L, int V, typename T = float, int R = 1>
+struct MpcModel
+{
+	static constexpr int STATES = N;
+	static constexpr int INPUTS = M;
+	static constexpr int OUTPUTS = P;
+	static constexpr int HORIZON = L;
+	static constexpr int CONSTRAINT_ROWS = V;
+	static constexpr int REGIONS = R;
+
+	typedef T value_type;
+
+	Matrix<N,N,T> AL;           //!< A^L
+	Matrix<N*L,N,T> Acal;       //!< Stacked powers of A
+	Matrix<M*L,M*L,T> Hcal;     //!< Cost matrix of the QP
+	Matrix<M*L,N,T> h_base;     //!< Cost vector of the QP is h_base * x
+	Matrix<V,M*L,T> Mx;         //!< Constraints matrix of the QP
+	Matrix<M,1,T> umin;
+	Matrix<M,1,T> umax;
+	Matrix<N,1,T> xmin;
+	Matrix<N,1,T> xmax;
+	Matrix<N,1,T> Nxmin;
+	Matrix<N,1,T> Nxmax;
+	Matrix<V,1,T> cx;           //!< Initial constraints vector
+	Matrix<N,P,T> Lx;           //!< Stationary state for a reference, xinfy = Lx * y_ref
+	Matrix<M,P,T> Lu;           //!< Stationary input for a reference, uinfy = Lu * y_ref
+	ExplicitTable<R,N,M,V,T> table; //!< Critical regions, used by the EXPLICIT solver
+
+	/*!
+	@brief  Converts every matrix of the model to another data type
+	*/
+	template<typename U>
+	MpcModel<N,M,P,L,V,U,R> cast() const
+	{
+		MpcModel<N,M,P,L,V,U,R> res;
+
+		res.AL = AL.template cast<U>();
+		res.Acal = Acal.template cast<U>();
+		res.Hcal = Hcal.template cast<U>();
+		res.h_base = h_base.template cast<U>();
+		res.Mx = Mx.template cast<U>();
+		res.umin = umin.template cast<U>();
+		res.umax = umax.template cast<U>();
+		res.xmin = xmin.template cast<U>();
+		res.xmax = xmax.template cast<U>();
+		res.Nxmin = Nxmin.template cast<U>();
+		res.Nxmax = Nxmax.template cast<U>();
+		res.cx = cx.template cast<U>();
+		res.Lx = Lx.template cast<U>();
+		res.Lu = Lu.template cast<U>();
+		res.table = table.template cast<U>();
+
+		return res;
+	}
+};
+
+/*!
+@brief  MPC dense controller for one plant. Reads the shared model and owns every value that changes between control
+        cycles: constraints vector, stationary targets, warm start iterates and solver statistics. Distinct instances
+        share no mutable state, so they can be stepped concurrently without locks. See mpc_dense for the parameters.
+@tparam Model   MpcModel of the plant
+@tparam solver  Inner solver of the QP, or EXPLICIT to use the region table of the model
+@tparam cache_size  Entries of the solution cache in front of the solver, 0 disables it. See MpcCache
+@tparam cache_tol   Magnitude order of the bound on the error of a cached input. The bound relies on the region table
+                    of the model, the cache stays disabled if the table is empty
+*/
+template<
+	typename Model,
+	Solvers solver,
+	MpcConstraints constraints,
+	bool track_ref = false,
+	int qpiter = 20,
+	int tol = -9,
+	bool early_exit = false,
+	int exit_tol = -4,
+	PdipAlgorithm algorithm = PDIP_FIXED_CENTERING,
+	bool inexact = false,
+	int cache_size = 0,
+	int cache_tol = -3
+>
+class MpcController
+{
+	static constexpr int N = Model::STATES;
+	static constexpr int M = Model::INPUTS;
+	static constexpr int P = Model::OUTPUTS;
+	static constexpr int L = Model::HORIZON;
+	static constexpr int V = Model::CONSTRAINT_ROWS;
+
+	typedef typename Model::value_type T;
+
+public:
+	/*!
+	@brief  Creates a controller for a model, which must outlive it
+	@param  model       Model of the plant
+	@param  warm_start  Warm start the QP solver from the previous control cycle
+	*/
+	explicit MpcController(const Model &model, bool warm_start = true) :
+		m_model(model), m_cx(model.cx), m_xinfy(T(0)), m_uinfy(T(0)), m_yref(T(0)), m_warm(warm_start), m_result(),
+		m_cache(cacheStep(model))
+	{ }
+
+	/*!
+	@brief  Sets the output reference to track, only used if track_ref
+	*/
+	void setReference(const Matrix<P,1,T> &y_ref)
+	{
+		m_yref = y_ref;
+		m_xinfy = m_model.Lx * y_ref;
+		m_uinfy = m_model.Lu * y_ref;
+	}
+
+	/*!
+	@brief  Runs one control cycle
+	@param  x   Current state of the plant
+	@return Input to apply to the plant
+	*/
+	Matrix<M,1,T> step(const Matrix<N,1,T> &x)
+	{
+		Matrix<N,1,T> x0(x);
+		Matrix<M,1,T> u;
+
+		MPC_PROFILE_BEGIN();
+
+		if(m_cache.lookup(x0, m_yref, u))
+		{
+			MPC_PROFILE_END();
+			return u;
+		}
+
+		solve(x0, u, std::integral_constant<bool, solver == EXPLICIT>());
+		m_cache.insert(x0, m_yref, u);
+
+		MPC_PROFILE_END();
+		return u;
+	}
+
+	/*!
+	@brief  Overloaded function provided by convenience. Updates the reference, then runs one control cycle
+	*/
+	Matrix<M,1,T> step(const Matrix<N,1,T> &x, const Matrix<P,1,T> &y_ref)
+	{
+		setReference(y_ref);
+		return step(x);
+	}
+
+	/*!
+	@brief  Drops the state carried between control cycles. The next step is cold started
+	*/
+	void reset()
+	{
+		m_cx = m_model.cx;
+		m_warm.valid = false;
+		m_cache.clear();
+	}
+
+	//! Statistics and exit status of the last QP solve. Not updated by cache hits
+	const PdipResult<T> &result() const { return m_result; }
+
+	//! Solution cache, with its hit and miss counters
+	const MpcCache<cache_size,N,M,P,T> &cache() const { return m_cache; }
+
+	const Model &model() const { return m_model; }
+
+private:
+	static double cacheStep(const Model &model)
+	{
+		double lip = explicitLipschitz(model.table);
+		return lip > 0 ? std::pow(10.0, cache_tol) / lip : 0;
+	}
+
+	void solve(Matrix<N,1,T> &x0, Matrix<M,1,T> &u, std::false_type)
+	{
+		mpc_dense<solver, constraints, L, track_ref, qpiter, tol, early_exit, exit_tol, algorithm, inexact>(
+			m_model.AL,
+			m_model.Acal, m_model.Hcal, m_model.Mx,
+			m_model.umin, m_model.umax, m_uinfy,
+			m_model.xmin, m_model.xmax, m_xinfy,
+			m_model.Nxmin, m_model.Nxmax,
+			m_model.h_base,
+			m_cx, x0, u,
+			m_result, m_warm
+		);
+	}
+
+	void solve(Matrix<N,1,T> &x0, Matrix<M,1,T> &u, std::true_type)
+	{
+		mpc_explicit<constraints, L, track_ref, qpiter, tol, early_exit, exit_tol, algorithm>(
+			m_model.AL,
+			m_model.Acal, m_model.Hcal, m_model.Mx,
+			m_model.umin, m_model.umax, m_uinfy,
+			m_model.xmin, m_model.xmax, m_xinfy,
+			m_model.Nxmin, m_model.Nxmax,
+			m_model.h_base,
+			m_model.table,
+			m_cx, x0, u,
+			m_result, m_warm
+		);
+	}
+
+	const Model &m_model;
+
+	Matrix<V,1,T> m_cx;
+	Matrix<N,1,T> m_xinfy;
+	Matrix<M,1,T> m_uinfy;
+	Matrix<P,1,T> m_yref;
+	MpcWarmStart<M*L,V,T> m_warm;
+	PdipResult<T> m_result;
+	MpcCache<cache_size,N,M,P,T> m_cache;
+};
@@ -8,6 +8,29 @@
 @file   mpc_dense.hpp
 */
 
+/*!
+@brief  Primal-dual iterates kept between consecutive mpc_dense calls to warm start the QP solver
+@tparam N   Number of optimization values, M*L
+@tparam V   Length of the constraints vector
+@tparam T   Data type
+*/
+template<int N, int V, typename T = float>
+struct MpcWarmStart
+{
+	/*!
+	@brief  Creates an empty warm start, the first solve is always cold started
+	@param  enabled If false, every solve is cold started
+	@param  floor   Minimum value for the shifted multipliers and slacks
+	*/
+	MpcWarmStart(bool enabled = true, T floor = 1e-3) : tk(1.0), lk(0.5), valid(false), enabled(enabled), floor(floor) { }
+
+	Matrix<N,1,T> tk;   //!< Optimization values of the last solve
+	Matrix<V,1,T> lk;   //!< Multipliers of the last solve
+	bool valid;         //!< True while the stored iterates solved their QP. Slacks are recomputed from the new constraints
+	bool enabled;       //!< Toggle warm starting
+	T floor;            //!< Minimum value for the shifted multipliers and slacks
+};
+
 /*!
 @brief  MPC dense implementation. Written considering a future HLS implementation
 @tparam solver  Solve method to use for quadratic problem
@@ -16,6 +39,11 @@
 @tparam use_yref    true if yref wil be used. false as default
 @tparam qpiter  Number of iterations for QP algorithm. By default, is 20
 @tparam tol     Tolerance magnitude order. 1e-9 is used by default
+@tparam early_exit  Stop the QP iterations once the exit criteria are met. false as default
+@tparam exit_tol    Magnitude order of the residual and duality gap tolerances used for early exit. 1e-4 by default
+@tparam algorithm   Search direction strategy of the QP solver
+@tparam inexact     Inexact Newton steps in the QP solver, the iterative inner solvers stop early while the duality gap
+                    is large. false as default
 @tparam N
 @tparam M
 @tparam P
@@ -38,6 +66,8 @@
 @param  yref
 @param  x       States of the system
 @param  u       Input values for system
+@param  result  Statistics and exit status of the QP solver
+@param  warm    Iterates of the previous solve. Shifted one stage along the horizon to start the QP solver, then updated
 */
 template<
 	Solvers solver,
@@ -46,6 +76,10 @@ template<
 	bool track_ref = false,
 	int qpiter = 20,
 	int tol = -9,
+	bool early_exit = false,
+	int exit_tol = -4,
+	PdipAlgorithm algorithm = PDIP_FIXED_CENTERING,
+	bool inexact = false,
 	int N, int M, int V, typename T = float // automatically deduced from input arguments
 >
 void mpc_dense
@@ -56,9 +90,14 @@ void mpc_dense
 	const Matrix<N,1,T> &xmin, const Matrix<N,1,T> &xmax, const Matrix<N,1,T> &xinfy,
 	const Matrix<N,1,T> &Nxmin, const Matrix<N,1,T> &Nxmax,
 	const Matrix<M*L,N,T> &h_base,
-	Matrix<V,1,T> &cx, Matrix<N,1,T> &x, Matrix<M,1,T> &u
+	Matrix<V,1,T> &cx, Matrix<N,1,T> &x, Matrix<M,1,T> &u,
+	PdipResult<T> &result, MpcWarmStart<M*L,V,T> &warm
 )
 {
+	constexpr MxStructure MS = MpcConstraintsStructure<constraints>::value;
+
+	MPC_PROFILE_BEGIN();
+
 	// Read input vector
 
 	Matrix<N,1,T> x0nau(x - xinfy);
@@ -80,7 +119,51 @@ void mpc_dense
 	// Solve QP problem
 
 	static const T tol_f = pow(10.0, tol);
-	Matrix<M*L,1,T> unau = pdip<solver, qpiter, 20>(Hcal, h, Mx, cx, tol_f);
+	static const PdipCriteria<T> criteria = pdipCriteria<T>(early_exit, exit_tol);
+	Matrix<M*L,1,T> unau(1.0);
+	Matrix<V,1,T> lk(0.5);
+	Matrix<V,1,T> sk;
+
+	if(warm.enabled && warm.valid)
+	{
+		// Shift the previous solution one stage and push it back into the interior
+
+		unau = warm.tk;
+		lk = warm.lk;
+		unau.template shift<0, M, L>();
+		shiftConstraintsVector<constraints, N, M, L>(lk);
+
+		sk = pdipStartSlacks<MS>(Mx, cx, unau, warm.floor);
+
+		for(int i = 0; i < V; ++i)
+		{
+			T lk_min = warm.floor / sk(i,0);
+			lk(i,0) = lk(i,0) < lk_min ? lk_min : lk(i,0);
+		}
+	}
+	else
+	{
+		// Cold start, the slacks still come from the constraints, see pdipStartSlacks
+
+		sk = pdipStartSlacks<MS>(Mx, cx, unau, T(0.5));
+	}
+
+	MPC_PROFILE_LAP(MPC_STAGE_CONSTRAINTS);
+	pdip<solver, qpiter, 20, MS, algorithm, inexact>(Hcal, h, Mx, cx, tol_f, criteria, result, unau, lk, sk);
+	MPC_PROFILE_ITERATIONS(result.iterations, result.inner_iterations);
+
+	// Keep the iterates only when they solve the QP, a start from an unconverged or infeasible one is worse than a cold
+	// start. Without early exit pdip reports PDIP_MAX_ITER, so the final gap and residual are checked against exit_tol
+
+	static const T store_tol_f = pow(10.0, exit_tol);
+	warm.valid = warm.enabled && (result.status == PDIP_CONVERGED ||
+		(!early_exit && result.gap <= store_tol_f && result.residual <= store_tol_f));
+
+	if(warm.valid)
+	{
+		warm.tk = unau;
+		warm.lk = lk;
+	}
 
 	// Write output vector
 
@@ -88,4 +171,89 @@ void mpc_dense
 	{
 		u(i,0) = unau(i,0) + uinfy(i,0);
 	}
+
+	MPC_PROFILE_END();
+}
+
+/*!
+@brief  Overloaded function provided by convenience. Cold starts the QP solver.
+*/
+template<
+	Solvers solver,
+	MpcConstraints constraints,
+	int L,
+	bool track_ref = false,
+	int qpiter = 20,
+	int tol = -9,
+	bool early_exit = false,
+	int exit_tol = -4,
+	PdipAlgorithm algorithm = PDIP_FIXED_CENTERING,
+	bool inexact = false,
+	int N, int M, int V, typename T = float
+>
+void mpc_dense
+(
+	const Matrix<N,N,T> &AL,
+	const Matrix<N*L,N,T> &Acal, const Matrix<M*L,M*L,T> &Hcal, const Matrix<V,M*L,T> &Mx,
+	const Matrix<M,1,T> &umin, const Matrix<M,1,T> &umax, const Matrix<M,1,T> &uinfy,
+	const Matrix<N,1,T> &xmin, const Matrix<N,1,T> &xmax, const Matrix<N,1,T> &xinfy,
+	const Matrix<N,1,T> &Nxmin, const Matrix<N,1,T> &Nxmax,
+	const Matrix<M*L,N,T> &h_base,
+	Matrix<V,1,T> &cx, Matrix<N,1,T> &x, Matrix<M,1,T> &u,
+	PdipResult<T> &result
+)
+{
+	MpcWarmStart<M*L,V,T> warm(false);
+
+	mpc_dense<solver, constraints, L, track_ref, qpiter, tol, early_exit, exit_tol, algorithm, inexact>(
+		AL,
+		Acal, Hcal, Mx,
+		umin, umax, uinfy,
+		xmin, xmax, xinfy,
+		Nxmin, Nxmax,
+		h_base,
+		cx, x, u,
+		result, warm
+	);
+}
+
+/*!
+@brief  Overloaded function provided by convenience. Discards the QP solver statistics.
+*/
+template<
+	Solvers solver,
+	MpcConstraints constraints,
+	int L,
+	bool track_ref = false,
+	int qpiter = 20,
+	int tol = -9,
+	bool early_exit = false,
+	int exit_tol = -4,
+	PdipAlgorithm algorithm = PDIP_FIXED_CENTERING,
+	bool inexact = false,
+	int N, int M, int V, typename T = float
+>
+void mpc_dense
+(
+	const Matrix<N,N,T> &AL,
+	const Matrix<N*L,N,T> &Acal, const Matrix<M*L,M*L,T> &Hcal, const Matrix<V,M*L,T> &Mx,
+	const Matrix<M,1,T> &umin, const Matrix<M,1,T> &umax, const Matrix<M,1,T> &uinfy,
+	const Matrix<N,1,T> &xmin, const Matrix<N,1,T> &xmax, const Matrix<N,1,T> &xinfy,
+	const Matrix<N,1,T> &Nxmin, const Matrix<N,1,T> &Nxmax,
+	const Matrix<M*L,N,T> &h_base,
+	Matrix<V,1,T> &cx, Matrix<N,1,T> &x, Matrix<M,1,T> &u
+)
+{
+	PdipResult<T> result;
+
+	mpc_dense<solver, constraints, L, track_ref, qpiter, tol, early_exit, exit_tol, algorithm, inexact>(
+		AL,
+		Acal, Hcal, Mx,
+		umin, umax, uinfy,
+		xmin, xmax, xinfy,
+		Nxmin, Nxmax,
+		h_base,
+		cx, x, u,
+		result
+	);
 }
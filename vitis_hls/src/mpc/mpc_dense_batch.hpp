@@ -0,0 +1,209 @@
+#pragma once
+
+#include "Matrix.hpp"
+#include "lanes.hpp"
+#include "pdip_batch.hpp"
+#include "mpc_constraints.hpp"
+
+/*!
+@file   mpc_dense_batch.hpp
+*/
+
+/*!
+@brief  Primal-dual iterates kept between consecutive mpc_dense_batch calls, one plant per lane. See MpcWarmStart
+@tparam N   Number of optimization values, M*L
+@tparam V   Length of the constraints vector
+@tparam K   Number of plants
+@tparam T   Data type
+*/
+template<int N, int V, int K, typename T = float>
+struct MpcWarmStartBatch
+{
+	/*!
+	@brief  Creates an empty warm start, the first solve of every plant is always cold started
+	@param  enabled If false, every solve is cold started
+	@param  floor   Minimum value for the shifted multipliers and slacks
+	*/
+	MpcWarmStartBatch(bool enabled = true, T floor = 1e-3) : tk(1.0), lk(0.5), valid(), enabled(enabled), floor(floor) { }
+
+	Matrix<N,1,Lanes<K,T>> tk;  //!< Optimization values of the last solve of every plant
+	Matrix<V,1,Lanes<K,T>> lk;  //!< Multipliers of the last solve of every plant
+	LaneMask<K> valid;          //!< Set on the plants whose stored iterates solved their QP
+	bool enabled;               //!< Toggle warm starting
+	T floor;                    //!< Minimum value for the shifted multipliers and slacks
+};
+
+/*!
+@brief  Batched MPC dense implementation for K identical plants with different states. The system matrices are shared,
+        states, targets, constraints vectors and inputs hold one plant per lane, in structure-of-arrays layout.
+        The QPs are solved in lockstep by pdipBatch, with LDL' factorization as linear solver. See mpc_dense.
+@tparam constraints Type of constraints of the system
+@tparam L   Prediction horizon
+@tparam track_ref   true if the stationary targets xinfy and uinfy are used
+@tparam qpiter  Maximum number of iterations of the QP algorithm
+@tparam early_exit  Stop the QP iterations of a lane once its exit criteria are met
+@tparam exit_tol    Magnitude order of the residual and duality gap tolerances used for early exit
+@tparam algorithm   Search direction strategy of the QP solver
+@tparam K       Number of plants
+@param  x       States of every plant
+@param  u       Resulting inputs of every plant
+@param  cx      Constraints vector of every plant, initialized as the one of mpc_dense
+@param  result  Statistics and exit status of the QP solver of every plant
+@param  warm    Iterates of the previous solve of every plant. The lanes holding a solved QP are shifted one stage to
+                start theirs, the others are cold started as in mpc_dense, then every lane that converges is stored
+*/
+template<
+	MpcConstraints constraints,
+	int L,
+	bool track_ref = false,
+	int qpiter = 20,
+	bool early_exit = false,
+	int exit_tol = -4,
+	PdipAlgorithm algorithm = PDIP_FIXED_CENTERING,
+	int N, int M, int V, int K, typename T = float // automatically deduced from input arguments
+>
+void mpc_dense_batch
+(
+	const Matrix<N,N,T> &AL,
+	const Matrix<N*L,N,T> &Acal, const Matrix<M*L,M*L,T> &Hcal, const Matrix<V,M*L,T> &Mx,
+	const Matrix<M,1,T> &umin, const Matrix<M,1,T> &umax, const Matrix<M,1,Lanes<K,T>> &uinfy,
+	const Matrix<N,1,T> &xmin, const Matrix<N,1,T> &xmax, const Matrix<N,1,Lanes<K,T>> &xinfy,
+	const Matrix<N,1,T> &Nxmin, const Matrix<N,1,T> &Nxmax,
+	const Matrix<M*L,N,T> &h_base,
+	Matrix<V,1,Lanes<K,T>> &cx, Matrix<N,1,Lanes<K,T>> &x, Matrix<M,1,Lanes<K,T>> &u,
+	PdipResult<T> (&result)[K], MpcWarmStartBatch<M*L,V,K,T> &warm
+)
+{
+	using LT = Lanes<K,T>;
+	constexpr MxStructure MS = MpcConstraintsStructure<constraints>::value;
+
+	// Read input vectors
+
+	Matrix<N,1,LT> x0nau(x - xinfy);
+
+	// Vectors of cost
+
+	Matrix<M*L,1,LT> h = laneMul(h_base, x0nau);
+
+	// Set up the constraints vectors. The bounds are broadcast to every lane
+
+	updateConstraintsVector<constraints, track_ref, N, M, L>(
+		AL.template cast<LT>(), Acal.template cast<LT>(), x0nau,
+		umin.template cast<LT>(), umax.template cast<LT>(), uinfy,
+		xmin.template cast<LT>(), xmax.template cast<LT>(), xinfy,
+		Nxmin.template cast<LT>(), Nxmax.template cast<LT>(),
+		cx
+	);
+
+	// Solve QP problems
+
+	static const PdipCriteria<T> criteria = pdipCriteria<T>(early_exit, exit_tol);
+	Matrix<M*L,1,LT> unau(1.0);
+	Matrix<V,1,LT> lk(0.5);
+	const LaneMask<K> warm_lanes = warm.valid && LaneMask<K>::all(warm.enabled);
+
+	if(warm_lanes.any())
+	{
+		// Shift the previous solutions one stage, in the lanes that hold one
+
+		Matrix<M*L,1,LT> tk_warm = warm.tk;
+		Matrix<V,1,LT> lk_warm = warm.lk;
+		tk_warm.template shift<0, M, L>();
+		shiftConstraintsVector<constraints, N, M, L>(lk_warm);
+
+		for(int i = 0; i < M*L; ++i)
+		{
+			unau(i,0) = select(warm_lanes, tk_warm(i,0), unau(i,0));
+		}
+
+		for(int i = 0; i < V; ++i)
+		{
+			lk(i,0) = select(warm_lanes, lk_warm(i,0), lk(i,0));
+		}
+	}
+
+	// Slacks from the constraints, at least the warm start floor or 0.5 when cold, see pdipStartSlacks. Warm lanes
+	// push their multipliers back into the interior as mpc_dense does
+
+	const LT floor = select(warm_lanes, LT(warm.floor), LT(0.5));
+	Matrix<V,1,LT> sk = cx - MxLaneOps<MS, V, M*L, K, T>::mul(Mx, unau);
+
+	for(int i = 0; i < V; ++i)
+	{
+		sk(i,0) = select(sk(i,0) < floor, floor, sk(i,0));
+
+		LT lk_min = floor / sk(i,0);
+		lk(i,0) = select(warm_lanes && lk(i,0) < lk_min, lk_min, lk(i,0));
+	}
+
+	pdipBatch<qpiter, algorithm, MS>(Hcal, h, Mx, cx, criteria, result, unau, lk, sk);
+
+	// Keep the iterates of the lanes that solved their QP, as mpc_dense does
+
+	static const T store_tol_f = pow(10.0, exit_tol);
+	LaneMask<K> solved;
+
+	for(int k = 0; k < K; ++k)
+	{
+		solved.m[k] = warm.enabled && (result[k].status == PDIP_CONVERGED ||
+			(!early_exit && result[k].gap <= store_tol_f && result[k].residual <= store_tol_f));
+	}
+
+	warm.valid = solved;
+
+	for(int i = 0; i < M*L; ++i)
+	{
+		warm.tk(i,0) = select(solved, unau(i,0), warm.tk(i,0));
+	}
+
+	for(int i = 0; i < V; ++i)
+	{
+		warm.lk(i,0) = select(solved, lk(i,0), warm.lk(i,0));
+	}
+
+	// Write output vectors
+
+	for(int i = 0; i < M; ++i)
+	{
+		u(i,0) = unau(i,0) + uinfy(i,0);
+	}
+}
+
+/*!
+@brief  Overloaded function provided by convenience. Cold starts the QP solver of every plant.
+*/
+template<
+	MpcConstraints constraints,
+	int L,
+	bool track_ref = false,
+	int qpiter = 20,
+	bool early_exit = false,
+	int exit_tol = -4,
+	PdipAlgorithm algorithm = PDIP_FIXED_CENTERING,
+	int N, int M, int V, int K, typename T = float
+>
+void mpc_dense_batch
+(
+	const Matrix<N,N,T> &AL,
+	const Matrix<N*L,N,T> &Acal, const Matrix<M*L,M*L,T> &Hcal, const Matrix<V,M*L,T> &Mx,
+	const Matrix<M,1,T> &umin, const Matrix<M,1,T> &umax, const Matrix<M,1,Lanes<K,T>> &uinfy,
+	const Matrix<N,1,T> &xmin, const Matrix<N,1,T> &xmax, const Matrix<N,1,Lanes<K,T>> &xinfy,
+	const Matrix<N,1,T> &Nxmin, const Matrix<N,1,T> &Nxmax,
+	const Matrix<M*L,N,T> &h_base,
+	Matrix<V,1,Lanes<K,T>> &cx, Matrix<N,1,Lanes<K,T>> &x, Matrix<M,1,Lanes<K,T>> &u,
+	PdipResult<T> (&result)[K]
+)
+{
+	MpcWarmStartBatch<M*L,V,K,T> warm(false);
+
+	mpc_dense_batch<constraints, L, track_ref, qpiter, early_exit, exit_tol, algorithm>(
+		AL,
+		Acal, Hcal, Mx,
+		umin, umax, uinfy,
+		xmin, xmax, xinfy,
+		Nxmin, Nxmax,
+		h_base,
+		cx, x, u,
+		result, warm
+	);
+}
@@ -0,0 +1,383 @@
+#pragma once
+
+#include <cstdint>
+#include <ios>
+#include <ostream>
+
+/*!
+@file   mpc_profile.hpp
+@brief  Optional instrumentation of the control step: latency of every call and of its stages, and QP and inner solver
+        iterations, recorded into fixed-size log-linear histograms so tail percentiles are available, not only means.
+
+Selected at compile time with MPC_PROFILE, never from generic_dense_defaults.hpp, so every translation unit agrees:
+
+    0   Disabled, the default. The MPC_PROFILE_* macros expand to nothing and nothing is timed or stored
+    1   Wall-clock time from std::chrono::steady_clock, in nanoseconds
+    2   Time stamp counter of x86 processors, in cycles
+
+The histograms live in a thread_local MpcProfile, so concurrent controllers do not share counters; mpcProfile() reads
+those of the calling thread.
+*/
+
+#ifndef MPC_PROFILE
+#define MPC_PROFILE 0
+#endif
+
+/*! Stages of a control step, timed on every call */
+enum MpcStage
+{
+	MPC_STAGE_CONSTRAINTS,  /*!< Constraints and cost vectors of the current state, warm start */
+	MPC_STAGE_ASSEMBLY,     /*!< Ak and the residuals, once per QP iteration */
+	MPC_STAGE_SOLVE,        /*!< Factorization of Ak and search directions */
+	MPC_STAGE_STEP,         /*!< Step length and update of the iterates */
+	MPC_STAGE_COUNT
+};
+
+/*!
+@brief  Fixed-size histogram of non-negative integers in the style of HdrHistogram: values below 2^S are counted
+        exactly, above that every power of two is split in 2^S buckets, so any value is known within a relative error
+        of 2^-S. Values from 2^B on share the last bucket. No allocation, recording is a handful of integer operations.
+@tparam S   Bits of precision, 5 gives 3 %
+@tparam B   Bits of the largest value told apart, 40 covers 18 minutes in nanoseconds
+*/
+template<int S = 5, int B = 40>
+class LatencyHistogram
+{
+	static_assert(S > 0 && B > S && B < 64, "LatencyHistogram needs 0 < S < B < 64");
+
+public:
+	//! Number of buckets
+	static constexpr int BUCKETS = (B - S + 1) << S;
+
+	LatencyHistogram()
+	{
+		reset();
+	}
+
+	void reset()
+	{
+		for(int i = 0; i < BUCKETS; ++i)
+		{
+			m_counts[i] = 0;
+		}
+
+		m_count = 0;
+		m_sum = 0;
+		m_max = 0;
+	}
+
+	void record(std::uint64_t value)
+	{
+		++m_counts[index(value)];
+		++m_count;
+		m_sum += double(value);
+		m_max = value > m_max ? value : m_max;
+	}
+
+	//! Adds the samples of another histogram, as the ones of other threads
+	void merge(const LatencyHistogram &other)
+	{
+		for(int i = 0; i < BUCKETS; ++i)
+		{
+			m_counts[i] += other.m_counts[i];
+		}
+
+		m_count += other.m_count;
+		m_sum += other.m_sum;
+		m_max = other.m_max > m_max ? other.m_max : m_max;
+	}
+
+	std::uint64_t count() const { return m_count; }
+	std::uint64_t max() const { return m_max; }
+	double mean() const { return m_count ? m_sum / m_count : 0; }
+
+	/*!
+	@brief  Smallest value with at least p percent of the samples at or below it, rounded up to the end of its bucket
+	@param  p   Percentile in [0, 100]
+	*/
+	std::uint64_t percentile(double p) const
+	{
+		if(m_count == 0)
+		{
+			return 0;
+		}
+
+		double rank = p / 100 * double(m_count);
+		std::uint64_t target = rank < 1 ? 1 : std::uint64_t(rank);
+		target += double(target) < rank;
+		target = target < m_count ? target : m_count;
+
+		std::uint64_t seen = 0;
+
+		for(int i = 0; i < BUCKETS; ++i)
+		{
+			seen += m_counts[i];
+
+			if(seen >= target)
+			{
+				std::uint64_t top = i < BUCKETS - 1 ? upper(i) : m_max;
+				return top < m_max ? top : m_max;
+			}
+		}
+
+		return m_max;
+	}
+
+private:
+	static int msb(std::uint64_t value)
+	{
+#if defined(__GNUC__)
+		return 63 - __builtin_clzll(value);
+#else
+		int bit = 0;
+
+		while(value >>= 1)
+		{
+			++bit;
+		}
+
+		return bit;
+#endif
+	}
+
+	static int index(std::uint64_t value)
+	{
+		if(value < (std::uint64_t(1) << S))
+		{
+			return int(value);
+		}
+
+		if(value >= (std::uint64_t(1) << B))
+		{
+			return BUCKETS - 1;
+		}
+
+		const int e = msb(value);
+
+		return ((e - S + 1) << S) + int((value >> (e - S)) - (std::uint64_t(1) << S));
+	}
+
+	//! Largest value counted in bucket i
+	static std::uint64_t upper(int i)
+	{
+		if(i < (1 << S))
+		{
+			return std::uint64_t(i);
+		}
+
+		const int shift = (i >> S) - 1;
+		const std::uint64_t lower = ((std::uint64_t(1) << S) + (i & ((1 << S) - 1))) << shift;
+
+		return lower + (std::uint64_t(1) << shift) - 1;
+	}
+
+	std::uint32_t m_counts[BUCKETS];
+	std::uint64_t m_count;
+	double m_sum;
+	std::uint64_t m_max;
+};
+
+/*!
+@brief  Histograms of the control steps of one thread
+*/
+struct MpcProfileData
+{
+	LatencyHistogram<> total;                   //!< Whole call, cache hits and explicit lookups included
+	LatencyHistogram<> stages[MPC_STAGE_COUNT]; //!< Time of every stage, summed over the QP iterations of a call
+	LatencyHistogram<> qp_iterations;           //!< QP iterations of every solve
+	LatencyHistogram<> inner_iterations;        //!< Inner solver iterations of every solve
+
+	void reset()
+	{
+		total.reset();
+		qp_iterations.reset();
+		inner_iterations.reset();
+
+		for(int i = 0; i < MPC_STAGE_COUNT; ++i)
+		{
+			stages[i].reset();
+		}
+	}
+};
+
+/*!
+@brief  Table of count, mean, p50, p90, p99, p99.9 and max of every histogram
+@param  unit    Unit of the times, "ns" or "cycles"
+*/
+inline void mpcProfileReport(const MpcProfileData &data, std::ostream &out, const char *unit)
+{
+	static const char *names[MPC_STAGE_COUNT] = {"constraints", "assembly", "solve", "step length"};
+	const std::ios::fmtflags flags = out.flags();
+	const std::streamsize precision = out.precision();
+
+	auto row = [&out](const char *name, const LatencyHistogram<> &h)
+	{
+		out.width(22);
+		out << std::left << name << std::right;
+		out.width(10);
+		out << h.count();
+
+		const double values[6] =
+		{
+			h.mean(), double(h.percentile(50)), double(h.percentile(90)),
+			double(h.percentile(99)), double(h.percentile(99.9)), double(h.max())
+		};
+
+		for(int i = 0; i < 6; ++i)
+		{
+			out.width(11);
+			out << std::fixed;
+			out.precision(i ? 0 : 1);
+			out << values[i];
+		}
+
+		out << std::endl;
+	};
+
+	out.width(22);
+	out << std::left << unit << std::right;
+	const char *columns[7] = {"count", "mean", "p50", "p90", "p99", "p99.9", "max"};
+
+	for(int i = 0; i < 7; ++i)
+	{
+		out.width(i ? 11 : 10);
+		out << columns[i];
+	}
+
+	out << std::endl;
+	row("total", data.total);
+
+	for(int i = 0; i < MPC_STAGE_COUNT; ++i)
+	{
+		row(names[i], data.stages[i]);
+	}
+
+	out << std::endl;
+	row("QP iterations", data.qp_iterations);
+	row("inner iterations", data.inner_iterations);
+
+	out.flags(flags);
+	out.precision(precision);
+}
+
+#if MPC_PROFILE
+
+#if MPC_PROFILE == 2
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define MPC_PROFILE_UNIT "cycles"
+#else
+#include <chrono>
+#define MPC_PROFILE_UNIT "ns"
+#endif
+
+//! Current time in MPC_PROFILE_UNIT
+inline std::uint64_t mpcProfileNow()
+{
+#if MPC_PROFILE == 2
+	return __rdtsc();
+#else
+	return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+/*!
+@brief  Recorder of the current thread. Calls nest, MpcController::step around mpc_dense, and only the outermost one
+        is recorded, so callers of mpc_dense alone are timed as well. Stages are laps: each one records the time since
+        the previous lap or the start of the call.
+*/
+class MpcProfile
+{
+public:
+	MpcProfile() : m_depth(0), m_start(0), m_lap(0), m_pending(), m_timed()
+	{ }
+
+	void begin()
+	{
+		if(m_depth++ == 0)
+		{
+			m_start = m_lap = mpcProfileNow();
+
+			for(int i = 0; i < MPC_STAGE_COUNT; ++i)
+			{
+				m_pending[i] = 0;
+				m_timed[i] = false;
+			}
+		}
+	}
+
+	void lap(MpcStage stage)
+	{
+		if(m_depth == 0)
+		{
+			return;
+		}
+
+		std::uint64_t now = mpcProfileNow();
+		m_pending[stage] += now - m_lap;
+		m_timed[stage] = true;
+		m_lap = now;
+	}
+
+	void iterations(int qp, int inner)
+	{
+		m_data.qp_iterations.record(std::uint64_t(qp));
+		m_data.inner_iterations.record(std::uint64_t(inner));
+	}
+
+	void end()
+	{
+		if(--m_depth == 0)
+		{
+			m_data.total.record(mpcProfileNow() - m_start);
+
+			for(int i = 0; i < MPC_STAGE_COUNT; ++i)
+			{
+				if(m_timed[i])
+				{
+					m_data.stages[i].record(m_pending[i]);
+				}
+			}
+		}
+	}
+
+	const MpcProfileData &data() const { return m_data; }
+
+	void reset()
+	{
+		m_data.reset();
+	}
+
+private:
+	int m_depth;
+	std::uint64_t m_start;
+	std::uint64_t m_lap;
+	std::uint64_t m_pending[MPC_STAGE_COUNT];
+	bool m_timed[MPC_STAGE_COUNT];
+	MpcProfileData m_data;
+};
+
+//! Recorder of the calling thread
+inline MpcProfile &mpcProfile()
+{
+	static thread_local MpcProfile profile;
+	return profile;
+}
+
+#define MPC_PROFILE_BEGIN() mpcProfile().begin()
+#define MPC_PROFILE_LAP(stage) mpcProfile().lap(stage)
+#define MPC_PROFILE_ITERATIONS(qp, inner) mpcProfile().iterations(qp, inner)
+#define MPC_PROFILE_END() mpcProfile().end()
+
+#else
+
+#define MPC_PROFILE_BEGIN()
+#define MPC_PROFILE_LAP(stage)
+#define MPC_PROFILE_ITERATIONS(qp, inner)
+#define MPC_PROFILE_END()
+
+#endif
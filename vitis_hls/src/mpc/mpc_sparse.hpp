@@ -0,0 +1,259 @@
+#pragma once
+
+#include "Matrix.hpp"
+#include "mpc_constraints.hpp"
+#include "pdip_sparse.hpp"
+
+/*!
+@file   mpc_sparse.hpp
+@brief  MPC with the sparse, non-condensed formulation. mpc_dense eliminates the states, so Hcal and Mx grow with
+        (M*L)^2 and its factorization with (M*L)^3. Here the states stay as decision values and the interior-point
+        steps are solved stage by stage (see sparse_kkt.hpp), with a cost linear in L. Meant for long horizons.
+*/
+
+/*!
+@brief  Iterates kept between consecutive mpc_sparse calls to warm start the QP solver
+@tparam N   Number of states
+@tparam M   Number of inputs
+@tparam L   Prediction horizon
+@tparam T   Data type
+*/
+template<int N, int M, int L, typename T = float>
+struct MpcSparseWarmStart
+{
+	/*!
+	@param  enabled If false, every solve is cold started
+	@param  floor   Minimum value for the shifted multipliers and slacks
+	*/
+	MpcSparseWarmStart(bool enabled = true, T floor = 1e-3) : valid(false), enabled(enabled), floor(floor) { }
+
+	Matrix<L*(N+M),1,T> z;  //!< Decision values of the last solve
+	Matrix<L*N,1,T> v;      //!< Dynamics multipliers of the last solve
+	Matrix<L*(N+M),1,T> lu; //!< Upper bound multipliers of the last solve
+	Matrix<L*(N+M),1,T> ll; //!< Lower bound multipliers of the last solve
+	bool valid;             //!< True while the stored iterates solved their QP
+	bool enabled;           //!< Toggle warm starting
+	T floor;                //!< Minimum value for the shifted multipliers and slacks
+};
+
+/*!
+@brief  Bounds of the decision values of the sparse formulation, in the same coordinates as the constraints vector
+        of mpc_dense: relative to the stationary target, and the target subtracted only when tracking a reference.
+        Final state bounds are intersected with the state bounds of the last stage.
+*/
+template<MpcConstraints constraints, bool track_ref, int L, int N, int M, typename T>
+void sparseBounds
+(
+	const Matrix<M,1,T> &umin, const Matrix<M,1,T> &umax, const Matrix<M,1,T> &uinfy,
+	const Matrix<N,1,T> &xmin, const Matrix<N,1,T> &xmax, const Matrix<N,1,T> &xinfy,
+	const Matrix<N,1,T> &Nxmin, const Matrix<N,1,T> &Nxmax,
+	Matrix<L*(N+M),1,T> &lo, Matrix<L*(N+M),1,T> &hi, Matrix<L*(N+M),1,T> &box
+)
+{
+	constexpr int S = N + M;
+
+	lo = T(0);
+	hi = T(0);
+	box = T(0);
+
+	for(int k = 0; k < L; ++k)
+	{
+		for(int i = 0; i < M && (constraints & INPUT); ++i)
+		{
+			lo(k*S + i, 0) = track_ref ? umin(i,0) - uinfy(i,0) : umin(i,0);
+			hi(k*S + i, 0) = track_ref ? umax(i,0) - uinfy(i,0) : umax(i,0);
+			box(k*S + i, 0) = 1;
+		}
+
+		for(int i = 0; i < N && (constraints & STATE); ++i)
+		{
+			lo(k*S + M + i, 0) = track_ref ? xmin(i,0) - xinfy(i,0) : xmin(i,0);
+			hi(k*S + M + i, 0) = track_ref ? xmax(i,0) - xinfy(i,0) : xmax(i,0);
+			box(k*S + M + i, 0) = 1;
+		}
+	}
+
+	for(int i = 0; i < N && (constraints & FINALSTATE); ++i)
+	{
+		const int j = (L-1)*S + M + i;
+		T Nlo = track_ref ? Nxmin(i,0) - xinfy(i,0) : Nxmin(i,0);
+		T Nhi = track_ref ? Nxmax(i,0) - xinfy(i,0) : Nxmax(i,0);
+
+		lo(j,0) = box(j,0) != 0 && lo(j,0) > Nlo ? lo(j,0) : Nlo;
+		hi(j,0) = box(j,0) != 0 && hi(j,0) < Nhi ? hi(j,0) : Nhi;
+		box(j,0) = 1;
+	}
+}
+
+/*!
+@brief  MPC sparse implementation. Same problem and result as mpc_dense for the weights that condense into its Hcal
+        and h_base, Hcal = Bcal'*blkdiag(Q, ..., Q, P)*Bcal + blkdiag(R, ..., R)
+@tparam solver  KKT solver, see SparseKkt
+@tparam constraints Type of constraints of the system
+@tparam L   Prediction horizon
+@tparam track_ref   true if yref will be used
+@tparam qpiter  Number of iterations for QP algorithm
+@tparam early_exit  Stop the QP iterations once the exit criteria are met
+@tparam exit_tol    Magnitude order of the residual and duality gap tolerances used for early exit
+@tparam algorithm   Search direction strategy of the QP solver
+@param  A   State matrix of the plant
+@param  B   Input matrix of the plant
+@param  Q   State weight of the stages 1 to L-1
+@param  R   Input weight
+@param  P   Final state weight
+@param  x       States of the system
+@param  u       Input values for system
+@param  result  Statistics and exit status of the QP solver
+@param  warm    Iterates of the previous solve. Shifted one stage along the horizon to start the QP solver, then updated
+*/
+template<
+	Solvers solver,
+	MpcConstraints constraints,
+	int L,
+	bool track_ref = false,
+	int qpiter = 20,
+	bool early_exit = false,
+	int exit_tol = -4,
+	PdipAlgorithm algorithm = PDIP_FIXED_CENTERING,
+	int N, int M, typename T = float // automatically deduced from input arguments
+>
+void mpc_sparse
+(
+	const Matrix<N,N,T> &A, const Matrix<N,M,T> &B,
+	const Matrix<N,N,T> &Q, const Matrix<M,M,T> &R, const Matrix<N,N,T> &P,
+	const Matrix<M,1,T> &umin, const Matrix<M,1,T> &umax, const Matrix<M,1,T> &uinfy,
+	const Matrix<N,1,T> &xmin, const Matrix<N,1,T> &xmax, const Matrix<N,1,T> &xinfy,
+	const Matrix<N,1,T> &Nxmin, const Matrix<N,1,T> &Nxmax,
+	Matrix<N,1,T> &x, Matrix<M,1,T> &u,
+	PdipResult<T> &result, MpcSparseWarmStart<N,M,L,T> &warm
+)
+{
+	constexpr int S = N + M;
+	constexpr int Z = L*S;
+
+	// Read input vector
+
+	Matrix<N,1,T> x0nau(x - xinfy);
+
+	// Bounds of the decision values
+
+	Matrix<Z,1,T> lo, hi, box;
+
+	sparseBounds<constraints, track_ref, L>(umin, umax, uinfy, xmin, xmax, xinfy, Nxmin, Nxmax, lo, hi, box);
+
+	// Solve QP problem. Free values keep a zero multiplier and a unit slack
+
+	static const PdipCriteria<T> criteria = pdipCriteria<T>(early_exit, exit_tol);
+	Matrix<Z,1,T> z(T(0));
+	Matrix<L*N,1,T> v(T(0));
+	Matrix<Z,1,T> lu(T(0));
+	Matrix<Z,1,T> su(T(1));
+
+	for(int i = 0; i < Z; ++i)
+	{
+		if(box(i,0) != 0)
+		{
+			lu(i,0) = 0.5;
+		}
+	}
+
+	Matrix<Z,1,T> ll = lu;
+	Matrix<Z,1,T> sl = su;
+
+	const bool warm_start = warm.enabled && warm.valid;
+	const T floor = warm_start ? warm.floor : T(0.5);
+
+	if(warm_start)
+	{
+		// Shift the previous solution one stage
+
+		z = warm.z;
+		v = warm.v;
+		lu = warm.lu;
+		ll = warm.ll;
+		z.template shift<0, S, L>();
+		v.template shift<0, N, L>();
+		lu.template shift<0, S, L>();
+		ll.template shift<0, S, L>();
+	}
+
+	// Slacks are computed from the bounds, then pushed into the interior, see pdipStartSlacks
+
+	for(int i = 0; i < Z; ++i)
+	{
+		if(box(i,0) != 0)
+		{
+			su(i,0) = hi(i,0) - z(i,0) < floor ? floor : hi(i,0) - z(i,0);
+			sl(i,0) = z(i,0) - lo(i,0) < floor ? floor : z(i,0) - lo(i,0);
+
+			if(warm_start)
+			{
+				T lu_min = warm.floor / su(i,0);
+				T ll_min = warm.floor / sl(i,0);
+				lu(i,0) = lu(i,0) < lu_min ? lu_min : lu(i,0);
+				ll(i,0) = ll(i,0) < ll_min ? ll_min : ll(i,0);
+			}
+		}
+	}
+
+	pdipSparse<solver, L, qpiter, algorithm>(A, B, Q, R, P, x0nau, lo, hi, box, criteria, result, z, v, lu, su, ll, sl);
+
+	// Keep the iterates only when they solve the QP, see mpc_dense
+
+	static const T store_tol_f = pow(10.0, exit_tol);
+	warm.valid = warm.enabled && (result.status == PDIP_CONVERGED ||
+		(!early_exit && result.gap <= store_tol_f && result.residual <= store_tol_f));
+
+	if(warm.valid)
+	{
+		warm.z = z;
+		warm.v = v;
+		warm.lu = lu;
+		warm.ll = ll;
+	}
+
+	// Write output vector
+
+	for(int i = 0; i < M; ++i)
+	{
+		u(i,0) = z(i,0) + uinfy(i,0);
+	}
+}
+
+/*!
+@brief  Overloaded function provided by convenience. Cold starts the QP solver.
+*/
+template<
+	Solvers solver,
+	MpcConstraints constraints,
+	int L,
+	bool track_ref = false,
+	int qpiter = 20,
+	bool early_exit = false,
+	int exit_tol = -4,
+	PdipAlgorithm algorithm = PDIP_FIXED_CENTERING,
+	int N, int M, typename T = float
+>
+void mpc_sparse
+(
+	const Matrix<N,N,T> &A, const Matrix<N,M,T> &B,
+	const Matrix<N,N,T> &Q, const Matrix<M,M,T> &R, const Matrix<N,N,T> &P,
+	const Matrix<M,1,T> &umin, const Matrix<M,1,T> &umax, const Matrix<M,1,T> &uinfy,
+	const Matrix<N,1,T> &xmin, const Matrix<N,1,T> &xmax, const Matrix<N,1,T> &xinfy,
+	const Matrix<N,1,T> &Nxmin, const Matrix<N,1,T> &Nxmax,
+	Matrix<N,1,T> &x, Matrix<M,1,T> &u,
+	PdipResult<T> &result
+)
+{
+	MpcSparseWarmStart<N,M,L,T> warm(false);
+
+	mpc_sparse<solver, constraints, L, track_ref, qpiter, early_exit, exit_tol, algorithm>(
+		A, B,
+		Q, R, P,
+		umin, umax, uinfy,
+		xmin, xmax, xinfy,
+		Nxmin, Nxmax,
+		x, u,
+		result, warm
+	);
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Matrix.hpp"
+
+/*!
+@file   mx_ops.hpp
+*/
+
+/*! Known structures of the constraints matrix Mx */
+enum MxStructure
+{
+	MX_DENSE,      /*!< General dense VxN matrix */
+	MX_BOX         /*!< Box constraints, Mx = [I; -I] and V = 2N */
+};
+
+/*!
+@brief  Products against the constraints matrix used by pdip, specialised on the structure of Mx.
+@tparam structure   Structure of Mx
+@tparam V   Number of constraints, rows of Mx
+@tparam N   Number of optimization values, columns of Mx
+@tparam T   Data type
+*/
+template<MxStructure structure, int V, int N, typename T = float>
+struct MxOps
+{ };
+
+template<int V, int N, typename T>
+struct MxOps<MX_DENSE, V, N, T>
+{
+	/*!
+	@brief  Computes Mx*x
+	*/
+	static Matrix<V,1,T> mul(const Matrix<V,N,T> &Mx, const Matrix<N,1,T> &x)
+	{
+		#pragma HLS INLINE
+		return Mx * x;
+	}
+
+	/*!
+	@brief  Computes Mx'*v
+	*/
+	static Matrix<N,1,T> multTr(const Matrix<V,N,T> &Mx, const Matrix<V,1,T> &v)
+	{
+		#pragma HLS INLINE
+		return Mx.multTr(v);
+	}
+
+	/*!
+	@brief  Computes H + Mx'*diag(d)*Mx
+	*/
+	static Matrix<N,N,T> addScaledGram(const Matrix<N,N,T> &H, const Matrix<V,N,T> &Mx, const Matrix<V,1,T> &d)
+	{
+		#pragma HLS INLINE
+		return H + Mx.scaledGram(d);
+	}
+};
+
+/*!
+@brief  Box constraints specialisation. Mx is never read, every product reduces to O(N) additions and subtractions,
+        unrolled for tiny N as the element-wise matrix operations.
+*/
+template<int V, int N, typename T>
+struct MxOps<MX_BOX, V, N, T>
+{
+	static_assert(V == 2*N, "Box constraints require Mx = [I; -I]");
+
+	static Matrix<V,1,T> mul(const Matrix<V,N,T>&, const Matrix<N,1,T> &x)
+	{
+		#pragma HLS INLINE
+		Matrix<V,1,T> res;
+
+		MatrixForEach<N,1>::run([&](int i, int)
+		{
+			res(i,0) = x(i,0);
+			res(i+N,0) = -x(i,0);
+		});
+
+		return res;
+	}
+
+	static Matrix<N,1,T> multTr(const Matrix<V,N,T>&, const Matrix<V,1,T> &v)
+	{
+		#pragma HLS INLINE
+		Matrix<N,1,T> res;
+
+		MatrixForEach<N,1>::run([&](int i, int) { res(i,0) = v(i,0) - v(i+N,0); });
+
+		return res;
+	}
+
+	static Matrix<N,N,T> addScaledGram(const Matrix<N,N,T> &H, const Matrix<V,N,T>&, const Matrix<V,1,T> &d)
+	{
+		#pragma HLS INLINE
+		Matrix<N,N,T> res = H;
+
+		MatrixForEach<N,1>::run([&](int i, int) { res(i,i) += d(i,0) + d(i+N,0); });
+
+		return res;
+	}
+};
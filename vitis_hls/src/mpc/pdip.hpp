@@ -1,32 +1,263 @@
 #pragma once
 
+#include <cmath>
+#include <limits>
+
 #include "Matrix.hpp"
 #include "cgrad.hpp"
 #include "lschol.hpp"
 #include "minres.hpp"
+#include "mpc_profile.hpp"
+#include "mx_ops.hpp"
 #include "solver_dispatch.hpp"
 
 /*!
 @file   pdip.hpp
 */
 
+/*! Search direction strategies for pdip */
+enum PdipAlgorithm
+{
+	PDIP_FIXED_CENTERING,   /*!< Single Newton direction per iteration with a fixed centering parameter, sgk = 0.5 */
+	PDIP_MEHROTRA           /*!< Mehrotra predictor-corrector, adaptive sgk and two solves per factorization */
+};
+
+/*! Outcome of a pdip solve */
+enum PdipStatus
+{
+	PDIP_CONVERGED,     /*!< Residuals and duality gap below the requested tolerances */
+	PDIP_INFEASIBLE,    /*!< Multipliers diverged while the primal residual stayed large */
+	PDIP_MAX_ITER       /*!< Iteration budget exhausted */
+};
+
+/*!
+@brief  Exit criteria for pdip. A zero or negative field disables the corresponding check: the iterate converges once
+        every enabled tolerance is met, and never while both residual and gap are disabled, so {0, 0, 0} runs the whole
+        iteration budget.
+@tparam T   Data type
+*/
+template<typename T = float>
+struct PdipCriteria
+{
+	T residual;     //!< Maximum absolute value of the primal and dual residuals
+	T gap;          //!< Maximum duality gap, muk
+	T dual_bound;   //!< Multipliers magnitude above which the problem is declared primal infeasible
+};
+
+/*!
+@brief  Statistics of a pdip solve
+@tparam T   Data type
+*/
+template<typename T = float>
+struct PdipResult
+{
+	int iterations;         //!< Number of iterations performed
+	T gap;                  //!< Duality gap, muk, of the returned iterate
+	T residual;             //!< Maximum absolute value of the primal and dual residuals of the returned iterate
+	PdipStatus status;      //!< Exit reason
+	int inner_iterations;   //!< Inner solver iterations summed over every solve. 0 for direct solvers, refinement steps of CHOLESKY_MIXED
+};
+
+/*!
+@brief  Evaluates the exit criteria on an iterate
+@param  gap Duality gap, muk
+@param  residual    Maximum absolute value of the primal and dual residuals
+@param  res_p   Maximum absolute value of the primal residual
+@param  dual    Maximum absolute value of the multipliers
+@return PDIP_CONVERGED or PDIP_INFEASIBLE to stop, PDIP_MAX_ITER to keep iterating
+*/
+template<typename T>
+PdipStatus pdipExitStatus(const PdipCriteria<T> &criteria, T gap, T residual, T res_p, T dual)
+{
+	const bool enabled = criteria.gap > 0 || criteria.residual > 0;
+
+	if(enabled && (criteria.gap <= 0 || gap <= criteria.gap) && (criteria.residual <= 0 || residual <= criteria.residual))
+	{
+		return PDIP_CONVERGED;
+	}
+
+	if(criteria.dual_bound > 0 && dual > criteria.dual_bound && (criteria.residual <= 0 || res_p > criteria.residual))
+	{
+		return PDIP_INFEASIBLE;
+	}
+
+	return PDIP_MAX_ITER;
+}
+
+/*!
+@brief  Exit criteria of a tolerance 10^exit_tol on the residuals and the gap, multipliers above its inverse squared
+        declare the problem infeasible. In fixed point the tolerance is kept at one unit of the last place at least, a
+        finer one would round to zero and disable the exit, and the bound saturates at the largest value.
+@param  early_exit  false gives disabled criteria, every solve runs the whole iteration budget
+*/
+template<typename T>
+PdipCriteria<T> pdipCriteria(bool early_exit, double exit_tol)
+{
+	if(!early_exit)
+	{
+		return PdipCriteria<T>{T(0), T(0), T(0)};
+	}
+
+	const double lsb = double(std::numeric_limits<T>::min());
+	const double largest = double(std::numeric_limits<T>::max());
+	const double tol = std::pow(10.0, exit_tol) > lsb ? std::pow(10.0, exit_tol) : lsb;
+	const double bound = 1 / (tol * tol) < largest ? 1 / (tol * tol) : largest;
+
+	return PdipCriteria<T>{T(tol), T(tol), T(bound)};
+}
+
+/*!
+@brief  Exit criteria widened to what a fixed-point type can resolve. Multipliers are kept at or above one unit of the
+        last place, lk_min, so the gap cannot drop below lk_min times the slacks of the inactive constraints, and the
+        residuals round to a few units. Tolerances finer than that would never be met and every solve would run the
+        whole iteration budget. Disabled checks stay disabled.
+@param  sk  Current slacks
+*/
+template<int M, typename T>
+PdipCriteria<T> pdipResolutionCriteria(const PdipCriteria<T> &criteria, const Matrix<M,1,T> &sk)
+{
+	const T lsb = std::numeric_limits<T>::min();
+	PdipCriteria<T> widened = criteria;
+
+	widened.gap = criteria.gap > 0 ? criteria.gap + lsb * sk.maxAbs() : criteria.gap;
+	widened.residual = criteria.residual > 0 ? criteria.residual + lsb * 4 : criteria.residual;
+
+	return widened;
+}
+
+/*!
+@brief  Largest step in (0,1] keeping k + alp*delta positive, shortened by a factor bt. Branch-free: every ratio is
+        computed and selected, so the loop pipelines and tiny sizes unroll into straight-line code.
+@param  delta   Step direction
+@param  k       Current iterate, positive wherever delta can be negative
+@param  bt      Fraction of the distance to the boundary
+@return Step length
+*/
 template <int N, typename T = float>
-T computeAlp(Matrix<N, 1, T> delta, Matrix<N, 1, T> k)
+T computeAlp(const Matrix<N, 1, T> &delta, const Matrix<N, 1, T> &k, T bt = T(0.99999))
 {
-	T bt = 0.99999;
 	T alp = 1;
 
-	for(int elem = 0; elem < N; elem++)
+	MatrixForEach<N,1>::run([&](int elem, int)
 	{
-		if(delta(elem,0) < 0 && -delta(elem,0)/k(elem,0) > alp)
-		{
-			alp = -delta(elem,0)/k(elem,0);
-		}
-	}
+		T ratio = -delta(elem,0) / k(elem,0);
+		alp = (delta(elem,0) < 0) & (ratio > alp) ? ratio : alp;
+	});
 
 	return bt/alp;
 }
 
+/*!
+@brief  Computes the pdip search direction from an already factorized Newton system.
+@param  F   Factorization of Ak
+@param  HK  Dual residual, -(H*tk + h + Mx'*lk)
+@param  GK  Primal residual, cx - sk - Mx*tk
+@param  TK  Complementarity target minus lk.*sk
+@param  zko Initial values for iterative solvers
+@param  tol Tolerance of iterative solvers
+@param  iter_cap    Iteration limit of iterative solvers, at most mrmax
+@param  zk  Resulting step for tk
+@param  Dlk Resulting step for lk
+@param  Dsk Resulting step for sk
+@return Iterations of the inner linear solver
+*/
+template<Solvers S, int mrmax, MxStructure MS, int N, int M, typename T>
+int pdipDirection
+(
+	const Matrix<N,N,T> &Ak, const typename SolverDispatch<S, N, mrmax, T>::Factor &F, const Matrix<M,N,T> &Mx,
+	const Matrix<M,1,T> &lk, const Matrix<M,1,T> &sk,
+	const Matrix<N,1,T> &HK, const Matrix<M,1,T> &GK, const Matrix<M,1,T> &TK,
+	Matrix<N,1,T> &zko, T tol, int iter_cap,
+	Matrix<N,1,T> &zk, Matrix<M,1,T> &Dlk, Matrix<M,1,T> &Dsk
+)
+{
+	#pragma HLS INLINE
+	using Ops = MxOps<MS, M, N, T>;
+
+	// Only divides by sk: lk goes to zero on inactive constraints, which is harmful for fixed-point types
+
+	Matrix<N, 1, T> bk = HK + Ops::multTr(Mx, (lk.emulCopy(GK) - TK).edivCopy(sk));
+
+	int iterations = SolverDispatch<S, N, mrmax, T>::solve(Ak, F, bk, zko, tol, zk, iter_cap);
+
+	Dsk = GK - Ops::mul(Mx, zk);
+	Dlk = (TK - lk.emulCopy(Dsk)).edivCopy(sk);
+
+	return iterations;
+}
+
+/*!
+@brief  Decimal digits asked by a tolerance, ceil(-log10(x)) clamped to [0, 19]. Counted against a table of powers of
+        ten, so the forcing terms need no logarithms on every QP iteration.
+*/
+inline int pdipDigits(double x)
+{
+	static const double powers[19] =
+	{
+		1e0, 1e-1, 1e-2, 1e-3, 1e-4, 1e-5, 1e-6, 1e-7, 1e-8, 1e-9,
+		1e-10, 1e-11, 1e-12, 1e-13, 1e-14, 1e-15, 1e-16, 1e-17, 1e-18
+	};
+
+	int digits = 0;
+
+	for(int i = 0; i < 19; ++i)
+	{
+		digits += x < powers[i];
+	}
+
+	return digits;
+}
+
+/*!
+@brief  Forcing terms of the inexact Newton mode of pdip. Far from the solution a rough Newton step makes the same
+        progress as an exact one, so the inner tolerance follows the duality gap, tol_k = min(0.1, 0.1*muk), down to
+        tol or the precision of T. The iteration limit grows with the digits tol_k asks for, from mrmax/4 up to mrmax at
+        the finest tolerance. Once the exit criteria are close the step is likely the last one and is solved as an exact
+        one, to tol with mrmax iterations, so the returned iterate is as accurate as with exact steps.
+@param  muk Duality gap of the current iterate
+@param  tol Finest tolerance of the inner solver
+@param  close   The iterate is near the exit criteria, or the step is the last of the budget
+@param  tol_k   Resulting inner tolerance
+@param  cap_k   Resulting inner iteration limit
+*/
+template<int mrmax, typename T>
+void pdipForcing(T muk, T tol, bool close, T &tol_k, int &cap_k)
+{
+	const double eps = double(std::numeric_limits<T>::epsilon());
+	const double finest = double(tol) > eps ? double(tol) : eps;
+	const int digits = pdipDigits(finest);
+	const int cap_min = mrmax/4 > 1 ? mrmax/4 : 1;
+
+	double eta = 0.1 * double(muk);
+	eta = eta < 0.1 ? eta : 0.1;
+	eta = eta > finest ? eta : finest;
+
+	int cap = digits > 1 ? (mrmax * pdipDigits(eta) + digits - 1) / digits : mrmax;
+	cap = cap < cap_min ? cap_min : cap;
+
+	tol_k = close ? tol : T(eta);
+	cap_k = close || cap > mrmax ? mrmax : cap;
+}
+
+/*!
+@brief  Slacks of a starting point, the margins cx - Mx*tk raised to floor where they are smaller. The primal residual
+        starts at zero on every constraint tk satisfies with room; slacks far below the margins send the first steps of a
+        cold start towards the wrong active set.
+@param  floor   Minimum slack
+*/
+template<MxStructure MS, int N, int M, typename T>
+Matrix<M,1,T> pdipStartSlacks(const Matrix<M,N,T> &Mx, const Matrix<M,1,T> &cx, const Matrix<N,1,T> &tk, T floor)
+{
+	Matrix<M,1,T> sk = cx - MxOps<MS, M, N, T>::mul(Mx, tk);
+
+	for(int i = 0; i < M; ++i)
+	{
+		sk(i,0) = sk(i,0) < floor ? floor : sk(i,0);
+	}
+
+	return sk;
+}
+
 /*!
 @brief  Primal-Dual Interior-Point method for solving quadratic convex optimization.
         Quadratic programing (QP) problem solution:
@@ -40,6 +271,11 @@ T computeAlp(Matrix<N, 1, T> delta, Matrix<N, 1, T> k)
                             cx=[g;f;-f]
 
 @tparam S   Solver for linear systems
+@tparam MS  Structure of Mx. MX_BOX skips every product against Mx
+@tparam A   Search direction strategy
+@tparam inexact Inexact Newton steps: the tolerance and iteration limit of iterative inner solvers follow the duality
+                gap, see pdipForcing. Otherwise every solve uses tol and mrmax. Not available with the unpreconditioned
+                MINRES and CGRAD
 @tparam N   Number of optimization values
 @tparam M   Number of systems constraints
 @tparam P
@@ -51,51 +287,223 @@ T computeAlp(Matrix<N, 1, T> delta, Matrix<N, 1, T> k)
 @param  IT  Maximum of iterations for the main algorithm
 @param  tol Error maximum tolerance considered for algorithms
 @param  mrmax   Maximum of iterations for inner linear system solving. As default, is 20.
-@return A Nx1 optimal solutions vector
+@param  criteria    Early exit criteria, checked before every iteration and on the final iterate. Widened by
+                    pdipResolutionCriteria for fixed-point types
+@param  result  Iteration count, final gap and exit status
+@param  tk  Nx1 starting point for the optimization values. Updated with the solution
+@param  lk  Mx1 starting point for the multipliers. Lagrange multipliers must be positive. Updated with the final iterate
+@param  sk  Mx1 starting point for the slacks. Slacks must be positive. Updated with the final iterate
 */
-template<Solvers S = MINRES, int IT, int mrmax, int N, int M, int P, typename T = float>
-Matrix<N,1,T> pdip(const Matrix<N,N,T> &H, const Matrix<N,P,T> &h, const Matrix<M,N,T> &Mx, const Matrix<M,1,T> &cx, T tol)
+template<Solvers S = MINRES, int IT, int mrmax, MxStructure MS = MX_DENSE, PdipAlgorithm A = PDIP_FIXED_CENTERING, bool inexact = false, int N, int M, int P, typename T = float>
+void pdip
+(
+	const Matrix<N,N,T> &H, const Matrix<N,P,T> &h, const Matrix<M,N,T> &Mx, const Matrix<M,1,T> &cx, T tol,
+	const PdipCriteria<T> &criteria, PdipResult<T> &result,
+	Matrix<N,1,T> &tk, Matrix<M,1,T> &lk, Matrix<M,1,T> &sk
+)
 {
-	Matrix<N, 1, T> tk(1.0);
-	Matrix<M, 1, T> lk(0.5);
-	Matrix<M, 1, T> sk(0.5);
+	static_assert(!inexact || (S != MINRES && S != CGRAD),
+		"Inexact Newton steps need a preconditioned Krylov solver, rough unpreconditioned steps lengthen the QP");
+
+	using Ops = MxOps<MS, M, N, T>;
+	using Solver = SolverDispatch<S, N, mrmax, T>;
+
 	Matrix<M, 1, T> em(1.0);
 	Matrix<N, 1, T> zko(0.0);
 	T sgk = 0.5;
+	const T lk_min = std::numeric_limits<T>::min();
 
-	for (int k = 0; k < IT; k++)
-	{
-		// Build Ak
+	result.status = PDIP_MAX_ITER;
+	result.inner_iterations = 0;
+
+	// With inexact steps, whether the step that produced the iterate was solved to the final tolerance, and the iterate
+	// it started from
+	bool final_step = true;
+	bool polish = false;
+	int repeated = 0;
+	Matrix<N, 1, T> tk_prev(tk), zko_prev(zko);
+	Matrix<M, 1, T> lk_prev(lk), sk_prev(sk);
+
+	int k;
+	constexpr bool resolution = std::numeric_limits<T>::is_exact && !std::numeric_limits<T>::is_integer;
 
-		Matrix<M, M, T> RK(lk.edivCopy(sk),true);
-		Matrix<M, M, T> RKI(sk.edivCopy(lk),true);
-		Matrix<N, N, T> Ak = H + Mx.multTr(RK) * Mx;
+	// One pass more than IT: the last one only evaluates the final iterate, so result describes what is returned
 
+	for (k = 0; k <= IT; k++)
+	{
 		// Build bk
 
 		T muk = lk.dot(sk)/M;
-		Matrix<N, 1, T> HK =  (H * tk * - 1) - h - Mx.multTr(lk);
-		Matrix<M, 1, T> GK =  cx - sk - Mx * tk ;
-		Matrix<M, 1, T> TK =  em * sgk * muk - lk.emulCopy(sk);
-		Matrix<N, 1, T> bk = HK + Mx.multTr(RK) * (GK - TK.edivCopy(lk));
+		Matrix<N, 1, T> HK =  (H * tk * - 1) - h - Ops::multTr(Mx, lk);
+		Matrix<M, 1, T> GK =  cx - sk - Ops::mul(Mx, tk);
+
+		// Check exit criteria
+
+		T res_d = HK.maxAbs();
+		T res_p = GK.maxAbs();
+		result.gap = muk;
+		result.residual = res_d > res_p ? res_d : res_p;
+		const PdipCriteria<T> exit_criteria = resolution ? pdipResolutionCriteria(criteria, sk) : criteria;
+		result.status = pdipExitStatus(exit_criteria, muk, result.residual, res_p, lk.maxAbs());
+
+		// A loose inexact step that converged is taken again from the same iterate at the final tolerance, so the
+		// returned iterate is the one of exact steps and inner solvers that only reach T by refinement, as
+		// CHOLESKY_MIXED, refine it. The repeat takes the next pass, so it is only done while that pass is before IT;
+		// otherwise the converged loose iterate is returned. result.iterations counts the loose step and its repeat
+
+		if(inexact && result.status == PDIP_CONVERGED && !final_step && k + 1 < IT)
+		{
+			tk = tk_prev;
+			lk = lk_prev;
+			sk = sk_prev;
+			zko = zko_prev;
+			final_step = true;
+			polish = true;
+			--repeated;
+			continue;
+		}
+
+		if(result.status != PDIP_MAX_ITER || k == IT)
+		{
+			MPC_PROFILE_LAP(MPC_STAGE_ASSEMBLY);
+			break;
+		}
+
+		// Build Ak. RK = diag(lk/sk) is kept as a vector
+
+		Matrix<M, 1, T> rk = lk.edivCopy(sk);
+		Matrix<N, N, T> Ak = Ops::addScaledGram(H, Mx, rk);
+		typename Solver::Factor F;
+		MPC_PROFILE_LAP(MPC_STAGE_ASSEMBLY);
+
+		Solver::factor(Ak, F);
+
+		T tol_k = tol;
+		int cap_k = mrmax;
+
+		if(inexact)
+		{
+			// Close: gap and residual within two digits of the criteria, or the last step when they are disabled
+
+			const bool enabled = exit_criteria.gap > 0 || exit_criteria.residual > 0;
+			const bool close = polish || (enabled ?
+				(exit_criteria.gap <= 0 || muk <= 100 * exit_criteria.gap) &&
+				(exit_criteria.residual <= 0 || result.residual <= 100 * exit_criteria.residual) :
+				k == IT - 1);
+
+			pdipForcing<mrmax>(muk, tol, close, tol_k, cap_k);
+			final_step = close;
+			polish = false;
+
+			if(!close)
+			{
+				tk_prev = tk;
+				lk_prev = lk;
+				sk_prev = sk;
+				zko_prev = zko;
+			}
+		}
+
 		Matrix<N, 1, T> zk;
+		Matrix<M, 1, T> Dlk, Dsk;
+		Matrix<M, 1, T> LS = lk.emulCopy(sk);
+		Matrix<M, 1, T> TK;
+
+		if(A == PDIP_MEHROTRA)
+		{
+			// Predictor: affine scaling direction, sgk = 0
+
+			TK = LS * -1;
+			result.inner_iterations += pdipDirection<S, mrmax, MS>(Ak, F, Mx, lk, sk, HK, GK, TK, zko, tol_k, cap_k, zk, Dlk, Dsk);
 
-		SolverDispatch<S, N, mrmax, T>::call(Ak, bk, zko, tol, zk);
+			T alp_p = computeAlp(Dsk, sk, T(1));
+			T alp_d = computeAlp(Dlk, lk, T(1));
+			T mu_aff = (lk + Dlk * alp_d).dot(sk + Dsk * alp_p)/M;
+			T ratio = mu_aff / muk;
 
-		Matrix<M, 1, T> Dlk = RK *(GK - TK.edivCopy(lk) - Mx * zk) * -1;
-		Matrix<M, 1, T> Dsk = TK.edivCopy(lk) - RKI * Dlk;
+			// Corrector: adaptive centering plus second order term. Rounding can leave mu_aff above muk
 
-		// Find max ak in (0,1]
+			sgk = ratio * ratio * ratio;
+			sgk = sgk < 1 ? sgk : T(1);
+			sgk = sgk > 0 ? sgk : T(0);
+			TK = em * sgk * muk - LS - Dlk.emulCopy(Dsk);
+		}
+		else
+		{
+			TK = em * sgk * muk - LS;
+		}
 
-		T alp_lk = computeAlp(Dlk, lk);
-		T alp_sk = computeAlp(Dsk, sk);
-		T alp = alp_lk > alp_sk ? alp_sk : alp_lk;
+		result.inner_iterations += pdipDirection<S, mrmax, MS>(Ak, F, Mx, lk, sk, HK, GK, TK, zko, tol_k, cap_k, zk, Dlk, Dsk);
+		MPC_PROFILE_LAP(MPC_STAGE_SOLVE);
 
-		tk += zk * alp;
-		lk += Dlk * alp;
-		sk += Dsk * alp;
+		// Find max ak in (0,1]. Mehrotra steps the primal values and slacks and the multipliers by separate lengths, so a
+		// short step of one side does not stall the other
+
+		if(A == PDIP_MEHROTRA)
+		{
+			T alp_p = computeAlp(Dsk, sk);
+			T alp_d = computeAlp(Dlk, lk);
+
+			tk += zk * alp_p;
+			sk += Dsk * alp_p;
+			lk += Dlk * alp_d;
+		}
+		else
+		{
+			T alp_lk = computeAlp(Dlk, lk);
+			T alp_sk = computeAlp(Dsk, sk);
+			T alp = alp_lk > alp_sk ? alp_sk : alp_lk;
+
+			tk += zk * alp;
+			lk += Dlk * alp;
+			sk += Dsk * alp;
+		}
+
+		// Keep the iterates strictly positive when the step rounds them to zero, as it happens with fixed-point types
+
+		for(int i = 0; i < M; ++i)
+		{
+			lk(i,0) = lk(i,0) < lk_min ? lk_min : lk(i,0);
+			sk(i,0) = sk(i,0) < lk_min ? lk_min : sk(i,0);
+		}
 		zko = zk;
+		MPC_PROFILE_LAP(MPC_STAGE_STEP);
 	}
 
+	// The passes that only restored an iterate took no step
+
+	result.iterations = k + repeated;
+}
+
+/*!
+@brief  Overloaded function provided by convenience. Cold starts from tk = 1, lk = 0.5 and the slacks of
+        pdipStartSlacks, at least 0.5.
+@return A Nx1 optimal solutions vector
+*/
+template<Solvers S = MINRES, int IT, int mrmax, MxStructure MS = MX_DENSE, PdipAlgorithm A = PDIP_FIXED_CENTERING, bool inexact = false, int N, int M, int P, typename T = float>
+Matrix<N,1,T> pdip
+(
+	const Matrix<N,N,T> &H, const Matrix<N,P,T> &h, const Matrix<M,N,T> &Mx, const Matrix<M,1,T> &cx, T tol,
+	const PdipCriteria<T> &criteria, PdipResult<T> &result
+)
+{
+	Matrix<N, 1, T> tk(1.0);
+	Matrix<M, 1, T> lk(0.5);
+	Matrix<M, 1, T> sk = pdipStartSlacks<MS>(Mx, cx, tk, T(0.5));
+
+	pdip<S, IT, mrmax, MS, A, inexact>(H, h, Mx, cx, tol, criteria, result, tk, lk, sk);
+
 	return tk;
 }
+
+/*!
+@brief  Overloaded function provided by convenience. Runs exactly IT iterations, without exit criteria nor statistics.
+*/
+template<Solvers S = MINRES, int IT, int mrmax, MxStructure MS = MX_DENSE, PdipAlgorithm A = PDIP_FIXED_CENTERING, bool inexact = false, int N, int M, int P, typename T = float>
+Matrix<N,1,T> pdip(const Matrix<N,N,T> &H, const Matrix<N,P,T> &h, const Matrix<M,N,T> &Mx, const Matrix<M,1,T> &cx, T tol)
+{
+	const PdipCriteria<T> criteria = {0, 0, 0};
+	PdipResult<T> result;
+
+	return pdip<S, IT, mrmax, MS, A, inexact>(H, h, Mx, cx, tol, criteria, result);
+}
@@ -0,0 +1,359 @@
+#pragma once
+
+#include <limits>
+
+#include "Matrix.hpp"
+#include "lanes.hpp"
+#include "lschol.hpp"
+#include "mx_ops.hpp"
+#include "pdip.hpp"
+
+/*!
+@file   pdip_batch.hpp
+@brief  pdip over K independent QPs sharing H and Mx, solved in lockstep with one problem per lane (see lanes.hpp).
+*/
+
+/*!
+@brief  Computes A*x for a matrix shared by every lane and a batch of vectors
+*/
+template<int N, int M, int P, int K, typename T>
+Matrix<N,P,Lanes<K,T>> laneMul(const Matrix<N,M,T> &A, const Matrix<M,P,Lanes<K,T>> &x)
+{
+	Matrix<N,P,Lanes<K,T>> res;
+
+	for(int i = 0; i < N; ++i)
+	{
+		for(int j = 0; j < P; ++j)
+		{
+			Lanes<K,T> sum = A(i,0) * x(0,j);
+
+			for(int k = 1; k < M; ++k)
+			{
+				sum += A(i,k) * x(k,j);
+			}
+
+			res(i,j) = sum;
+		}
+	}
+
+	return res;
+}
+
+/*!
+@brief  Products against a constraints matrix shared by every lane, specialised on the structure of Mx as MxOps.
+@tparam structure   Structure of Mx
+@tparam V   Number of constraints, rows of Mx
+@tparam N   Number of optimization values, columns of Mx
+@tparam K   Number of lanes
+@tparam T   Data type
+*/
+template<MxStructure structure, int V, int N, int K, typename T = float>
+struct MxLaneOps
+{ };
+
+template<int V, int N, int K, typename T>
+struct MxLaneOps<MX_DENSE, V, N, K, T>
+{
+	using LT = Lanes<K,T>;
+
+	static Matrix<V,1,LT> mul(const Matrix<V,N,T> &Mx, const Matrix<N,1,LT> &x)
+	{
+		return laneMul(Mx, x);
+	}
+
+	static Matrix<N,1,LT> multTr(const Matrix<V,N,T> &Mx, const Matrix<V,1,LT> &v)
+	{
+		Matrix<N,1,LT> res(LT(0));
+
+		for(int k = 0; k < V; ++k)
+		{
+			for(int i = 0; i < N; ++i)
+			{
+				res(i,0) += Mx(k,i) * v(k,0);
+			}
+		}
+
+		return res;
+	}
+
+	static Matrix<N,N,LT> addScaledGram(const Matrix<N,N,T> &H, const Matrix<V,N,T> &Mx, const Matrix<V,1,LT> &d)
+	{
+		Matrix<N,N,LT> res;
+
+		for(int i = 0; i < N; ++i)
+		{
+			for(int j = 0; j <= i; ++j)
+			{
+				LT sum = Mx(0,i) * d(0,0) * Mx(0,j);
+
+				for(int k = 1; k < V; ++k)
+				{
+					sum += Mx(k,i) * d(k,0) * Mx(k,j);
+				}
+
+				res(i,j) = H(i,j) + sum;
+				res(j,i) = res(i,j);
+			}
+		}
+
+		return res;
+	}
+};
+
+template<int V, int N, int K, typename T>
+struct MxLaneOps<MX_BOX, V, N, K, T>
+{
+	static_assert(V == 2*N, "Box constraints require Mx = [I; -I]");
+
+	using LT = Lanes<K,T>;
+
+	static Matrix<V,1,LT> mul(const Matrix<V,N,T>&, const Matrix<N,1,LT> &x)
+	{
+		Matrix<V,1,LT> res;
+
+		for(int i = 0; i < N; ++i)
+		{
+			res(i,0) = x(i,0);
+			res(i+N,0) = -x(i,0);
+		}
+
+		return res;
+	}
+
+	static Matrix<N,1,LT> multTr(const Matrix<V,N,T>&, const Matrix<V,1,LT> &v)
+	{
+		Matrix<N,1,LT> res;
+
+		for(int i = 0; i < N; ++i)
+		{
+			res(i,0) = v(i,0) - v(i+N,0);
+		}
+
+		return res;
+	}
+
+	static Matrix<N,N,LT> addScaledGram(const Matrix<N,N,T> &H, const Matrix<V,N,T>&, const Matrix<V,1,LT> &d)
+	{
+		Matrix<N,N,LT> res = H.template cast<LT>();
+
+		for(int i = 0; i < N; ++i)
+		{
+			res(i,i) += d(i,0) + d(i+N,0);
+		}
+
+		return res;
+	}
+};
+
+/*!
+@brief  Per-lane version of computeAlp. The branch is replaced by a lane select.
+*/
+template<int N, int K, typename T>
+Lanes<K,T> computeAlp(const Matrix<N,1,Lanes<K,T>> &delta, const Matrix<N,1,Lanes<K,T>> &k, T bt = T(0.99999))
+{
+	Lanes<K,T> alp = 1;
+
+	for(int elem = 0; elem < N; elem++)
+	{
+		Lanes<K,T> ratio = -delta(elem,0) / k(elem,0);
+		alp = select(delta(elem,0) < 0 && ratio > alp, ratio, alp);
+	}
+
+	return Lanes<K,T>(bt) / alp;
+}
+
+/*!
+@brief  Per-lane maximum absolute value of a batch of vectors
+*/
+template<int N, int K, typename T>
+Lanes<K,T> laneMaxAbs(const Matrix<N,1,Lanes<K,T>> &v)
+{
+	Lanes<K,T> res = 0;
+
+	for(int i = 0; i < N; ++i)
+	{
+		Lanes<K,T> a = fabs(v(i,0));
+		res = select(a > res, a, res);
+	}
+
+	return res;
+}
+
+/*!
+@brief  Computes the search direction of every lane from the factorized Newton systems. See pdipDirection.
+*/
+template<MxStructure MS, int N, int M, int K, typename T>
+void pdipBatchDirection
+(
+	const LdlFactor<N,Lanes<K,T>> &F, const Matrix<M,N,T> &Mx,
+	const Matrix<M,1,Lanes<K,T>> &lk, const Matrix<M,1,Lanes<K,T>> &sk,
+	const Matrix<N,1,Lanes<K,T>> &HK, const Matrix<M,1,Lanes<K,T>> &GK, const Matrix<M,1,Lanes<K,T>> &TK,
+	Matrix<N,1,Lanes<K,T>> &zk, Matrix<M,1,Lanes<K,T>> &Dlk, Matrix<M,1,Lanes<K,T>> &Dsk
+)
+{
+	using Ops = MxLaneOps<MS, M, N, K, T>;
+
+	Matrix<N,1,Lanes<K,T>> bk = HK + Ops::multTr(Mx, (lk.emulCopy(GK) - TK).edivCopy(sk));
+
+	lscholSolve(F, bk, zk);
+
+	Dsk = GK - Ops::mul(Mx, zk);
+	Dlk = (TK - lk.emulCopy(Dsk)).edivCopy(sk);
+}
+
+/*!
+@brief  Batched Primal-Dual Interior-Point method. Solves K QPs with the same H and Mx and per-lane h and cx,
+        min 0.5 tk'*H*tk + h'*tk s.t. Mx*tk <= cx, running the iterations of every lane in lockstep.
+        Newton systems are solved by LDL' factorization, the only inner solver without data-dependent branches.
+        Lanes meeting the exit criteria are masked: their iterates and statistics are frozen while the remaining
+        lanes iterate. The loop stops once every lane has exited.
+
+@tparam IT  Maximum of iterations
+@tparam A   Search direction strategy
+@tparam MS  Structure of Mx
+@tparam N   Number of optimization values
+@tparam M   Number of constraints
+@tparam K   Number of lanes
+@tparam T   Data type
+@param  H   NxN cost matrix, shared
+@param  h   Nx1 cost vector of every lane
+@param  Mx  MxN constraints matrix, shared
+@param  cx  Mx1 constraints vector of every lane
+@param  criteria    Early exit criteria, checked per lane before every iteration and on the final iterates
+@param  result  Statistics and exit status of every lane
+@param  tk  Starting point of every lane. Updated with the solutions
+@param  lk  Starting multipliers of every lane, must be positive. Updated with the final iterates
+@param  sk  Starting slacks of every lane, must be positive. Updated with the final iterates
+*/
+template<int IT, PdipAlgorithm A = PDIP_FIXED_CENTERING, MxStructure MS = MX_DENSE, int N, int M, int K, typename T>
+void pdipBatch
+(
+	const Matrix<N,N,T> &H, const Matrix<N,1,Lanes<K,T>> &h, const Matrix<M,N,T> &Mx, const Matrix<M,1,Lanes<K,T>> &cx,
+	const PdipCriteria<T> &criteria, PdipResult<T> (&result)[K],
+	Matrix<N,1,Lanes<K,T>> &tk, Matrix<M,1,Lanes<K,T>> &lk, Matrix<M,1,Lanes<K,T>> &sk
+)
+{
+	using LT = Lanes<K,T>;
+	using Ops = MxLaneOps<MS, M, N, K, T>;
+
+	Matrix<M, 1, LT> em(1.0);
+	LT sgk = 0.5;
+	const LT lk_min = std::numeric_limits<T>::min();
+
+	LaneMask<K> active;
+
+	for(int i = 0; i < K; ++i)
+	{
+		active.m[i] = true;
+		result[i].status = PDIP_MAX_ITER;
+		result[i].inner_iterations = 0;
+		result[i].iterations = IT;
+	}
+
+	// One pass more than IT evaluates the final iterates, see pdip
+
+	for(int k = 0; k <= IT; k++)
+	{
+		// Build bk
+
+		LT muk = lk.dot(sk) / M;
+		Matrix<N, 1, LT> HK = -(laneMul(H, tk) + h + Ops::multTr(Mx, lk));
+		Matrix<M, 1, LT> GK = cx - sk - Ops::mul(Mx, tk);
+
+		// Check exit criteria per lane
+
+		LT res_d = laneMaxAbs(HK);
+		LT res_p = laneMaxAbs(GK);
+		LT residual = select(res_d > res_p, res_d, res_p);
+		LT dual = laneMaxAbs(lk);
+
+		for(int i = 0; i < K; ++i)
+		{
+			if(!active[i])
+			{
+				continue;
+			}
+
+			result[i].gap = muk[i];
+			result[i].residual = residual[i];
+			result[i].status = pdipExitStatus(criteria, muk[i], residual[i], res_p[i], dual[i]);
+
+			if(result[i].status != PDIP_MAX_ITER || k == IT)
+			{
+				result[i].iterations = k;
+				active.m[i] = false;
+			}
+		}
+
+		if(!active.any())
+		{
+			break;
+		}
+
+		// Build Ak
+
+		Matrix<M, 1, LT> rk = lk.edivCopy(sk);
+		Matrix<N, N, LT> Ak = Ops::addScaledGram(H, Mx, rk);
+
+		LdlFactor<N, LT> F;
+		lscholFactor(Ak, F);
+
+		Matrix<N, 1, LT> zk;
+		Matrix<M, 1, LT> Dlk, Dsk;
+		Matrix<M, 1, LT> LS = lk.emulCopy(sk);
+		Matrix<M, 1, LT> TK;
+
+		if(A == PDIP_MEHROTRA)
+		{
+			TK = -LS;
+			pdipBatchDirection<MS>(F, Mx, lk, sk, HK, GK, TK, zk, Dlk, Dsk);
+
+			LT alp_p = computeAlp(Dsk, sk, T(1));
+			LT alp_d = computeAlp(Dlk, lk, T(1));
+			LT mu_aff = (lk + Dlk * alp_d).dot(sk + Dsk * alp_p) / M;
+			LT ratio = mu_aff / muk;
+
+			sgk = ratio * ratio * ratio;
+			sgk = select(sgk < LT(1), sgk, LT(1));
+			sgk = select(sgk > LT(0), sgk, LT(0));
+			TK = em * sgk * muk - LS - Dlk.emulCopy(Dsk);
+		}
+		else
+		{
+			TK = em * sgk * muk - LS;
+		}
+
+		pdipBatchDirection<MS>(F, Mx, lk, sk, HK, GK, TK, zk, Dlk, Dsk);
+
+		// Update the lanes that did not exit yet. Mehrotra steps the primal and dual sides by separate lengths, see pdip
+
+		LT alp_p, alp_d;
+
+		if(A == PDIP_MEHROTRA)
+		{
+			alp_p = computeAlp(Dsk, sk);
+			alp_d = computeAlp(Dlk, lk);
+		}
+		else
+		{
+			LT alp_lk = computeAlp(Dlk, lk);
+			LT alp_sk = computeAlp(Dsk, sk);
+			alp_p = select(alp_lk > alp_sk, alp_sk, alp_lk);
+			alp_d = alp_p;
+		}
+
+		for(int i = 0; i < N; ++i)
+		{
+			tk(i,0) = select(active, tk(i,0) + zk(i,0) * alp_p, tk(i,0));
+		}
+
+		for(int i = 0; i < M; ++i)
+		{
+			LT l = lk(i,0) + Dlk(i,0) * alp_d;
+			LT s = sk(i,0) + Dsk(i,0) * alp_p;
+
+			lk(i,0) = select(active, select(l < lk_min, lk_min, l), lk(i,0));
+			sk(i,0) = select(active, select(s < lk_min, lk_min, s), sk(i,0));
+		}
+	}
+}
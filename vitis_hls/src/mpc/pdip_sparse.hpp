@@ -0,0 +1,245 @@
+#pragma once
+
+#include <limits>
+
+#include "Matrix.hpp"
+#include "pdip.hpp"
+#include "sparse_kkt.hpp"
+
+/*!
+@file   pdip_sparse.hpp
+@brief  pdip for the sparse MPC formulation of sparse_kkt.hpp. Same iterations as pdip, with the dynamics as equality
+        constraints and box bounds on the decision values, so the Newton system keeps its stage structure.
+*/
+
+/*!
+@brief  Computes the search direction from an already factorized KKT system. Upper and lower bounds are the rows
+        +I and -I of the constraints matrix of pdip, so every product against it is element-wise.
+@param  HK  Dual residual, -(H*z + C'*v + lu - ll)
+@param  EK  Dynamics residual, b - C*z
+@param  GU  Upper bounds residual, hi - su - z
+@param  GL  Lower bounds residual, z - lo - sl
+@param  TU  Complementarity target minus lu.*su
+@param  TL  Complementarity target minus ll.*sl
+*/
+template<Solvers S, int L, int N, int M, typename T>
+void pdipSparseDirection
+(
+	const Matrix<N,N,T> &A, const Matrix<N,M,T> &B, const typename SparseKkt<S,N,M,L,T>::Factor &F,
+	const Matrix<L*(N+M),1,T> &box,
+	const Matrix<L*(N+M),1,T> &lu, const Matrix<L*(N+M),1,T> &su,
+	const Matrix<L*(N+M),1,T> &ll, const Matrix<L*(N+M),1,T> &sl,
+	const Matrix<L*(N+M),1,T> &HK, const Matrix<L*N,1,T> &EK,
+	const Matrix<L*(N+M),1,T> &GU, const Matrix<L*(N+M),1,T> &GL,
+	const Matrix<L*(N+M),1,T> &TU, const Matrix<L*(N+M),1,T> &TL,
+	Matrix<L*(N+M),1,T> &dz, Matrix<L*N,1,T> &dv,
+	Matrix<L*(N+M),1,T> &Dlu, Matrix<L*(N+M),1,T> &Dsu,
+	Matrix<L*(N+M),1,T> &Dll, Matrix<L*(N+M),1,T> &Dsl
+)
+{
+	#pragma HLS INLINE
+
+	Matrix<L*(N+M),1,T> r1 = HK + (lu.emulCopy(GU) - TU).edivCopy(su) - (ll.emulCopy(GL) - TL).edivCopy(sl);
+
+	SparseKkt<S,N,M,L,T>::solve(A, B, F, r1, EK, dz, dv);
+
+	Matrix<L*(N+M),1,T> dzb = dz.emulCopy(box);
+
+	Dsu = GU - dzb;
+	Dsl = GL + dzb;
+	Dlu = (TU - lu.emulCopy(Dsu)).edivCopy(su);
+	Dll = (TL - ll.emulCopy(Dsl)).edivCopy(sl);
+}
+
+/*!
+@brief  Primal-Dual Interior-Point method for the sparse MPC QP:
+                    min 0.5 z'*blkdiag(R, Q, ..., R, P)*z
+                    s.t     C*z  = b
+                            lo <= z <= hi, for the decision values selected by box
+        Exit criteria as pdip, except for the dual residual, which is scaled by 1 + max|H*z|.
+
+@tparam S   KKT solver, see SparseKkt
+@tparam L   Prediction horizon
+@tparam IT  Maximum of iterations for the main algorithm
+@tparam Alg Search direction strategy
+@tparam N   Number of states
+@tparam M   Number of inputs
+@tparam T   Data type
+@param  x0  Initial state of the dynamics
+@param  lo  Lower bounds of the decision values
+@param  hi  Upper bounds of the decision values
+@param  box 1 for the decision values with bounds, 0 for the free ones
+@param  criteria    Early exit criteria, checked before every iteration and on the final iterate
+@param  result  Iteration count, final gap and exit status
+@param  z   Starting point for the decision values. Updated with the solution
+@param  v   Starting point for the dynamics multipliers. Updated with the final iterate
+@param  lu  Multipliers of the upper bounds. Must be positive on bounded values, 0 on free ones
+@param  su  Slacks of the upper bounds. Must be positive on bounded values, 1 on free ones
+@param  ll  Multipliers of the lower bounds, as lu
+@param  sl  Slacks of the lower bounds, as su
+*/
+template<Solvers S = CHOLESKY, int L, int IT, PdipAlgorithm Alg = PDIP_FIXED_CENTERING, int N, int M, typename T = float>
+void pdipSparse
+(
+	const Matrix<N,N,T> &A, const Matrix<N,M,T> &B,
+	const Matrix<N,N,T> &Q, const Matrix<M,M,T> &R, const Matrix<N,N,T> &P,
+	const Matrix<N,1,T> &x0,
+	const Matrix<L*(N+M),1,T> &lo, const Matrix<L*(N+M),1,T> &hi, const Matrix<L*(N+M),1,T> &box,
+	const PdipCriteria<T> &criteria, PdipResult<T> &result,
+	Matrix<L*(N+M),1,T> &z, Matrix<L*N,1,T> &v,
+	Matrix<L*(N+M),1,T> &lu, Matrix<L*(N+M),1,T> &su,
+	Matrix<L*(N+M),1,T> &ll, Matrix<L*(N+M),1,T> &sl
+)
+{
+	using Kkt = SparseKkt<S,N,M,L,T>;
+	constexpr int Z = L*(N+M);
+
+	const T lk_min = std::numeric_limits<T>::min();
+
+	// Every bounded value adds two inequalities
+
+	T V = 0;
+
+	for(int i = 0; i < Z; ++i)
+	{
+		V += 2 * box(i,0);
+	}
+
+	V = V > 0 ? V : T(1);
+
+	// Right-hand side of the dynamics, only the first stage depends on x0
+
+	Matrix<L*N,1,T> b(T(0));
+	Matrix<N,1,T> Ax0 = A * x0;
+
+	for(int i = 0; i < N; ++i)
+	{
+		b(i,0) = Ax0(i,0);
+	}
+
+	T sgk = 0.5;
+
+	result.status = PDIP_MAX_ITER;
+	result.inner_iterations = 0;
+
+	int k;
+
+	// One pass more than IT evaluates the final iterate, see pdip
+
+	for(k = 0; k <= IT; ++k)
+	{
+		// Residuals
+
+		T muk = (lu.dot(su) + ll.dot(sl))/V;
+		Matrix<Z,1,T> Hz = sparseCostMul<N,M,L>(Q, R, P, z);
+		Matrix<Z,1,T> HK = (Hz + sparseDynamicsMultTr<N,M,L>(A, B, v) + lu - ll) * -1;
+		Matrix<L*N,1,T> EK = b - sparseDynamicsMul<N,M,L>(A, B, z);
+		Matrix<Z,1,T> GU = (hi - su - z).emulCopy(box);
+		Matrix<Z,1,T> GL = (z - lo - sl).emulCopy(box);
+
+		// Check exit criteria. The state rows of HK carry the state weights times the states, which can be orders of
+		// magnitude above the input terms, so the rounding of H*z alone can exceed an absolute tolerance
+
+		T res_d = HK.maxAbs() / (Hz.maxAbs() + 1);
+		T res_e = EK.maxAbs();
+		T res_u = GU.maxAbs();
+		T res_l = GL.maxAbs();
+		T res_p = res_u > res_l ? res_u : res_l;
+		res_p = res_p > res_e ? res_p : res_e;
+
+		T dual = lu.maxAbs() > ll.maxAbs() ? lu.maxAbs() : ll.maxAbs();
+
+		result.gap = muk;
+		result.residual = res_d > res_p ? res_d : res_p;
+		result.status = pdipExitStatus(criteria, muk, result.residual, res_p, dual);
+
+		if(result.status != PDIP_MAX_ITER || k == IT)
+		{
+			break;
+		}
+
+		// Factorize the KKT system
+
+		Matrix<Z,1,T> sigma = lu.edivCopy(su) + ll.edivCopy(sl);
+		typename Kkt::Factor F;
+
+		Kkt::factor(A, B, Q, R, P, sigma, F);
+
+		Matrix<Z,1,T> dz, Dlu, Dsu, Dll, Dsl;
+		Matrix<L*N,1,T> dv;
+		Matrix<Z,1,T> LSU = lu.emulCopy(su);
+		Matrix<Z,1,T> LSL = ll.emulCopy(sl);
+		Matrix<Z,1,T> TU, TL;
+
+		if(Alg == PDIP_MEHROTRA)
+		{
+			// Predictor: affine scaling direction, sgk = 0
+
+			TU = LSU * -1;
+			TL = LSL * -1;
+			pdipSparseDirection<S,L>(A, B, F, box, lu, su, ll, sl, HK, EK, GU, GL, TU, TL, dz, dv, Dlu, Dsu, Dll, Dsl);
+
+			T alp_p = computeAlp(Dsu, su, T(1));
+			T alp_d = computeAlp(Dlu, lu, T(1));
+			T alp_k = computeAlp(Dsl, sl, T(1));
+			alp_p = alp_k < alp_p ? alp_k : alp_p;
+			alp_k = computeAlp(Dll, ll, T(1));
+			alp_d = alp_k < alp_d ? alp_k : alp_d;
+
+			T mu_aff = ((lu + Dlu * alp_d).dot(su + Dsu * alp_p) + (ll + Dll * alp_d).dot(sl + Dsl * alp_p))/V;
+			T ratio = mu_aff / muk;
+
+			// Corrector: adaptive centering plus second order term, see pdip
+
+			sgk = ratio * ratio * ratio;
+			sgk = sgk < 1 ? sgk : T(1);
+			sgk = sgk > 0 ? sgk : T(0);
+			TU = box * (sgk * muk) - LSU - Dlu.emulCopy(Dsu);
+			TL = box * (sgk * muk) - LSL - Dll.emulCopy(Dsl);
+		}
+		else
+		{
+			TU = box * (sgk * muk) - LSU;
+			TL = box * (sgk * muk) - LSL;
+		}
+
+		pdipSparseDirection<S,L>(A, B, F, box, lu, su, ll, sl, HK, EK, GU, GL, TU, TL, dz, dv, Dlu, Dsu, Dll, Dsl);
+
+		// Find max ak in (0,1]. Mehrotra steps z and the slacks, and the multipliers, by separate lengths, see pdip
+
+		T alp_p = computeAlp(Dsu, su);
+		T alp_d = computeAlp(Dlu, lu);
+		T alp_k = computeAlp(Dsl, sl);
+		alp_p = alp_k < alp_p ? alp_k : alp_p;
+		alp_k = computeAlp(Dll, ll);
+		alp_d = alp_k < alp_d ? alp_k : alp_d;
+
+		if(Alg != PDIP_MEHROTRA)
+		{
+			alp_p = alp_d < alp_p ? alp_d : alp_p;
+			alp_d = alp_p;
+		}
+
+		z += dz * alp_p;
+		su += Dsu * alp_p;
+		sl += Dsl * alp_p;
+		v += dv * alp_d;
+		lu += Dlu * alp_d;
+		ll += Dll * alp_d;
+
+		// Keep the iterates of the bounded values strictly positive
+
+		for(int i = 0; i < Z; ++i)
+		{
+			if(box(i,0) != 0)
+			{
+				lu(i,0) = lu(i,0) < lk_min ? lk_min : lu(i,0);
+				su(i,0) = su(i,0) < lk_min ? lk_min : su(i,0);
+				ll(i,0) = ll(i,0) < lk_min ? lk_min : ll(i,0);
+				sl(i,0) = sl(i,0) < lk_min ? lk_min : sl(i,0);
+			}
+		}
+	}
+
+	result.iterations = k;
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "Matrix.hpp"
+#include "lschol.hpp"
+
+/*!
+@file   precond.hpp
+@brief  Preconditioners for the Krylov inner solvers, pminres and pcgrad. Each one approximates A by a matrix Mp whose
+        systems are cheap to solve, factor() builds it once per Newton system and apply() computes z = Mp^-1 * r.
+*/
+
+// Number of subdiagonals kept by the incomplete Cholesky preconditioner
+#ifndef PRECOND_ICHOL_BAND
+#define PRECOND_ICHOL_BAND 4
+#endif
+
+/*! Available preconditioners */
+enum Preconditioners
+{
+	PRECOND_JACOBI,     /*!< Diagonal of A */
+	PRECOND_ICHOL       /*!< Incomplete LDL' restricted to a band of PRECOND_ICHOL_BAND subdiagonals */
+};
+
+/*!
+@brief  Preconditioner selection
+@tparam P   Preconditioner
+@tparam N   Size of the system
+@tparam T   Data type
+*/
+template<Preconditioners P, int N, typename T = float>
+struct Preconditioner
+{ };
+
+/*!
+@brief  Jacobi preconditioner, Mp = diag(A). Rescales the rows of Ak that the barrier terms lk/sk blow up near the
+        boundary of the feasible set.
+*/
+template<int N, typename T>
+struct Preconditioner<PRECOND_JACOBI, N, T>
+{
+	//! Inverse of the diagonal of A
+	using Factor = Matrix<N,1,T>;
+
+	static void factor(const Matrix<N,N,T> &A, Factor &F)
+	{
+		for(int i = 0; i < N; ++i)
+		{
+			F(i,0) = 1 / A(i,i);
+		}
+	}
+
+	static void apply(const Factor &F, const Matrix<N,1,T> &r, Matrix<N,1,T> &z)
+	{
+		#pragma HLS INLINE
+		z = r.emulCopy(F);
+	}
+};
+
+/*!
+@brief  Incomplete Cholesky preconditioner. LDL' of A with every element further than band positions from the diagonal
+        dropped, so the factorization costs O(N*band^2) and each apply O(N*band) instead of O(N^3) and O(N^2). The
+        dropped elements can make a pivot vanish, then A + alpha*diag(A) is factorized instead, with alpha growing
+        tenfold from 1e-3 up to 100 (Manteuffel shift), and a Jacobi factor if even that breaks down. With band >= N-1
+        and no shift it is the exact factorization and the Krylov solvers converge in one iteration.
+*/
+template<int N, typename T>
+struct Preconditioner<PRECOND_ICHOL, N, T>
+{
+	static constexpr int band = PRECOND_ICHOL_BAND < N-1 ? PRECOND_ICHOL_BAND : N-1;
+	//! Factorization attempts: unshifted, then alpha = 1e-3, 1e-2, ..., 100
+	static constexpr int shifts = 7;
+
+	//! Only the elements of L within the band are valid
+	using Factor = LdlFactor<N,T>;
+
+	static void factor(const Matrix<N,N,T> &A, Factor &F)
+	{
+		T alpha = 0;
+
+		for(int k = 0; k < shifts; ++k)
+		{
+			if(factorShifted(A, alpha, F))
+			{
+				return;
+			}
+
+			alpha = k == 0 ? T(1e-3) : alpha * 10;
+		}
+
+		for(int j = 0; j < N; ++j)
+		{
+			F.D(j,0) = A(j,j);
+
+			for(int i = j+1; i <= j + band && i < N; ++i)
+			{
+				F.L(i,j) = 0;
+			}
+		}
+	}
+
+	static void apply(const Factor &F, const Matrix<N,1,T> &r, Matrix<N,1,T> &z)
+	{
+		// Forward substitution, L*y = r, then z = D^-1*y
+
+		for(int i = 0; i < N; ++i)
+		{
+			T sum = r(i,0);
+
+			for(int k = i - band < 0 ? 0 : i - band; k < i; ++k)
+			{
+				sum -= F.L(i,k) * z(k,0);
+			}
+
+			z(i,0) = sum;
+		}
+
+		for(int i = 0; i < N; ++i)
+		{
+			z(i,0) /= F.D(i,0);
+		}
+
+		// Backward substitution, L'*z = D^-1*y
+
+		for(int i = N-1; i >= 0; --i)
+		{
+			T sum = z(i,0);
+
+			for(int k = i+1; k <= i + band && k < N; ++k)
+			{
+				sum -= F.L(k,i) * z(k,0);
+			}
+
+			z(i,0) = sum;
+		}
+	}
+
+private:
+	//! Banded LDL' of A + alpha*diag(A). false if a pivot falls below 1e-4 of its diagonal element
+	static bool factorShifted(const Matrix<N,N,T> &A, T alpha, Factor &F)
+	{
+		for(int j = 0; j < N; ++j)
+		{
+			T a = A(j,j) * (1 + alpha);
+			T d = a;
+
+			for(int k = j - band < 0 ? 0 : j - band; k < j; ++k)
+			{
+				d -= F.L(j,k) * F.L(j,k) * F.D(k,0);
+			}
+
+			if(!(d > a * T(1e-4)))
+			{
+				return false;
+			}
+
+			F.D(j,0) = d;
+
+			for(int i = j+1; i <= j + band && i < N; ++i)
+			{
+				T sum = A(i,j);
+
+				for(int k = i - band < 0 ? 0 : i - band; k < j; ++k)
+				{
+					sum -= F.L(i,k) * F.L(j,k) * F.D(k,0);
+				}
+
+				F.L(i,j) = sum / d;
+			}
+		}
+
+		return true;
+	}
+};
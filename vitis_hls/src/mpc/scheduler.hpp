@@ -0,0 +1,352 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/*!
+@file   scheduler.hpp
+@brief  Host runtime running thousands of periodic tasks, e.g. one MpcController step per motor, on a thread pool.
+        Not synthesizable.
+*/
+
+/*!
+@brief  Work-stealing deque holding a contiguous range of task indices. Top and bottom are packed in one atomic word,
+        so the owner pops from the bottom and thieves take the upper half from the top with a single CAS each.
+*/
+class RangeDeque
+{
+public:
+	RangeDeque() : m_range(0) { }
+
+	/*!
+	@brief  Replaces the content by [begin, end). Only called by the owner on an empty deque, or while no one steals
+	*/
+	void reset(uint32_t begin, uint32_t end)
+	{
+		m_range.store(pack(begin, end), std::memory_order_release);
+	}
+
+	/*!
+	@brief  Owner side. Takes the last index
+	@return false if the deque is empty
+	*/
+	bool pop(uint32_t &index)
+	{
+		uint64_t range = m_range.load(std::memory_order_acquire);
+
+		while(top(range) < bottom(range))
+		{
+			if(m_range.compare_exchange_weak(range, pack(top(range), bottom(range) - 1), std::memory_order_acq_rel))
+			{
+				index = bottom(range) - 1;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/*!
+	@brief  Thief side. Takes the first half of the remaining indices, rounded up
+	@return false if the deque is empty
+	*/
+	bool steal(uint32_t &begin, uint32_t &end)
+	{
+		uint64_t range = m_range.load(std::memory_order_acquire);
+
+		while(top(range) < bottom(range))
+		{
+			uint32_t half = (bottom(range) - top(range) + 1) / 2;
+
+			if(m_range.compare_exchange_weak(range, pack(top(range) + half, bottom(range)), std::memory_order_acq_rel))
+			{
+				begin = top(range);
+				end = top(range) + half;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+private:
+	static uint64_t pack(uint32_t top, uint32_t bottom) { return (uint64_t(top) << 32) | bottom; }
+	static uint32_t top(uint64_t range) { return uint32_t(range >> 32); }
+	static uint32_t bottom(uint64_t range) { return uint32_t(range); }
+
+	std::atomic<uint64_t> m_range;
+};
+
+//! Load of one worker thread
+struct WorkerStats
+{
+	int cpu;            //!< CPU the worker is pinned to, -1 if not pinned
+	long jobs;          //!< Tasks run
+	long steals;        //!< Successful steals
+	double busy_ns;     //!< Time spent inside tasks
+};
+
+//! Statistics of PeriodicScheduler::run
+struct SchedulerStats
+{
+	long periods;           //!< Periods released
+	long jobs;              //!< Tasks run, tasks * periods
+	long missed;            //!< Tasks completed after the end of their period
+	long overruns;          //!< Periods whose last task completed after the end of the period
+	double max_latency_ns;  //!< Worst completion time of a task, measured from the nominal start of its period, the clock
+	                        //!< of the deadline: it exceeds the period whenever a task is missed
+	double elapsed_ns;      //!< Wall time of the run
+	std::vector<WorkerStats> workers;
+};
+
+/*!
+@brief  Releases every task once per period on a fixed pool of worker threads. Tasks are sharded in contiguous
+        ranges, one per worker, and idle workers steal from the others, so uneven solve times are balanced within
+        the period. The deadline of a task is the nominal end of its period. A period that overruns delays the next one,
+        as a task never runs twice at once: task i of period k+1 always starts after task i of period k.
+*/
+class PeriodicScheduler
+{
+	typedef std::chrono::steady_clock Clock;
+
+public:
+	/*!
+	@param  tasks   Number of tasks released every period
+	@param  workers Number of worker threads
+	@param  period  Sample period
+	@param  pin     Pin worker w to CPU w modulo the number of CPUs (Linux only)
+	*/
+	PeriodicScheduler(int tasks, int workers, std::chrono::nanoseconds period, bool pin = true) :
+		m_tasks(tasks), m_workers(workers < 1 ? 1 : workers), m_period(period), m_pin(pin)
+	{ }
+
+	/*!
+	@brief  Runs the periods. Blocks until the last one completes
+	@param  periods Number of periods
+	@param  task    Callable as task(int index), run once per index and period. Different indices run concurrently
+	*/
+	template<typename F>
+	SchedulerStats run(long periods, F task)
+	{
+		std::vector<Shared> shared(m_workers);
+		std::vector<std::thread> threads;
+
+		m_generation = 0;
+		m_stop = false;
+		m_remaining = 0;
+		m_finished = 0;
+
+		SchedulerStats stats = SchedulerStats();
+		stats.workers.resize(m_workers);
+
+		for(int w = 0; w < m_workers; ++w)
+		{
+			threads.emplace_back([this, w, &shared, &stats, &task]() { worker(w, shared, stats.workers[w], task); });
+		}
+
+		const Clock::time_point start = Clock::now();
+
+		for(long k = 0; k < periods; ++k)
+		{
+			std::this_thread::sleep_until(start + k * m_period);
+
+			// Release: deques are only reset while every worker waits for the next generation. Latency and deadline are
+			// both taken from the nominal start of the period, so a late wakeup counts in the latency as in the misses
+
+			m_release = start + k * m_period;
+			m_deadline = start + (k + 1) * m_period;
+
+			for(int w = 0; w < m_workers; ++w)
+			{
+				shared[w].deque.reset(uint32_t(long(m_tasks) * w / m_workers), uint32_t(long(m_tasks) * (w + 1) / m_workers));
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_remaining = m_tasks;
+				m_finished = 0;
+				++m_generation;
+			}
+
+			m_release_cv.notify_all();
+
+			// Wait for completion
+
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_done_cv.wait(lock, [this]() { return m_finished == m_workers; });
+			}
+
+			stats.periods++;
+			stats.overruns += Clock::now() > m_deadline;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+
+		m_release_cv.notify_all();
+
+		for(auto &t : threads)
+		{
+			t.join();
+		}
+
+		stats.elapsed_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+		for(int w = 0; w < m_workers; ++w)
+		{
+			stats.jobs += stats.workers[w].jobs;
+			stats.missed += shared[w].missed;
+			stats.max_latency_ns = std::max(stats.max_latency_ns, shared[w].max_latency_ns);
+		}
+
+		return stats;
+	}
+
+private:
+	//! Per-worker data touched by other threads, padded to its own cache line
+	struct alignas(64) Shared
+	{
+		Shared() : missed(0), max_latency_ns(0) { }
+
+		RangeDeque deque;
+		long missed;
+		double max_latency_ns;
+	};
+
+	template<typename F>
+	void worker(int w, std::vector<Shared> &shared, WorkerStats &stats, F &task)
+	{
+		stats = WorkerStats();
+		stats.cpu = m_pin ? pin(w) : -1;
+
+		Shared &own = shared[w];
+		long generation = 0;
+
+		while(true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_release_cv.wait(lock, [this, generation]() { return m_stop || m_generation != generation; });
+
+				if(m_stop)
+				{
+					return;
+				}
+
+				generation = m_generation;
+			}
+
+			const Clock::time_point release = m_release;
+			const Clock::time_point deadline = m_deadline;
+			int victim = w;
+			uint32_t index;
+
+			while(m_remaining.load(std::memory_order_acquire) > 0)
+			{
+				if(!own.deque.pop(index))
+				{
+					// Own range exhausted: steal half of the next non-empty deque
+
+					uint32_t begin, end;
+					bool stolen = false;
+
+					for(int i = 1; i < m_workers && !stolen; ++i)
+					{
+						victim = (victim + 1) % m_workers;
+						stolen = victim != w && shared[victim].deque.steal(begin, end);
+					}
+
+					if(!stolen)
+					{
+						std::this_thread::yield();
+						continue;
+					}
+
+					stats.steals++;
+					own.deque.reset(begin, end);
+					continue;
+				}
+
+				const Clock::time_point t0 = Clock::now();
+				task(int(index));
+				const Clock::time_point t1 = Clock::now();
+
+				stats.jobs++;
+				stats.busy_ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+				own.missed += t1 > deadline;
+				own.max_latency_ns = std::max(own.max_latency_ns, std::chrono::duration<double, std::nano>(t1 - release).count());
+
+				m_remaining.fetch_sub(1, std::memory_order_acq_rel);
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				++m_finished;
+			}
+
+			m_done_cv.notify_one();
+		}
+	}
+
+	static int pin(int w)
+	{
+#ifdef __linux__
+		// Worker w goes to the w-th CPU allowed to the process
+
+		cpu_set_t allowed, set;
+
+		if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) == 0)
+		{
+			return -1;
+		}
+
+		int nth = w % CPU_COUNT(&allowed);
+		int cpu = 0;
+
+		for(; cpu < CPU_SETSIZE; ++cpu)
+		{
+			if(CPU_ISSET(cpu, &allowed) && nth-- == 0)
+			{
+				break;
+			}
+		}
+
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+
+		return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0 ? cpu : -1;
+#else
+		(void) w;
+		return -1;
+#endif
+	}
+
+	const int m_tasks;
+	const int m_workers;
+	const std::chrono::nanoseconds m_period;
+	const bool m_pin;
+
+	std::mutex m_mutex;
+	std::condition_variable m_release_cv;
+	std::condition_variable m_done_cv;
+	long m_generation;
+	bool m_stop;
+	int m_finished;
+	Clock::time_point m_release;
+	Clock::time_point m_deadline;
+	std::atomic<long> m_remaining;
+};
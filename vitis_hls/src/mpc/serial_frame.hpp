@@ -0,0 +1,331 @@
+#pragma once
+
+#include <cstdint>
+
+/*!
+@file   serial_frame.hpp
+@brief  Binary framed protocol of the serial link between the host and the board, which replaces the ASCII lines and
+        fixed delays of Serialcmd.py:
+
+            0xA5 0x5A | type u8 | seq u16 | length u16 | payload[length] | crc u16
+
+        Integers are little-endian and the payload floats are written by Matrix::serialize. The CRC-16/CCITT
+        (polynomial 0x1021, initial value 0xFFFF) covers type to payload, and every type has a fixed length: a corrupted or
+        truncated frame is dropped and the parser resynchronises on the next sync bytes, including those it had taken as
+        part of the dropped frame. Every answer carries the sequence number of its request, so the host can keep many
+        requests in flight and still match each answer to its sample.
+
+        FRAME_RESET     host to board, no payload. Resets the controller, answered by FRAME_ACK
+        FRAME_STEP      host to board, x[N] and y_ref[P] when tracking a reference. Answered by FRAME_RESULT
+        FRAME_RESULT    board to host, FrameResult then u[M]
+        FRAME_ACK       board to host, no payload
+
+No heap and no exceptions, so the board application can use it as is.
+*/
+
+#define FRAME_SYNC0 0xA5
+#define FRAME_SYNC1 0x5A
+
+//! Bytes of a frame besides its payload: sync, type, sequence number, length and CRC
+#define FRAME_OVERHEAD 9
+
+//! Largest payload accepted by FrameParser
+#define FRAME_MAX_PAYLOAD 512
+
+//! Bytes of FrameResult in front of u in a FRAME_RESULT payload
+#define FRAME_RESULT_BYTES 8
+
+/*! Kinds of frame */
+enum FrameType
+{
+	FRAME_RESET = 1,
+	FRAME_STEP = 2,
+	FRAME_RESULT = 3,
+	FRAME_ACK = 4
+};
+
+/*! Received frame */
+struct Frame
+{
+	std::uint8_t type;
+	std::uint16_t seq;
+	std::uint16_t length;
+	std::uint8_t payload[FRAME_MAX_PAYLOAD];
+};
+
+/*! Solver report in front of u in a FRAME_RESULT payload */
+struct FrameResult
+{
+	std::uint32_t elapsed;      //!< Time of the control step in board timer ticks
+	std::uint16_t iterations;   //!< QP iterations
+	std::uint8_t status;        //!< PdipStatus
+};
+
+inline void frameStore16(std::uint8_t *p, std::uint16_t v)
+{
+	p[0] = std::uint8_t(v);
+	p[1] = std::uint8_t(v >> 8);
+}
+
+inline void frameStore32(std::uint8_t *p, std::uint32_t v)
+{
+	frameStore16(p, std::uint16_t(v));
+	frameStore16(p + 2, std::uint16_t(v >> 16));
+}
+
+inline std::uint16_t frameLoad16(const std::uint8_t *p)
+{
+	return std::uint16_t(p[0] | (p[1] << 8));
+}
+
+inline std::uint32_t frameLoad32(const std::uint8_t *p)
+{
+	return frameLoad16(p) | (std::uint32_t(frameLoad16(p + 2)) << 16);
+}
+
+/*!
+@brief  CRC-16/CCITT, bitwise so it needs no table on the board
+@param  crc Running value, 0xFFFF for a new frame
+*/
+inline std::uint16_t frameCrc(const std::uint8_t *data, int length, std::uint16_t crc = 0xFFFF)
+{
+	for(int i = 0; i < length; ++i)
+	{
+		crc ^= std::uint16_t(data[i] << 8);
+
+		for(int b = 0; b < 8; ++b)
+		{
+			crc = (crc & 0x8000) ? std::uint16_t((crc << 1) ^ 0x1021) : std::uint16_t(crc << 1);
+		}
+	}
+
+	return crc;
+}
+
+/*!
+@brief  Writes a whole frame
+@param  out Destination of length + FRAME_OVERHEAD bytes
+@return Number of bytes written
+*/
+inline int encodeFrame(std::uint8_t type, std::uint16_t seq, const std::uint8_t *payload, int length, std::uint8_t *out)
+{
+	out[0] = FRAME_SYNC0;
+	out[1] = FRAME_SYNC1;
+	out[2] = type;
+	frameStore16(out + 3, seq);
+	frameStore16(out + 5, std::uint16_t(length));
+
+	for(int i = 0; i < length; ++i)
+	{
+		out[7 + i] = payload[i];
+	}
+
+	frameStore16(out + 7 + length, frameCrc(out + 2, length + 5));
+
+	return length + FRAME_OVERHEAD;
+}
+
+inline void encodeResult(const FrameResult &result, std::uint8_t *payload)
+{
+	frameStore32(payload, result.elapsed);
+	frameStore16(payload + 4, result.iterations);
+	payload[6] = result.status;
+	payload[7] = 0;
+}
+
+inline FrameResult decodeResult(const std::uint8_t *payload)
+{
+	FrameResult result;
+
+	result.elapsed = frameLoad32(payload);
+	result.iterations = frameLoad16(payload + 4);
+	result.status = payload[6];
+
+	return result;
+}
+
+/*!
+@brief  Byte by byte frame decoder for a serial stream. Bytes outside a frame are skipped. A candidate frame whose type
+        is unknown, whose length is not the one of its type or whose CRC is wrong is counted and dropped, and its bytes
+        after the first sync byte are scanned again, so a frame that started inside a corrupted or truncated one is
+        still found. The bytes of the current candidate are kept for that, at most one frame.
+
+The lengths of FRAME_STEP and FRAME_RESULT depend on the sizes of the system and are given to the constructor,
+FRAME_RESET and FRAME_ACK carry no payload. After push returns true, call next until it returns false before pushing
+the following byte: a rescan can complete several frames.
+*/
+class FrameParser
+{
+public:
+	/*!
+	@param  step_bytes      Payload length of FRAME_STEP, 4*(N + P) when tracking a reference and 4*N otherwise
+	@param  result_bytes    Payload length of FRAME_RESULT, FRAME_RESULT_BYTES + 4*M
+	*/
+	FrameParser(int step_bytes, int result_bytes) :
+		m_step_bytes(step_bytes), m_result_bytes(result_bytes), m_start(0), m_head(0), m_tail(0), m_errors(0)
+	{ }
+
+	/*!
+	@brief  Consumes one byte
+	@return true when it completes a valid frame, available in frame() until the next call
+	*/
+	bool push(std::uint8_t byte)
+	{
+		// Only the current candidate is kept, anything before it has been consumed
+
+		if(m_start > 0)
+		{
+			for(int i = m_start; i < m_tail; ++i)
+			{
+				m_bytes[i - m_start] = m_bytes[i];
+			}
+
+			m_head -= m_start;
+			m_tail -= m_start;
+			m_start = 0;
+		}
+
+		if(m_tail == BUFFER_BYTES)
+		{
+			// Only reachable when next was not called until false
+			++m_errors;
+			return next();
+		}
+
+		m_bytes[m_tail++] = byte;
+
+		return next();
+	}
+
+	/*!
+	@brief  Continues with the bytes left to scan again
+	@return true when they complete a valid frame, available in frame() until the next call
+	*/
+	bool next()
+	{
+		while(m_head < m_tail)
+		{
+			if(step())
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	const Frame &frame() const { return m_frame; }
+
+	//! Candidate frames dropped for a wrong type, length or CRC
+	std::uint32_t errors() const { return m_errors; }
+
+	/*!
+	@brief  Payload length of a frame type
+	@return -1 for an unknown type
+	*/
+	int expectedLength(std::uint8_t type) const
+	{
+		switch(type)
+		{
+			case FRAME_RESET: return 0;
+			case FRAME_STEP: return m_step_bytes;
+			case FRAME_RESULT: return m_result_bytes;
+			case FRAME_ACK: return 0;
+			default: return -1;
+		}
+	}
+
+private:
+	static constexpr int BUFFER_BYTES = FRAME_MAX_PAYLOAD + FRAME_OVERHEAD;
+
+	/*!
+	@brief  Scans the byte at m_head as part of the candidate starting at m_start
+	*/
+	bool step()
+	{
+		const std::uint8_t *p = m_bytes + m_start;
+		const int count = ++m_head - m_start;
+
+		if(count == 1)
+		{
+			if(p[0] != FRAME_SYNC0)
+			{
+				m_start = m_head;
+			}
+
+			return false;
+		}
+
+		if(count == 2)
+		{
+			if(p[1] != FRAME_SYNC1)
+			{
+				// Not a frame, the byte may still be the first sync byte of one
+				m_head = m_start = m_start + 1;
+			}
+
+			return false;
+		}
+
+		if(count < 7)
+		{
+			return false;
+		}
+
+		const int length = frameLoad16(p + 5);
+
+		if(count == 7)
+		{
+			const int expected = expectedLength(p[2]);
+
+			if(expected < 0 || length != expected || length > FRAME_MAX_PAYLOAD)
+			{
+				drop();
+			}
+
+			return false;
+		}
+
+		if(count < length + FRAME_OVERHEAD)
+		{
+			return false;
+		}
+
+		if(frameLoad16(p + 7 + length) != frameCrc(p + 2, length + 5))
+		{
+			drop();
+			return false;
+		}
+
+		m_frame.type = p[2];
+		m_frame.seq = frameLoad16(p + 3);
+		m_frame.length = std::uint16_t(length);
+
+		for(int i = 0; i < length; ++i)
+		{
+			m_frame.payload[i] = p[7 + i];
+		}
+
+		m_start = m_head;
+
+		return true;
+	}
+
+	/*!
+	@brief  Drops the candidate and scans its bytes again from the one after its first sync byte
+	*/
+	void drop()
+	{
+		++m_errors;
+		m_head = m_start = m_start + 1;
+	}
+
+	int m_step_bytes;
+	int m_result_bytes;
+	int m_start;    //!< First byte of the current candidate
+	int m_head;     //!< Next byte to scan
+	int m_tail;     //!< End of the bytes received
+	std::uint32_t m_errors;
+	std::uint8_t m_bytes[BUFFER_BYTES];
+	Frame m_frame;
+};
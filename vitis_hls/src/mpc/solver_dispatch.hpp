@@ -4,6 +4,7 @@
 #include "cgrad.hpp"
 #include "lschol.hpp"
 #include "minres.hpp"
+#include "precond.hpp"
 
 /*!
 @file   pdip.hpp
@@ -13,9 +14,30 @@ enum Solvers
 {
 	MINRES,        /*! Minimal Residual method */
 	CGRAD,         /*! Gradient Descent method */
-	CHOLESKY       /*! Cholesky factorization based method */
+	CHOLESKY,      /*! Cholesky factorization based method */
+	EXPLICIT,      /*! Explicit MPC, lookup in a precomputed region table instead of a QP solve. See explicit_mpc.hpp */
+	RICCATI,       /*! Riccati recursion along the horizon. Needs the stages of the sparse formulation, see sparse_kkt.hpp */
+	MINRES_JACOBI, /*! Minimal Residual method with Jacobi preconditioning */
+	MINRES_ICHOL,  /*! Minimal Residual method with incomplete Cholesky preconditioning */
+	CGRAD_JACOBI,  /*! Conjugate gradient with Jacobi preconditioning */
+	CGRAD_ICHOL,   /*! Conjugate gradient with incomplete Cholesky preconditioning */
+	CHOLESKY_MIXED /*! Cholesky factorization in a lower precision type plus iterative refinement. See MixedPrecision */
 };
 
+/*! Placeholder factorization for solvers that work on the system matrix directly */
+struct NoFactor
+{ };
+
+/*!
+@brief  Linear solver selection. Every specialisation provides call(), which solves Ax=b, and the split factor()/solve()
+        pair, which allows to solve several right-hand sides with a single factorization of A. call() and solve() return
+        the iterations of iterative solvers, 0 for direct ones. Their optional iter_cap lowers the iteration limit of
+        iterative solvers at runtime, direct ones ignore it.
+@tparam solver  Solver to use
+@tparam N   Number of equations of the linear system
+@tparam iter_max    Maximum number of iterations for iterative solvers
+@tparam T   Data type
+*/
 template<Solvers solver, int N, int iter_max, typename T = float>
 struct SolverDispatch
 { };
@@ -23,29 +45,194 @@ struct SolverDispatch
 template<int N, int iter_max, typename T>
 struct SolverDispatch<MINRES, N, iter_max, T>
 {
-	static void call(const Matrix<N,N,T> &A, const Matrix<N,1,T> &b, Matrix<N,1,T> &x0, T tolerance, Matrix<N,1,T> &x)
+	static int call(const Matrix<N,N,T> &A, const Matrix<N,1,T> &b, Matrix<N,1,T> &x0, T tolerance, Matrix<N,1,T> &x, int iter_cap = iter_max)
 	{
 		#pragma HLS INLINE
-		minres<iter_max>(A, b, x0, tolerance, x);
+		return minres<iter_max>(A, b, x0, tolerance, x, iter_cap);
+	}
+
+	using Factor = NoFactor;
+
+	static void factor(const Matrix<N,N,T>&, Factor&)
+	{ }
+
+	static int solve(const Matrix<N,N,T> &A, const Factor&, Matrix<N,1,T> &b, Matrix<N,1,T> &x0, T tolerance, Matrix<N,1,T> &x, int iter_cap = iter_max)
+	{
+		#pragma HLS INLINE
+		return minres<iter_max>(A, b, x0, tolerance, x, iter_cap);
 	}
 };
 
 template<int N, int iter_max, typename T>
 struct SolverDispatch<CGRAD, N, iter_max, T>
 {
-	static void call(const Matrix<N,N,T> &A, const Matrix<N,1,T> &b, Matrix<N,1,T> &x0, T tolerance, Matrix<N,1,T> &x)
+	static int call(const Matrix<N,N,T> &A, const Matrix<N,1,T> &b, Matrix<N,1,T> &x0, T tolerance, Matrix<N,1,T> &x, int iter_cap = iter_max)
+	{
+		#pragma HLS INLINE
+		return cgrad<iter_max>(A, b, x0, tolerance, x, iter_cap);
+	}
+
+	using Factor = NoFactor;
+
+	static void factor(const Matrix<N,N,T>&, Factor&)
+	{ }
+
+	static int solve(const Matrix<N,N,T> &A, const Factor&, Matrix<N,1,T> &b, Matrix<N,1,T> &x0, T tolerance, Matrix<N,1,T> &x, int iter_cap = iter_max)
 	{
 		#pragma HLS INLINE
-		cgrad<iter_max>(A, b, x0, tolerance, x);
+		return cgrad<iter_max>(A, b, x0, tolerance, x, iter_cap);
 	}
 };
 
 template<int N, int iter_max, typename T>
 struct SolverDispatch<CHOLESKY, N, iter_max, T>
 {
-	static void call(const Matrix<N,N,T> &A, Matrix<N,1,T> &b, Matrix<N,1,T>&, T, Matrix<N,1,T> &x)
+	static int call(const Matrix<N,N,T> &A, Matrix<N,1,T> &b, Matrix<N,1,T>&, T, Matrix<N,1,T> &x, int = iter_max)
 	{
 		#pragma HLS INLINE
 		lschol(A, b, x);
+		return 0;
+	}
+
+	using Factor = LdlFactor<N,T>;
+
+	static void factor(const Matrix<N,N,T> &A, Factor &F)
+	{
+		#pragma HLS INLINE
+		lscholFactor(A, F);
+	}
+
+	static int solve(const Matrix<N,N,T>&, const Factor &F, Matrix<N,1,T> &b, Matrix<N,1,T>&, T, Matrix<N,1,T> &x, int = iter_max)
+	{
+		#pragma HLS INLINE
+		lscholSolve(F, b, x);
+		return 0;
+	}
+};
+
+/*!
+@brief  Type in which CHOLESKY_MIXED factorizes the systems of a solver in T. float by default, specialise it to factor
+        double systems in a narrow FixedPoint, for instance
+*/
+template<typename T>
+struct MixedPrecision
+{
+	using Low = float;
+};
+
+/*!
+@brief  Mixed precision Cholesky. Ak is factorized in the Low type of MixedPrecision, each solve starts from the Low
+        solution and refines it with residuals computed in T, x += Ak^-1 * (b - A*x), until the residual falls below
+        tolerance times |b|, stops halving, or iter_cap refinement steps are done. With the inexact Newton mode of pdip
+        the early iterations ask for loose tolerances and run on the Low solution alone, and the step that reaches the
+        exit criteria is solved again to tol, so it is refined. Reaches the accuracy of T as long as the condition number
+        of Ak is well below 1/epsilon of Low.
+*/
+template<int N, int iter_max, typename T>
+struct SolverDispatch<CHOLESKY_MIXED, N, iter_max, T>
+{
+	using Low = typename MixedPrecision<T>::Low;
+	using Factor = LdlFactor<N,Low>;
+
+	static void factor(const Matrix<N,N,T> &A, Factor &F)
+	{
+		#pragma HLS INLINE
+		lscholFactor(A.template cast<Low>(), F);
+	}
+
+	static int solve(const Matrix<N,N,T> &A, const Factor &F, const Matrix<N,1,T> &b, Matrix<N,1,T>&, T tolerance, Matrix<N,1,T> &x, int iter_cap = iter_max)
+	{
+		Matrix<N,1,Low> rl = b.template cast<Low>();
+		Matrix<N,1,Low> dl;
+
+		lscholSolve(F, rl, dl);
+		x = dl.template cast<T>();
+
+		const T b_norm = b.maxAbs();
+		T r_old = 0;
+		int i;
+
+		for(i = 0; i < iter_max && i < iter_cap; ++i)
+		{
+			Matrix<N,1,T> r = b - A*x;
+			T r_norm = r.maxAbs();
+
+			if(r_norm <= tolerance * b_norm || (i > 0 && !(r_norm < r_old / 2)))
+			{
+				break;
+			}
+
+			r_old = r_norm;
+			rl = r.template cast<Low>();
+			lscholSolve(F, rl, dl);
+			x += dl.template cast<T>();
+		}
+
+		return i;
+	}
+
+	static int call(const Matrix<N,N,T> &A, const Matrix<N,1,T> &b, Matrix<N,1,T> &x0, T tolerance, Matrix<N,1,T> &x, int iter_cap = iter_max)
+	{
+		#pragma HLS INLINE
+		Factor F;
+
+		factor(A, F);
+		return solve(A, F, b, x0, tolerance, x, iter_cap);
+	}
+};
+
+/*!
+@brief  Preconditioned Krylov solvers. factor() builds the preconditioner, so a Mehrotra iteration builds it once for
+        its two solves.
+@tparam P   Preconditioner
+@tparam cg  true for pcgrad, false for pminres
+*/
+template<Preconditioners P, bool cg, int N, int iter_max, typename T>
+struct PrecondSolverDispatch
+{
+	using Pc = Preconditioner<P,N,T>;
+	using Factor = typename Pc::Factor;
+
+	static void factor(const Matrix<N,N,T> &A, Factor &F)
+	{
+		#pragma HLS INLINE
+		Pc::factor(A, F);
+	}
+
+	static int solve(const Matrix<N,N,T> &A, const Factor &F, const Matrix<N,1,T> &b, Matrix<N,1,T> &x0, T tolerance, Matrix<N,1,T> &x, int iter_cap = iter_max)
+	{
+		#pragma HLS INLINE
+		return cg ? pcgrad<iter_max, Pc>(A, b, x0, tolerance, F, x, iter_cap) : pminres<iter_max, Pc>(A, b, x0, tolerance, F, x, iter_cap);
+	}
+
+	static int call(const Matrix<N,N,T> &A, const Matrix<N,1,T> &b, Matrix<N,1,T> &x0, T tolerance, Matrix<N,1,T> &x, int iter_cap = iter_max)
+	{
+		#pragma HLS INLINE
+		Factor F;
+
+		factor(A, F);
+		return solve(A, F, b, x0, tolerance, x, iter_cap);
 	}
 };
+
+template<int N, int iter_max, typename T>
+struct SolverDispatch<MINRES_JACOBI, N, iter_max, T> : PrecondSolverDispatch<PRECOND_JACOBI, false, N, iter_max, T>
+{ };
+
+template<int N, int iter_max, typename T>
+struct SolverDispatch<MINRES_ICHOL, N, iter_max, T> : PrecondSolverDispatch<PRECOND_ICHOL, false, N, iter_max, T>
+{ };
+
+template<int N, int iter_max, typename T>
+struct SolverDispatch<CGRAD_JACOBI, N, iter_max, T> : PrecondSolverDispatch<PRECOND_JACOBI, true, N, iter_max, T>
+{ };
+
+template<int N, int iter_max, typename T>
+struct SolverDispatch<CGRAD_ICHOL, N, iter_max, T> : PrecondSolverDispatch<PRECOND_ICHOL, true, N, iter_max, T>
+{ };
+
+template<int N, int iter_max, typename T>
+struct SolverDispatch<RICCATI, N, iter_max, T>
+{
+	static_assert(N < 0, "Ak of the condensed problem has no stage structure, use mpc_sparse for RICCATI");
+};
@@ -0,0 +1,480 @@
+#pragma once
+
+#include "Matrix.hpp"
+#include "lschol.hpp"
+#include "solver_dispatch.hpp"
+
+/*!
+@file   sparse_kkt.hpp
+@brief  Newton systems of the sparse MPC formulation. The states are kept as decision values, one stage per step of the
+        horizon, z = [u_0; x_1; u_1; x_2; ...; u_{L-1}; x_L], and the dynamics are equality constraints C*z = b:
+                    x_1 - B*u_0 = A*x_0
+                    x_{k+1} - A*x_k - B*u_k = 0
+        Every interior-point iteration solves the KKT system
+                    [Phi  C'] [dz]   [r1]
+                    [C    0 ] [dv] = [re]
+        where Phi = blkdiag(R + Su_0, Q + Sx_1, ..., R + Su_{L-1}, P + Sx_L) and S are the barrier terms of the bounds.
+*/
+
+/*!
+@brief  Computes H*z for the block diagonal cost blkdiag(R, Q, ..., R, P)
+*/
+template<int N, int M, int L, typename T>
+Matrix<L*(N+M),1,T> sparseCostMul
+(
+	const Matrix<N,N,T> &Q, const Matrix<M,M,T> &R, const Matrix<N,N,T> &P,
+	const Matrix<L*(N+M),1,T> &z
+)
+{
+	constexpr int S = N + M;
+	Matrix<L*(N+M),1,T> res;
+
+	for(int k = 0; k < L; ++k)
+	{
+		const Matrix<N,N,T> &W = k < L-1 ? Q : P;
+
+		for(int i = 0; i < M; ++i)
+		{
+			T sum = 0;
+
+			for(int j = 0; j < M; ++j)
+			{
+				sum += R(i,j) * z(k*S + j, 0);
+			}
+
+			res(k*S + i, 0) = sum;
+		}
+
+		for(int i = 0; i < N; ++i)
+		{
+			T sum = 0;
+
+			for(int j = 0; j < N; ++j)
+			{
+				sum += W(i,j) * z(k*S + M + j, 0);
+			}
+
+			res(k*S + M + i, 0) = sum;
+		}
+	}
+
+	return res;
+}
+
+/*!
+@brief  Computes C*z, the left-hand side of the dynamics
+*/
+template<int N, int M, int L, typename T>
+Matrix<L*N,1,T> sparseDynamicsMul(const Matrix<N,N,T> &A, const Matrix<N,M,T> &B, const Matrix<L*(N+M),1,T> &z)
+{
+	constexpr int S = N + M;
+	Matrix<L*N,1,T> res;
+
+	for(int k = 0; k < L; ++k)
+	{
+		for(int i = 0; i < N; ++i)
+		{
+			T sum = z(k*S + M + i, 0);
+
+			for(int j = 0; j < M; ++j)
+			{
+				sum -= B(i,j) * z(k*S + j, 0);
+			}
+
+			for(int j = 0; j < N && k > 0; ++j)
+			{
+				sum -= A(i,j) * z((k-1)*S + M + j, 0);
+			}
+
+			res(k*N + i, 0) = sum;
+		}
+	}
+
+	return res;
+}
+
+/*!
+@brief  Computes C'*v, with v laid out as the dynamics
+*/
+template<int N, int M, int L, typename T>
+Matrix<L*(N+M),1,T> sparseDynamicsMultTr(const Matrix<N,N,T> &A, const Matrix<N,M,T> &B, const Matrix<L*N,1,T> &v)
+{
+	constexpr int S = N + M;
+	Matrix<L*(N+M),1,T> res;
+
+	for(int k = 0; k < L; ++k)
+	{
+		for(int i = 0; i < M; ++i)
+		{
+			T sum = 0;
+
+			for(int j = 0; j < N; ++j)
+			{
+				sum -= B(j,i) * v(k*N + j, 0);
+			}
+
+			res(k*S + i, 0) = sum;
+		}
+
+		for(int i = 0; i < N; ++i)
+		{
+			T sum = v(k*N + i, 0);
+
+			for(int j = 0; j < N && k < L-1; ++j)
+			{
+				sum -= A(j,i) * v((k+1)*N + j, 0);
+			}
+
+			res(k*S + M + i, 0) = sum;
+		}
+	}
+
+	return res;
+}
+
+/*!
+@brief  KKT solver selection for the sparse formulation. Every specialisation provides factor(), run once per
+        interior-point iteration, and solve(), run once per search direction.
+@tparam solver  Solver to use
+@tparam N   Number of states
+@tparam M   Number of inputs
+@tparam L   Prediction horizon
+@tparam T   Data type
+*/
+template<Solvers solver, int N, int M, int L, typename T = float>
+struct SparseKkt
+{ };
+
+/*!
+@brief  Block-tridiagonal factorization. The stage blocks of Phi are inverted, and the Schur complement of the
+        dynamics, Y = C*inv(Phi)*C', is a block-tridiagonal matrix with NxN blocks, factorized as a block LDL' with a
+        unit lower bidiagonal factor. Cost is O(L*(N+M)^3) per factorization and O(L*(N+M)^2) per solve.
+        Q and P must be positive definite, so every block of Phi can be inverted.
+*/
+template<int N, int M, int L, typename T>
+struct SparseKkt<CHOLESKY, N, M, L, T>
+{
+	struct Factor
+	{
+		Matrix<M,M,T> Ru[L];    //!< Inverse of the input blocks of Phi, R + Su_k
+		Matrix<N,N,T> Qx[L];    //!< Inverse of the state blocks of Phi, Q + Sx_{k+1}
+		Matrix<N,N,T> Dinv[L];  //!< Inverse of the diagonal blocks of the LDL' factorization of Y
+		Matrix<N,N,T> E[L];     //!< Subdiagonal blocks of the unit lower bidiagonal factor, E[0] is unused
+	};
+
+	/*!
+	@param  sigma   Barrier terms, lk./sk summed over the upper and lower bounds of every decision value
+	*/
+	static void factor
+	(
+		const Matrix<N,N,T> &A, const Matrix<N,M,T> &B,
+		const Matrix<N,N,T> &Q, const Matrix<M,M,T> &R, const Matrix<N,N,T> &P,
+		const Matrix<L*(N+M),1,T> &sigma, Factor &F
+	)
+	{
+		constexpr int S = N + M;
+
+		// Inverse of the stage blocks of Phi
+
+		for(int k = 0; k < L; ++k)
+		{
+			Matrix<M,M,T> Rk = R;
+			Matrix<N,N,T> Qk = k < L-1 ? Q : P;
+
+			for(int i = 0; i < M; ++i)
+			{
+				Rk(i,i) += sigma(k*S + i, 0);
+			}
+
+			for(int i = 0; i < N; ++i)
+			{
+				Qk(i,i) += sigma(k*S + M + i, 0);
+			}
+
+			F.Ru[k] = lscholInverse(Rk);
+			F.Qx[k] = lscholInverse(Qk);
+		}
+
+		// Block LDL' of Y. Y_kk = B*Ru_k*B' + Qx_k + A*Qx_{k-1}*A', Y_{k,k-1} = -A*Qx_{k-1}
+
+		const Matrix<M,N,T> Bt = B.transpose();
+		const Matrix<N,N,T> At = A.transpose();
+
+		for(int k = 0; k < L; ++k)
+		{
+			Matrix<N,M,T> BR = B * F.Ru[k];
+			Matrix<N,N,T> Y = BR * Bt + F.Qx[k];
+
+			if(k > 0)
+			{
+				Matrix<N,N,T> W = A * F.Qx[k-1] * T(-1);
+
+				Y -= W * At;
+				F.E[k] = W * F.Dinv[k-1];
+				Y -= F.E[k] * W.transpose();
+			}
+
+			F.Dinv[k] = lscholInverse(Y);
+		}
+	}
+
+	/*!
+	@param  r1  Right-hand side of the stationarity rows
+	@param  re  Right-hand side of the dynamics rows
+	@param  dz  Resulting step of the decision values
+	@param  dv  Resulting step of the dynamics multipliers
+	*/
+	static void solve
+	(
+		const Matrix<N,N,T> &A, const Matrix<N,M,T> &B, const Factor &F,
+		const Matrix<L*(N+M),1,T> &r1, const Matrix<L*N,1,T> &re,
+		Matrix<L*(N+M),1,T> &dz, Matrix<L*N,1,T> &dv
+	)
+	{
+		// Y*dv = C*inv(Phi)*r1 - re
+
+		Matrix<L*(N+M),1,T> t;
+
+		phiSolve(F, r1, t);
+
+		Matrix<L*N,1,T> c = sparseDynamicsMul<N,M,L>(A, B, t) - re;
+
+		// Forward substitution with the unit lower factor, then scaling by the inverse diagonal blocks
+
+		Matrix<N,1,T> prev(T(0));
+
+		for(int k = 0; k < L; ++k)
+		{
+			Matrix<N,1,T> ck;
+
+			for(int i = 0; i < N; ++i)
+			{
+				ck(i,0) = c(k*N + i, 0);
+			}
+
+			if(k > 0)
+			{
+				ck -= F.E[k] * prev;
+			}
+
+			prev = ck;
+
+			Matrix<N,1,T> dk = F.Dinv[k] * ck;
+
+			for(int i = 0; i < N; ++i)
+			{
+				dv(k*N + i, 0) = dk(i,0);
+			}
+		}
+
+		// Backward substitution with the transposed factor
+
+		for(int k = L-2; k >= 0; --k)
+		{
+			for(int i = 0; i < N; ++i)
+			{
+				T sum = dv(k*N + i, 0);
+
+				for(int j = 0; j < N; ++j)
+				{
+					sum -= F.E[k+1](j,i) * dv((k+1)*N + j, 0);
+				}
+
+				dv(k*N + i, 0) = sum;
+			}
+		}
+
+		// dz = inv(Phi)*(r1 - C'*dv)
+
+		t = r1 - sparseDynamicsMultTr<N,M,L>(A, B, dv);
+		phiSolve(F, t, dz);
+	}
+
+private:
+	//! x = inv(Phi)*b, stage by stage
+	static void phiSolve(const Factor &F, const Matrix<L*(N+M),1,T> &b, Matrix<L*(N+M),1,T> &x)
+	{
+		constexpr int S = N + M;
+
+		for(int k = 0; k < L; ++k)
+		{
+			for(int i = 0; i < M; ++i)
+			{
+				T sum = 0;
+
+				for(int j = 0; j < M; ++j)
+				{
+					sum += F.Ru[k](i,j) * b(k*S + j, 0);
+				}
+
+				x(k*S + i, 0) = sum;
+			}
+
+			for(int i = 0; i < N; ++i)
+			{
+				T sum = 0;
+
+				for(int j = 0; j < N; ++j)
+				{
+					sum += F.Qx[k](i,j) * b(k*S + M + j, 0);
+				}
+
+				x(k*S + M + i, 0) = sum;
+			}
+		}
+	}
+};
+
+/*!
+@brief  Riccati recursion. The KKT system is the optimality condition of an equality constrained LQ problem in the
+        steps, with dx_0 = 0, stage weights Phi and the dynamics residual re as a disturbance. factor() runs the
+        backward recursion of the value matrices, solve() the backward recursion of the value vectors and a forward
+        rollout of the steps. Same cost as the block-tridiagonal factorization, but only R + Su_k has to be invertible,
+        so Q and P may be positive semidefinite.
+*/
+template<int N, int M, int L, typename T>
+struct SparseKkt<RICCATI, N, M, L, T>
+{
+	struct Factor
+	{
+		Matrix<N,N,T> P[L];     //!< Value matrix of x_{k+1}
+		Matrix<M,M,T> Ginv[L];  //!< Inverse of R + Su_k + B'*P[k]*B
+		Matrix<M,N,T> K[L];     //!< Feedback gain of stage k, du_k = K[k]*dx_k + feedforward
+	};
+
+	/*!
+	@param  sigma   Barrier terms, lk./sk summed over the upper and lower bounds of every decision value
+	*/
+	static void factor
+	(
+		const Matrix<N,N,T> &A, const Matrix<N,M,T> &B,
+		const Matrix<N,N,T> &Q, const Matrix<M,M,T> &R, const Matrix<N,N,T> &P,
+		const Matrix<L*(N+M),1,T> &sigma, Factor &F
+	)
+	{
+		constexpr int S = N + M;
+
+		F.P[L-1] = P;
+
+		for(int i = 0; i < N; ++i)
+		{
+			F.P[L-1](i,i) += sigma((L-1)*S + M + i, 0);
+		}
+
+		for(int k = L-1; k >= 0; --k)
+		{
+			Matrix<N,M,T> PB = F.P[k] * B;
+			Matrix<M,M,T> G = R + B.multTr(PB);
+
+			for(int i = 0; i < M; ++i)
+			{
+				G(i,i) += sigma(k*S + i, 0);
+			}
+
+			F.Ginv[k] = lscholInverse(G);
+			F.K[k] = F.Ginv[k] * PB.multTr(A) * T(-1);
+
+			if(k > 0)
+			{
+				// P_k = Q + Sx_k + A'*P_{k+1}*(A + B*K_k)
+
+				Matrix<N,N,T> ABK = A + B * F.K[k];
+
+				F.P[k-1] = Q + A.multTr(F.P[k] * ABK);
+
+				for(int i = 0; i < N; ++i)
+				{
+					F.P[k-1](i,i) += sigma((k-1)*S + M + i, 0);
+				}
+			}
+		}
+	}
+
+	/*!
+	@param  r1  Right-hand side of the stationarity rows
+	@param  re  Right-hand side of the dynamics rows
+	@param  dz  Resulting step of the decision values
+	@param  dv  Resulting step of the dynamics multipliers
+	*/
+	static void solve
+	(
+		const Matrix<N,N,T> &A, const Matrix<N,M,T> &B, const Factor &F,
+		const Matrix<L*(N+M),1,T> &r1, const Matrix<L*N,1,T> &re,
+		Matrix<L*(N+M),1,T> &dz, Matrix<L*N,1,T> &dv
+	)
+	{
+		constexpr int S = N + M;
+
+		Matrix<N,1,T> p[L];     // Value vector of x_{k+1}
+		Matrix<M,1,T> kff[L];   // Feedforward of stage k
+
+		// Backward recursion of the value vectors
+
+		for(int i = 0; i < N; ++i)
+		{
+			p[L-1](i,0) = r1((L-1)*S + M + i, 0);
+		}
+
+		for(int k = L-1; k >= 0; --k)
+		{
+			Matrix<N,1,T> e, c;
+			Matrix<M,1,T> ru;
+
+			for(int i = 0; i < N; ++i)
+			{
+				e(i,0) = re(k*N + i, 0);
+			}
+
+			for(int i = 0; i < M; ++i)
+			{
+				ru(i,0) = r1(k*S + i, 0);
+			}
+
+			c = p[k] - F.P[k] * e;
+			kff[k] = F.Ginv[k] * (ru + B.multTr(c));
+
+			if(k > 0)
+			{
+				Matrix<N,1,T> w = c - F.P[k] * (B * kff[k]);
+
+				p[k-1] = A.multTr(w);
+
+				for(int i = 0; i < N; ++i)
+				{
+					p[k-1](i,0) += r1((k-1)*S + M + i, 0);
+				}
+			}
+		}
+
+		// Forward rollout from dx_0 = 0. The multipliers are the gradients of the value functions
+
+		Matrix<N,1,T> x(T(0));
+
+		for(int k = 0; k < L; ++k)
+		{
+			Matrix<N,1,T> e;
+
+			for(int i = 0; i < N; ++i)
+			{
+				e(i,0) = re(k*N + i, 0);
+			}
+
+			Matrix<M,1,T> u = F.K[k] * x + kff[k];
+			Matrix<N,1,T> xn = A * x + B * u + e;
+			Matrix<N,1,T> vk = p[k] - F.P[k] * xn;
+
+			for(int i = 0; i < M; ++i)
+			{
+				dz(k*S + i, 0) = u(i,0);
+			}
+
+			for(int i = 0; i < N; ++i)
+			{
+				dz(k*S + M + i, 0) = xn(i,0);
+				dv(k*N + i, 0) = vk(i,0);
+			}
+
+			x = xn;
+		}
+	}
+};
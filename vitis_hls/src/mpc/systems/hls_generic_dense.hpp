@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../mpc_dense.hpp"
+#include "../mpc_controller.hpp"
 #include "../generic_dense_defaults.hpp"
 
 constexpr int N = MPC_N;
@@ -13,7 +14,18 @@ constexpr Solvers SOLVER = MPC_SOLVER;
 constexpr MpcConstraints CONSTRAINTS = MPC_CONSTRAINTS;
 constexpr bool TRACK_REF = MPC_TRACK_REF;
 constexpr int QP_ITER = MPC_QP_ITER;
+constexpr PdipAlgorithm QP_ALGORITHM = MPC_QP_ALGORITHM;
+constexpr bool INEXACT_NEWTON = MPC_INEXACT_NEWTON;
 constexpr int TOL = MPC_TOL;
+constexpr bool EARLY_EXIT = MPC_EARLY_EXIT;
+constexpr int EXIT_TOL = MPC_EXIT_TOL;
+constexpr bool WARM_START = MPC_WARM_START;
+constexpr int EXPLICIT_REGIONS = MPC_EXPLICIT_REGIONS;
+constexpr int CACHE_SIZE = MPC_CACHE_SIZE;
+constexpr int CACHE_TOL = MPC_CACHE_TOL;
+
+typedef MpcModel<N, M, P, L, V, float, EXPLICIT_REGIONS> GenericDenseModel;
+typedef MpcController<GenericDenseModel, SOLVER, CONSTRAINTS, TRACK_REF, QP_ITER, TOL, EARLY_EXIT, EXIT_TOL, QP_ALGORITHM, INEXACT_NEWTON, CACHE_SIZE, CACHE_TOL> GenericDenseController;
 
 #if !MPC_TRACK_REF
 extern Matrix<M,1> hls_main(Matrix<N,1> x);
@@ -0,0 +1,389 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "mapped_file.hpp"
+
+/*!
+@file   trajectory_file.hpp
+@brief  Binary trajectory files for the closed-loop references, goldenReference.dat and the cosim data:
+
+            TrajectoryHeader, then float arrays x0[N], u[samples][M], x[samples][N], yref[samples][P]
+
+        Every signal is one contiguous column block, row-major per sample, in host byte order. Files are memory-mapped
+        and read in place, so a recording of 1e8 samples opens as fast as a short one and pages are only loaded as the
+        replay reaches them. The magic and the version reject files of another layout or byte order.
+*/
+
+//! Layout version of the trajectory files written by this header
+#define MPC_TRAJECTORY_VERSION 1
+
+/*! Outcome of opening a trajectory file */
+enum TrajectoryStatus
+{
+	TRAJECTORY_OK,          /*!< Trajectory mapped and validated */
+	TRAJECTORY_OPEN_FAILED, /*!< File missing, unreadable or not mappable */
+	TRAJECTORY_BAD_MAGIC,   /*!< Not a trajectory file */
+	TRAJECTORY_BAD_VERSION, /*!< Other layout version, or other byte order */
+	TRAJECTORY_BAD_SIZE     /*!< Sizes of the header inconsistent with the file length or the scalar type */
+};
+
+/*! Header of a trajectory file */
+struct TrajectoryHeader
+{
+	char magic[4];              //!< "MPCT"
+	std::uint32_t version;      //!< MPC_TRAJECTORY_VERSION
+	std::uint32_t header_bytes; //!< sizeof(TrajectoryHeader), offset of x0
+	std::uint32_t scalar_bytes; //!< Size of every element, sizeof(float)
+	std::uint64_t samples;      //!< Number of samples
+	std::int32_t N;             //!< Number of states
+	std::int32_t M;             //!< Number of inputs
+	std::int32_t P;             //!< Number of outputs of the reference, 0 without one
+	std::uint32_t reserved;
+	char name[32];              //!< Name of the system, nul-terminated
+};
+
+/*!
+@brief  Non-owning view of a trajectory: initial state, then the input applied and the resulting state of every sample,
+        plus the output reference when P > 0
+*/
+struct TrajectoryView
+{
+	long samples;
+	int N;
+	int M;
+	int P;
+	const float *x0;
+	const float *u_data;
+	const float *x_data;
+	const float *yref_data;
+
+	//! Input of sample i, M values
+	const float *u(long i) const { return u_data + i*M; }
+
+	//! State after sample i, N values
+	const float *x(long i) const { return x_data + i*N; }
+
+	//! Reference of sample i, P values
+	const float *yref(long i) const { return yref_data + i*P; }
+};
+
+/*!
+@brief  Number of floats after the header of a trajectory file
+*/
+inline std::uint64_t trajectoryPayload(std::uint64_t samples, int N, int M, int P)
+{
+	return std::uint64_t(N) + samples * std::uint64_t(M + N + P);
+}
+
+/*!
+@brief  Read-only memory mapping of a trajectory file. The view points into the mapping, so it is valid as long as
+        the TrajectoryFile lives.
+*/
+class TrajectoryFile
+{
+public:
+	TrajectoryFile() : m_status(TRAJECTORY_OPEN_FAILED), m_view()
+	{ }
+
+	//! Maps path, check status() for the outcome
+	explicit TrajectoryFile(const char *path) : TrajectoryFile()
+	{
+		open(path);
+	}
+
+	/*!
+	@brief  Maps and validates a trajectory file, unmapping the previous one
+	@return TRAJECTORY_OK, or the reason the file was rejected
+	*/
+	TrajectoryStatus open(const char *path)
+	{
+		close();
+
+		if(!m_file.open(path) || m_file.size() < sizeof(TrajectoryHeader))
+		{
+			m_file.close();
+			return m_status = TRAJECTORY_OPEN_FAILED;
+		}
+
+		TrajectoryStatus status = validate();
+
+		if(status != TRAJECTORY_OK)
+		{
+			close();
+		}
+
+		return m_status = status;
+	}
+
+	//! Unmaps the file
+	void close()
+	{
+		m_file.close();
+		m_status = TRAJECTORY_OPEN_FAILED;
+		m_view = TrajectoryView();
+	}
+
+	TrajectoryStatus status() const { return m_status; }
+
+	//! Signals of the trajectory, only valid with TRAJECTORY_OK
+	const TrajectoryView &view() const { return m_view; }
+
+	const TrajectoryHeader &header() const { return *static_cast<const TrajectoryHeader*>(m_file.data()); }
+
+private:
+	TrajectoryStatus validate()
+	{
+		const TrajectoryHeader &h = header();
+
+		if(std::memcmp(h.magic, "MPCT", 4) != 0)
+		{
+			return TRAJECTORY_BAD_MAGIC;
+		}
+
+		if(h.version != MPC_TRAJECTORY_VERSION)
+		{
+			return TRAJECTORY_BAD_VERSION;
+		}
+
+		const bool sizes = h.header_bytes == sizeof(TrajectoryHeader) && h.scalar_bytes == sizeof(float)
+			&& h.N > 0 && h.M > 0 && h.P >= 0 && h.N <= 4096 && h.M <= 4096 && h.P <= 4096
+			&& h.samples <= (std::uint64_t(1) << 40)
+			&& m_file.size() >= h.header_bytes + trajectoryPayload(h.samples, h.N, h.M, h.P) * sizeof(float)
+			&& std::memchr(h.name, 0, sizeof(h.name)) != nullptr;
+
+		if(!sizes)
+		{
+			return TRAJECTORY_BAD_SIZE;
+		}
+
+		const float *p = reinterpret_cast<const float*>(static_cast<const char*>(m_file.data()) + h.header_bytes);
+		const long samples = long(h.samples);
+
+		m_view.samples = samples;
+		m_view.N = h.N;
+		m_view.M = h.M;
+		m_view.P = h.P;
+		m_view.x0 = p;
+		m_view.u_data = p + h.N;
+		m_view.x_data = m_view.u_data + samples * h.M;
+		m_view.yref_data = m_view.x_data + samples * h.N;
+
+		return TRAJECTORY_OK;
+	}
+
+	MappedFile m_file;
+	TrajectoryStatus m_status;
+	TrajectoryView m_view;
+};
+
+/*!
+@brief  Creates a trajectory file of known length and maps it read-write, so the signals are filled in place without
+        holding the trajectory in memory. The file is complete once every sample is written and the writer closed.
+*/
+class TrajectoryWriter
+{
+public:
+	/*!
+	@brief  Creates the file, every value starts at zero
+	@return false if the file cannot be created
+	*/
+	bool create(const char *path, const char *name, long samples, int N, int M, int P)
+	{
+		const std::uint64_t bytes = sizeof(TrajectoryHeader) + trajectoryPayload(samples, N, M, P) * sizeof(float);
+
+		if(samples < 0 || !m_file.create(path, std::size_t(bytes)))
+		{
+			return false;
+		}
+
+		TrajectoryHeader &h = *static_cast<TrajectoryHeader*>(m_file.data());
+		std::memset(&h, 0, sizeof(h));
+		std::memcpy(h.magic, "MPCT", 4);
+		h.version = MPC_TRAJECTORY_VERSION;
+		h.header_bytes = sizeof(TrajectoryHeader);
+		h.scalar_bytes = sizeof(float);
+		h.samples = std::uint64_t(samples);
+		h.N = N;
+		h.M = M;
+		h.P = P;
+		std::strncpy(h.name, name ? name : "", sizeof(h.name) - 1);
+
+		m_N = N;
+		m_M = M;
+		m_P = P;
+		m_x0 = reinterpret_cast<float*>(&h + 1);
+		m_u = m_x0 + N;
+		m_x = m_u + samples * M;
+		m_yref = m_x + samples * N;
+
+		return true;
+	}
+
+	//! Unmaps the file, which is then complete
+	void close()
+	{
+		m_file.close();
+	}
+
+	float *x0() { return m_x0; }
+	float *u(long i) { return m_u + i*m_M; }
+	float *x(long i) { return m_x + i*m_N; }
+	float *yref(long i) { return m_yref + i*m_P; }
+
+private:
+	MappedFile m_file;
+	int m_N = 0;
+	int m_M = 0;
+	int m_P = 0;
+	float *m_x0 = nullptr;
+	float *m_u = nullptr;
+	float *m_x = nullptr;
+	float *m_yref = nullptr;
+};
+
+/*!
+@brief  Reads a trajectory in the goldenReference.dat text format: "x0 ; x1" on the first line, then "u ; x0 ; x1" on
+        every sample line, blank lines skipped. Streams the file, so it can be called twice, once to count the samples
+        and once to fill a TrajectoryWriter.
+@param  path    Text file
+@param  N   Number of states
+@param  M   Number of inputs
+@param  x0  Resulting initial state
+@param  sample  Called as sample(i, u, x) for every sample line
+@return Number of samples, or -1 if the file cannot be read or a line has the wrong number of values
+*/
+template<typename F>
+long readGoldenReference(const char *path, int N, int M, std::vector<float> &x0, F &&sample)
+{
+	std::FILE *file = std::fopen(path, "r");
+
+	if(!file)
+	{
+		return -1;
+	}
+
+	std::vector<float> values;
+	std::vector<char> line(4096);
+	long samples = 0;
+	bool first = true;
+	bool ok = true;
+
+	while(ok && std::fgets(line.data(), int(line.size()), file))
+	{
+		// Values separated by ';', parsed in place
+
+		values.clear();
+		const char *p = line.data();
+		char *end;
+
+		while(true)
+		{
+			float v = std::strtof(p, &end);
+
+			if(end == p)
+			{
+				break;
+			}
+
+			values.push_back(v);
+			p = end;
+
+			while(*p == ' ' || *p == '\t' || *p == ';')
+			{
+				++p;
+			}
+		}
+
+		if(values.empty())
+		{
+			continue;
+		}
+
+		if(first)
+		{
+			ok = int(values.size()) == N;
+			x0 = values;
+			first = false;
+			continue;
+		}
+
+		ok = int(values.size()) == M + N;
+
+		if(ok)
+		{
+			sample(samples, values.data(), values.data() + M);
+			++samples;
+		}
+	}
+
+	std::fclose(file);
+
+	return ok && !first ? samples : -1;
+}
+
+/*!
+@brief  Trajectory from a binary trajectory file, mapped, or from a goldenReference.dat text file, read into memory.
+        The view is valid as long as the TrajectorySource lives.
+*/
+class TrajectorySource
+{
+public:
+	/*!
+	@brief  Opens path as a trajectory file, or reads it as text if it is not one
+	@param  N   Number of states of the text format
+	@param  M   Number of inputs of the text format
+	@return false if the file cannot be read
+	*/
+	bool open(const char *path, int N, int M)
+	{
+		m_x0.clear();
+		m_u.clear();
+		m_x.clear();
+
+		if(m_file.open(path) == TRAJECTORY_OK)
+		{
+			m_view = m_file.view();
+			return true;
+		}
+
+		if(m_file.status() != TRAJECTORY_BAD_MAGIC)
+		{
+			return false;
+		}
+
+		const long samples = readGoldenReference(path, N, M, m_x0, [this, N, M](long, const float *u, const float *x)
+		{
+			m_u.insert(m_u.end(), u, u + M);
+			m_x.insert(m_x.end(), x, x + N);
+		});
+
+		if(samples < 0)
+		{
+			return false;
+		}
+
+		m_view = TrajectoryView();
+		m_view.samples = samples;
+		m_view.N = N;
+		m_view.M = M;
+		m_view.x0 = m_x0.data();
+		m_view.u_data = m_u.data();
+		m_view.x_data = m_x.data();
+
+		return true;
+	}
+
+	const TrajectoryView &view() const { return m_view; }
+
+private:
+	TrajectoryFile m_file;
+	std::vector<float> m_x0;
+	std::vector<float> m_u;
+	std::vector<float> m_x;
+	TrajectoryView m_view = TrajectoryView();
+};
@@ -0,0 +1,71 @@
+#include "mpc/systems/hls_generic_dense.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+#include "mpc/mpc_profile.hpp"
+#include "mpc/trajectory_file.hpp"
+#include "mpc/generic_dense_init.hpp"
+#include "mpc/generic_dense_cosim.hpp"
+
+#if !MPC_PROFILE
+#error "profile_generic_dense needs -DMPC_PROFILE=1 (steady_clock) or -DMPC_PROFILE=2 (TSC)"
+#endif
+
+/*!
+@file   profile_generic_dense.cpp
+@brief  Latency distribution of hls_main over the closed loop of a reference trajectory, replayed a number of passes.
+
+Prints the percentiles of the whole call and of every stage of mpc_dense and pdip, and of the QP and inner solver
+iterations, from the histograms of mpc_profile.hpp. The tail, p99.9 and max, is what sizes the control period.
+*/
+
+/*!
+@brief  Usage: profile_generic_dense [goldenReference.dat | trajectory.mpct] [passes]
+*/
+int main(int argc, char **argv)
+{
+	TrajectorySource source;
+	TrajectoryView ref = cosimTrajectory();
+	const int passes = argc > 2 ? std::atoi(argv[2]) : 100;
+
+	if(argc > 1 && argv[1][0])
+	{
+		if(!source.open(argv[1], N, M))
+		{
+			std::cerr << "Cannot read trajectory from " << argv[1] << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		ref = source.view();
+	}
+
+	if(TRACK_REF && ref.P != P)
+	{
+		std::cerr << "Tracking a reference needs a trajectory with y_ref" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	const auto A = Matrix<N,N>(__init_A);
+	const auto B = Matrix<N,M>(__init_B);
+
+	for(int pass = 0; pass < passes; ++pass)
+	{
+		auto x = Matrix<N,1>(ref.x0);
+
+		for(long i = 0; i < ref.samples; ++i)
+		{
+#if MPC_TRACK_REF
+			Matrix<M,1> u = hls_main(x, Matrix<P,1>(ref.yref(i)));
+#else
+			Matrix<M,1> u = hls_main(x);
+#endif
+			x = A * x + B * u;
+		}
+	}
+
+	std::cout << "Steps: " << ref.samples * passes << " (" << passes << " passes of " << ref.samples << " samples)" << std::endl;
+	mpcProfileReport(mpcProfile().data(), std::cout, MPC_PROFILE_UNIT);
+
+	return EXIT_SUCCESS;
+}
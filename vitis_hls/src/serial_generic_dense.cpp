@@ -0,0 +1,518 @@
+#include "mpc/systems/hls_generic_dense.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "mpc/mpc_controller.hpp"
+#include "mpc/serial_frame.hpp"
+#include "mpc/trajectory_file.hpp"
+#include "mpc/generic_dense_init.hpp"
+#include "mpc/generic_dense_cosim.hpp"
+
+/*!
+@file   serial_generic_dense.cpp
+@brief  Host replay of a reference trajectory through the board over the framed serial protocol, serial_frame.hpp.
+
+Every sample sends the reference state before it, and the reference output when tracking, and receives the input the
+board computed. Up to a window of requests are in flight, so the link stays busy instead of waiting for every answer.
+The input is compared with the reference input, and the state it leads to, simulated here from the reference state,
+with the reference state. With --loopback the board is replaced by a stand-in on the slave side of a pseudo-terminal,
+running the generated controller as the board application does, so the whole path is exercised without hardware.
+--corrupt does the same with a stand-in that damages some of its answers, see corruptAnswer: those must be counted as
+lost, and every other answer still found, for the run to pass.
+POSIX only; on Windows Serialcmd.py still talks to the text protocol.
+*/
+
+namespace
+{
+
+//! Payload lengths of FRAME_STEP and FRAME_RESULT for the generated system
+constexpr int STEP_BYTES = 4*(N + (TRACK_REF ? P : 0));
+constexpr int RESULT_BYTES = FRAME_RESULT_BYTES + 4*M;
+
+//! One answer in CORRUPT_PERIOD is damaged by the stand-in board with --corrupt, another one is preceded by noise
+constexpr long CORRUPT_PERIOD = 16;
+
+/*!
+@brief  Answers the stand-in board damages with --corrupt, so the host must count them as lost. The last one is
+        always among them, to check the replay does not wait for it forever.
+*/
+bool corruptAnswer(long k, long samples)
+{
+	return k % CORRUPT_PERIOD == CORRUPT_PERIOD / 2 || k == samples - 1;
+}
+
+speed_t baudRate(long baud)
+{
+	switch(baud)
+	{
+		case 9600: return B9600;
+		case 19200: return B19200;
+		case 38400: return B38400;
+		case 57600: return B57600;
+		case 230400: return B230400;
+		case 460800: return B460800;
+		case 921600: return B921600;
+		default: return B115200;
+	}
+}
+
+/*!
+@brief  Raw 8N1 mode, blocking reads of at least one byte
+*/
+bool configure(int fd, long baud)
+{
+	termios tty;
+
+	if(tcgetattr(fd, &tty) != 0)
+	{
+		return false;
+	}
+
+	cfmakeraw(&tty);
+	cfsetispeed(&tty, baudRate(baud));
+	cfsetospeed(&tty, baudRate(baud));
+	tty.c_cflag |= CLOCAL | CREAD;
+	tty.c_cc[VMIN] = 1;
+	tty.c_cc[VTIME] = 0;
+
+	return tcsetattr(fd, TCSANOW, &tty) == 0;
+}
+
+/*!
+@brief  One end of the serial link: writes frames and returns the frames decoded from the bytes read
+*/
+class Link
+{
+public:
+	explicit Link(int fd) : m_fd(fd), m_parser(STEP_BYTES, RESULT_BYTES), m_pos(0), m_len(0)
+	{ }
+
+	bool send(std::uint8_t type, std::uint16_t seq, const std::uint8_t *payload, int length)
+	{
+		std::uint8_t frame[FRAME_MAX_PAYLOAD + FRAME_OVERHEAD];
+
+		return sendBytes(frame, encodeFrame(type, seq, payload, length, frame));
+	}
+
+	//! Writes bytes as they are, framed or not
+	bool sendBytes(const std::uint8_t *bytes, int length)
+	{
+		for(int done = 0; done < length; )
+		{
+			ssize_t n = write(m_fd, bytes + done, length - done);
+
+			if(n <= 0)
+			{
+				return false;
+			}
+
+			done += int(n);
+		}
+
+		return true;
+	}
+
+	/*!
+	@brief  Waits for the next valid frame
+	@param  timeout_ms  Longest silence of the link, negative to wait forever
+	@return false on timeout or when the link is closed
+	*/
+	bool receive(Frame &frame, int timeout_ms)
+	{
+		while(true)
+		{
+			// A rescan of the parser can complete several frames from the bytes already pushed
+
+			if(m_parser.next())
+			{
+				frame = m_parser.frame();
+				return true;
+			}
+
+			while(m_pos < m_len)
+			{
+				if(m_parser.push(m_buffer[m_pos++]))
+				{
+					frame = m_parser.frame();
+					return true;
+				}
+			}
+
+			pollfd p = { m_fd, POLLIN, 0 };
+
+			if(poll(&p, 1, timeout_ms) <= 0)
+			{
+				return false;
+			}
+
+			ssize_t n = read(m_fd, m_buffer, sizeof(m_buffer));
+
+			if(n <= 0)
+			{
+				return false;
+			}
+
+			m_pos = 0;
+			m_len = int(n);
+		}
+	}
+
+	const FrameParser &parser() const { return m_parser; }
+
+private:
+	int m_fd;
+	FrameParser m_parser;
+	std::uint8_t m_buffer[4096];
+	int m_pos;
+	int m_len;
+};
+
+/*!
+@brief  Writes an answer damaged as selected by corruptAnswer: a flipped payload bit, a wrong length or the first half
+        only, in turn. The last answer is always cut in half.
+*/
+bool sendCorrupted(Link &link, long k, long samples, const std::uint8_t *payload)
+{
+	std::uint8_t frame[RESULT_BYTES + FRAME_OVERHEAD];
+	int bytes = encodeFrame(FRAME_RESULT, std::uint16_t(k), payload, RESULT_BYTES, frame);
+	const long kind = k == samples - 1 ? 2 : (k / CORRUPT_PERIOD) % 3;
+
+	if(kind == 0)
+	{
+		frame[7 + RESULT_BYTES / 2] ^= 0x10;
+	}
+	else if(kind == 1)
+	{
+		frameStore16(frame + 5, std::uint16_t(RESULT_BYTES + 4));
+	}
+	else
+	{
+		bytes /= 2;
+	}
+
+	return link.sendBytes(frame, bytes);
+}
+
+/*!
+@brief  Writes bytes that look like the start of an answer, so the parser takes the following frame as its payload
+        and has to find it again when the CRC fails
+*/
+bool sendNoise(Link &link, long k)
+{
+	std::uint8_t noise[] = { 0x00, FRAME_SYNC0, 0x17, FRAME_SYNC0, FRAME_SYNC1, FRAME_RESULT, 0, 0, 0, 0, 0x42 };
+
+	frameStore16(noise + 6, std::uint16_t(k));
+	frameStore16(noise + 8, std::uint16_t(RESULT_BYTES));
+
+	return link.sendBytes(noise, sizeof(noise));
+}
+
+/*!
+@brief  Board side of the protocol, as run by the board application around hls_main. Timing in nanoseconds.
+        Returns when the host closes the link.
+@param  samples Length of the replayed trajectory, used to damage the last answer
+@param  corrupt Damage the answers selected by corruptAnswer, and precede others by noise
+*/
+void standInBoard(int fd, long samples, bool corrupt)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const GenericDenseModel model = genericDenseModel();
+	GenericDenseController controller(model, WARM_START);
+	Link link(fd);
+	Frame frame;
+	std::uint8_t payload[RESULT_BYTES];
+	long k = 0;
+
+	while(link.receive(frame, -1))
+	{
+		if(frame.type == FRAME_RESET)
+		{
+			controller.reset();
+			k = 0;
+			link.send(FRAME_ACK, frame.seq, nullptr, 0);
+		}
+		else if(frame.type == FRAME_STEP)
+		{
+			const auto x = Matrix<N,1>::deserialize(frame.payload);
+#if MPC_TRACK_REF
+			controller.setReference(Matrix<P,1>::deserialize(frame.payload + 4*N));
+#endif
+			auto t0 = Clock::now();
+			Matrix<M,1> u = controller.step(x);
+			auto t1 = Clock::now();
+
+			FrameResult result;
+			result.elapsed = std::uint32_t(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+			result.iterations = std::uint16_t(controller.result().iterations);
+			result.status = std::uint8_t(controller.result().status);
+
+			encodeResult(result, payload);
+			u.serialize(payload + FRAME_RESULT_BYTES);
+
+			if(corrupt && corruptAnswer(k, samples))
+			{
+				sendCorrupted(link, k, samples, payload);
+			}
+			else
+			{
+				if(corrupt && k % CORRUPT_PERIOD == 0)
+				{
+					sendNoise(link, k);
+				}
+
+				link.send(FRAME_RESULT, frame.seq, payload, sizeof(payload));
+			}
+
+			++k;
+		}
+	}
+}
+
+struct ReplayReport
+{
+	long answered = 0;
+	long lost = 0;          //!< Requests whose answer never arrived
+	long failed = 0;        //!< Samples with a squared error above 0.1, the criterion of Serialcmd.py
+	long errors = 0;        //!< Candidate frames dropped for a wrong type, length or CRC
+	double mse_u = 0;
+	double mse_x = 0;
+	double max_du = 0;
+	double elapsed = 0;     //!< Mean board time per step, in board ticks
+	double iterations = 0;  //!< Mean QP iterations per step
+	double seconds = 0;
+};
+
+/*!
+@brief  Resets the board controller, then streams every sample with up to window requests in flight. When no answer
+        arrives in time every request in flight is counted as lost, which is how a lost last answer is found.
+@return false if the board stops answering, nothing for two timeouts in a row
+*/
+bool replay(int fd, const TrajectoryView &ref, int window, ReplayReport &report)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const auto A = Matrix<N,N>(__init_A);
+	const auto B = Matrix<N,M>(__init_B);
+	const int timeout_ms = 2000;
+
+	Link link(fd);
+	Frame frame;
+	std::uint8_t payload[4*(N + P)];
+
+	if(!link.send(FRAME_RESET, 0, nullptr, 0) || !link.receive(frame, timeout_ms) || frame.type != FRAME_ACK)
+	{
+		std::cerr << "No answer to the reset" << std::endl;
+		return false;
+	}
+
+	auto t0 = Clock::now();
+	long sent = 0;
+	bool silent = false;
+
+	while(report.answered + report.lost < ref.samples)
+	{
+		const long next = report.answered + report.lost;
+
+		for(; sent < ref.samples && sent - next < window; ++sent)
+		{
+			const float *x = sent ? ref.x(sent - 1) : ref.x0;
+			int length = Matrix<N,1>(x).serialize(payload);
+#if MPC_TRACK_REF
+			length += Matrix<P,1>(ref.yref(sent)).serialize(payload + length);
+#endif
+			if(!link.send(FRAME_STEP, std::uint16_t(sent), payload, length))
+			{
+				return false;
+			}
+		}
+
+		if(!link.receive(frame, timeout_ms))
+		{
+			if(silent)
+			{
+				std::cerr << "No answer for sample " << next << std::endl;
+				return false;
+			}
+
+			silent = true;
+			report.lost += sent - next;
+			continue;
+		}
+
+		silent = false;
+
+		// Answers arrive in order, a gap in the sequence numbers is an answer lost on the link
+
+		const std::uint16_t gap = std::uint16_t(frame.seq - std::uint16_t(next));
+
+		if(frame.type != FRAME_RESULT || gap >= sent - next)
+		{
+			continue;
+		}
+
+		report.lost += gap;
+
+		const long i = next + gap;
+		const FrameResult result = decodeResult(frame.payload);
+		const auto u = Matrix<M,1>::deserialize(frame.payload + FRAME_RESULT_BYTES);
+		const Matrix<N,1> x_prev(i ? ref.x(i - 1) : ref.x0);
+		const Matrix<N,1> x = A * x_prev + B * u;
+
+		const double err_u = u.mse(ref.u(i));
+		const double err_x = x.mse(ref.x(i));
+		const double du = std::sqrt(err_u * M);
+
+		report.mse_u += err_u / ref.samples;
+		report.mse_x += err_x / ref.samples;
+		report.max_du = du > report.max_du ? du : report.max_du;
+		report.failed += err_u > 0.1 || err_x > 0.1;
+		report.elapsed += double(result.elapsed) / ref.samples;
+		report.iterations += double(result.iterations) / ref.samples;
+		++report.answered;
+	}
+
+	report.seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+	report.errors = link.parser().errors();
+
+	return true;
+}
+
+} // namespace
+
+/*!
+@brief  Usage: serial_generic_dense <device | --loopback | --corrupt> [goldenReference.dat | trajectory.mpct] [window] [baud]
+*/
+int main(int argc, char **argv)
+{
+	if(argc < 2)
+	{
+		std::cerr << "Usage: " << argv[0] << " <device | --loopback | --corrupt> [goldenReference.dat | trajectory.mpct] [window] [baud]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	const bool corrupt = std::strcmp(argv[1], "--corrupt") == 0;
+	const bool loopback = corrupt || std::strcmp(argv[1], "--loopback") == 0;
+	const int window = argc > 3 ? std::atoi(argv[3]) : 32;
+	const long baud = argc > 4 ? std::atol(argv[4]) : 115200;
+
+	TrajectorySource source;
+	TrajectoryView ref = cosimTrajectory();
+
+	if(argc > 2)
+	{
+		if(!source.open(argv[2], N, M))
+		{
+			std::cerr << "Cannot read trajectory from " << argv[2] << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		ref = source.view();
+	}
+
+	if(ref.N != N || ref.M != M || (TRACK_REF && ref.P != P))
+	{
+		std::cerr << "The trajectory does not match the sizes of " << MPC_NAME_STR << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if(window < 1 || window > 1024)
+	{
+		std::cerr << "The window must be between 1 and 1024 requests" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// Host end of the link, and with --loopback the pseudo-terminal whose slave end plays the board
+
+	int fd = -1;
+	int board_fd = -1;
+	std::string device = argv[1];
+
+	if(loopback)
+	{
+		fd = posix_openpt(O_RDWR | O_NOCTTY);
+
+		if(fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0)
+		{
+			std::cerr << "Cannot create a pseudo-terminal" << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		device = ptsname(fd);
+		board_fd = open(device.c_str(), O_RDWR | O_NOCTTY);
+
+		if(board_fd < 0 || !configure(board_fd, baud))
+		{
+			std::cerr << "Cannot open " << device << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	else
+	{
+		fd = open(argv[1], O_RDWR | O_NOCTTY);
+
+		if(fd < 0 || !configure(fd, baud))
+		{
+			std::cerr << "Cannot open " << argv[1] << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::thread board;
+
+	if(loopback)
+	{
+		board = std::thread(standInBoard, board_fd, ref.samples, corrupt);
+	}
+
+	ReplayReport report;
+	const bool ok = replay(fd, ref, window, report);
+
+	// Closing the host end ends the stand-in
+
+	close(fd);
+
+	if(loopback)
+	{
+		board.join();
+		close(board_fd);
+	}
+
+	if(!ok)
+	{
+		return EXIT_FAILURE;
+	}
+
+	// Answers the stand-in damaged on purpose
+
+	long damaged = 0;
+
+	for(long k = 0; corrupt && k < ref.samples; ++k)
+	{
+		damaged += corruptAnswer(k, ref.samples);
+	}
+
+	std::cout << "Link: " << device << (loopback ? (corrupt ? " (stand-in board, damaged answers)" : " (stand-in board)") : "")
+		<< ", window " << window << std::endl;
+	std::cout << "Samples: " << report.answered << ", lost: " << report.lost << " (" << damaged << " damaged)"
+		<< ", dropped frames: " << report.errors << ", failed: " << report.failed << std::endl;
+	std::cout << std::fixed << std::setprecision(1)
+		<< "Samples/s: " << report.answered / report.seconds
+		<< ", board ticks/step: " << report.elapsed << ", QP it/step: " << report.iterations << std::endl;
+	std::cout << std::scientific << std::setprecision(3)
+		<< "MSE_u: " << report.mse_u << ", MSE_x: " << report.mse_x << ", max|du|: " << report.max_du << std::endl;
+
+	return report.lost == damaged && report.failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
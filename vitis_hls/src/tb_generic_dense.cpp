@@ -8,11 +8,28 @@
 #include "mpc/generic_dense_init.hpp"
 #include "mpc/generic_dense_cosim.hpp"
 
-int main()
+/*!
+@brief  Usage: tb_generic_dense [trajectory.mpct]. Replays a mapped trajectory file, or the cosim data linked in
+*/
+int main(int argc, char **argv)
 {
+	TrajectoryFile file;
+	TrajectoryView ref = cosimTrajectory();
+
+	if(argc > 1)
+	{
+		if(file.open(argv[1]) != TRAJECTORY_OK || file.view().N != N || file.view().M != M || (TRACK_REF && file.view().P != P))
+		{
+			std::cout << "Cannot replay " << argv[1] << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		ref = file.view();
+	}
+
 	auto A = Matrix<N,N>(__init_A);
 	auto B = Matrix<N,M>(__init_B);
-	auto x = Matrix<N,1>(__cosim_x0[0].data());
+	auto x = Matrix<N,1>(ref.x0);
 	auto u = Matrix<M,1>(0.0);
 
 	// Set up IO
@@ -30,16 +47,16 @@ int main()
 
 	// Run iterations
 
-	float total_mse_x = 0;
-	float total_mse_u = 0;
+	double total_mse_x = 0;
+	double total_mse_u = 0;
 
-	for(int i = 0; i < __cosim_iters; ++i)
+	for(long i = 0; i < ref.samples; ++i)
 	{
 		// Simulate control and system
 
 #if MPC_TRACK_REF
-		auto y_ref = Matrix<P,1>(__cosim_yref[i].data());
-		u = hls_main(x, y_ref, true);
+		auto y_ref = Matrix<P,1>(ref.yref(i));
+		u = hls_main(x, y_ref);
 #else
 		u = hls_main(x);
 #endif
@@ -55,8 +72,8 @@ int main()
 
 		// Compare against reference values
 
-		float iter_mse_x = x.mse(__cosim_x[i]);
-		float iter_mse_u = u.mse(__cosim_u[i]);
+		float iter_mse_x = x.mse(ref.x(i));
+		float iter_mse_u = u.mse(ref.u(i));
 
 		if(iter_mse_x >= 0.01 || iter_mse_u >= 0.01)
 		{
@@ -79,8 +96,8 @@ int main()
 			std::cerr << std::endl;
 		}
 
-		total_mse_x += iter_mse_x / __cosim_iters;
-		total_mse_u += iter_mse_u / __cosim_iters;
+		total_mse_x += iter_mse_x / ref.samples;
+		total_mse_u += iter_mse_u / ref.samples;
 	}
 
 	// Check global MSE
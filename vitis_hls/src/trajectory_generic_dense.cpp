@@ -0,0 +1,129 @@
+#include "mpc/systems/hls_generic_dense.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "mpc/generic_dense_init.hpp"
+#include "mpc/generic_dense_cosim.hpp"
+#include "mpc/trajectory_file.hpp"
+
+/*!
+@file   trajectory_generic_dense.cpp
+@brief  Converts a reference trajectory to a binary trajectory file, trajectory_file.hpp.
+
+The input is a goldenReference.dat text file, read twice as a stream so its length is not limited by memory, or the
+cosim trajectory linked in when no input is given. The file written is mapped back and validated.
+*/
+
+namespace
+{
+
+const char *statusName(TrajectoryStatus status)
+{
+	switch(status)
+	{
+		case TRAJECTORY_OK: return "ok";
+		case TRAJECTORY_OPEN_FAILED: return "cannot open";
+		case TRAJECTORY_BAD_MAGIC: return "not a trajectory file";
+		case TRAJECTORY_BAD_VERSION: return "unsupported version";
+		default: return "inconsistent sizes";
+	}
+}
+
+/*!
+@brief  Writes the text trajectory in path to out
+@return Number of samples, or -1
+*/
+long convertText(const char *path, const char *out)
+{
+	std::vector<float> x0;
+	const long samples = readGoldenReference(path, N, M, x0, [](long, const float*, const float*) { });
+
+	if(samples < 0)
+	{
+		std::cerr << "Cannot read trajectory from " << path << std::endl;
+		return -1;
+	}
+
+	TrajectoryWriter writer;
+
+	if(!writer.create(out, MPC_NAME_STR, samples, N, M, 0))
+	{
+		std::cerr << "Cannot write " << out << std::endl;
+		return -1;
+	}
+
+	readGoldenReference(path, N, M, x0, [&writer](long i, const float *u, const float *x)
+	{
+		std::copy(u, u + M, writer.u(i));
+		std::copy(x, x + N, writer.x(i));
+	});
+
+	std::copy(x0.begin(), x0.end(), writer.x0());
+	writer.close();
+
+	return samples;
+}
+
+/*!
+@brief  Writes the cosim trajectory to out
+@return Number of samples, or -1
+*/
+long convertCosim(const char *out)
+{
+	const TrajectoryView cosim = cosimTrajectory();
+	TrajectoryWriter writer;
+
+	if(!writer.create(out, MPC_NAME_STR, cosim.samples, N, M, P))
+	{
+		std::cerr << "Cannot write " << out << std::endl;
+		return -1;
+	}
+
+	std::copy(cosim.x0, cosim.x0 + N, writer.x0());
+	std::copy(cosim.u(0), cosim.u(cosim.samples), writer.u(0));
+	std::copy(cosim.x(0), cosim.x(cosim.samples), writer.x(0));
+	std::copy(cosim.yref(0), cosim.yref(cosim.samples), writer.yref(0));
+	writer.close();
+
+	return cosim.samples;
+}
+
+} // namespace
+
+/*!
+@brief  Usage: trajectory_generic_dense <output.mpct> [goldenReference.dat]
+*/
+int main(int argc, char **argv)
+{
+	if(argc < 2)
+	{
+		std::cerr << "Usage: " << argv[0] << " <output.mpct> [goldenReference.dat]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	const long samples = argc > 2 ? convertText(argv[2], argv[1]) : convertCosim(argv[1]);
+
+	if(samples < 0)
+	{
+		return EXIT_FAILURE;
+	}
+
+	TrajectoryFile file(argv[1]);
+
+	if(file.status() != TRAJECTORY_OK || file.view().samples != samples)
+	{
+		std::cerr << argv[1] << ": " << statusName(file.status()) << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	const TrajectoryView &view = file.view();
+
+	std::cout << "Wrote " << argv[1] << ", version " << MPC_TRAJECTORY_VERSION << ", " << view.samples << " samples, "
+		<< "N = " << view.N << ", M = " << view.M << ", P = " << view.P << ", "
+		<< sizeof(TrajectoryHeader) + trajectoryPayload(view.samples, view.N, view.M, view.P) * sizeof(float) << " bytes" << std::endl;
+
+	return EXIT_SUCCESS;
+}